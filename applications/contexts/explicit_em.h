@@ -17,6 +17,7 @@
 
 // Misc
 #include "../../core/utilities/log.h"
+#include "../../core/utilities/profiler.h"
 #include "../../core/utilities/pretty_stream.h"
 #include "../../core/physics/physical_constants.h"
 // Data IO
@@ -30,11 +31,13 @@
 // Particle
 #include "../../core/particle/particle_base.h"
 #include "../../core/particle/particle_factory.h"
+#include "../../core/particle/particle_subcycle.h"
 // Model
 #include "../../core/model/model.h"
 #include "../../core/model/geqdsk.h"
 #include "../../core/flow_control/context_base.h"
 #include "../../core/numeric/geometric_algorithm.h"
+#include "../../core/parallel/numa_placement.h"
 
 // Solver
 #include "../field_solver/pml.h"
@@ -120,6 +123,8 @@ public:
 
 	void next_timestep();
 
+	WorkLoad get_workload() const;
+
 	bool pre_process();
 
 	bool post_process();
@@ -190,6 +195,9 @@ private:
 
 	std::map<std::string, std::shared_ptr<ParticleBase>> particles_;
 
+	/// species with  SubCycle/SubSteps != 1
+	std::map<std::string, SubCycleFields<E_type, B_type, J_type>> subcycles_;
+
 }
 ;
 
@@ -374,6 +382,14 @@ void ExplicitEMContext<TM>::load(TDict const & dict)
 	dE.clear();
 	E0.clear();
 	Jext.clear();
+
+	VERBOSE << "Page placement of E1 : "
+			<< page_placement_to_string(E1.data().get(),
+					E1.size() * sizeof(typename decltype(E1)::value_type));
+	VERBOSE << "Page placement of B1 : "
+			<< page_placement_to_string(B1.data().get(),
+					B1.size() * sizeof(typename decltype(B1)::value_type));
+
 	GLOBAL_DATA_STREAM.cd("/Input/");
 
 	VERBOSE << SAVE(ne0);
@@ -407,6 +423,18 @@ void ExplicitEMContext<TM>::load(TDict const & dict)
 		{
 			particles_.emplace(id, p);
 
+			SubCycle cycle;
+
+			cycle.load(opt.second);
+
+			if (cycle.is_multi_rate())
+			{
+				LOGGER << "Particle [" << id << "] is pushed " << cycle.sub_steps
+						<< " times every " << cycle.every << " steps";
+
+				subcycles_.emplace(id,
+						SubCycleFields<E_type, B_type, J_type>(cycle, model));
+			}
 		}
 
 //		} catch (...)
@@ -581,6 +609,34 @@ bool ExplicitEMContext<TM>::post_process()
 {
 	return true;
 }
+/**
+ *  bytes: passes over E1,B1,J1,dE,dB in next_timestep(), i.e.
+ *  dE=f(B1,J1), E1+=dE, dB=f(E1), 2x B1+=dB, J1.clear()
+ */
+template<typename TM>
+ContextBase::WorkLoad ExplicitEMContext<TM>::get_workload() const
+{
+	WorkLoad res;
+
+	res.num_of_cells = NProduct(model.get_local_dimensions());
+
+	for (auto const & p : particles_)
+	{
+		auto it = subcycles_.find(p.first);
+
+		Real rate = (it == subcycles_.end()) ?
+				1.0 : it->second.cycle.pushes_per_step();
+
+		res.num_of_pushes += static_cast<size_t>(rate
+				* p.second->get_num_of_particles());
+	}
+
+	res.num_of_bytes = (2 * dE.size() + 3 * E1.size() + 5 * B1.size()
+			+ 2 * J1.size() + 3 * dB.size()) * sizeof(scalar_type);
+
+	return res;
+}
+
 template<typename TM>
 void ExplicitEMContext<TM>::next_timestep()
 {
@@ -596,19 +652,24 @@ void ExplicitEMContext<TM>::next_timestep()
 
 // Compute Cycle Begin
 
-	LOG_CMD(dE = (curl(B1) / mu0 - J1) / epsilon0 * dt);
+	// phases "field", "push <species>" are profiled as one timer each
+	{
+		PROFILE_SCOPE("field");
+
+		LOG_CMD(dE = (curl(B1) / mu0 - J1) / epsilon0 * dt);
 
 //   particle 1/2 -> 1  . To n[1/2], J[1/2]
 //	implicit_push_E.next_timestep(&dE);
 
-	LOG_CMD(E1 += dE);	// E(t=0 -> 1)
+		LOG_CMD(E1 += dE);	// E(t=0 -> 1)
 
-	ExcuteCommands(commandToE_);
+		ExcuteCommands(commandToE_);
 
-	LOG_CMD(dB = -curl(E1) * dt);
+		LOG_CMD(dB = -curl(E1) * dt);
 
-	LOG_CMD(B1 += dB * 0.5);	//	B(t=1/2 -> 1)
-	ExcuteCommands(commandToB_);
+		LOG_CMD(B1 += dB * 0.5);	//	B(t=1/2 -> 1)
+		ExcuteCommands(commandToB_);
+	}
 
 	J1.clear();
 
@@ -617,11 +678,41 @@ void ExplicitEMContext<TM>::next_timestep()
 	//   particle 0-> 1. Get J[1/2]
 	for (auto &p : particles_)
 	{
-		p.second->next_timestep();
+		PROFILE_SCOPE("push " + p.first);
+
+		auto it = subcycles_.find(p.first);
+
+		if (it == subcycles_.end())
+		{
+			p.second->next_timestep(dt);
+			continue;
+		}
+
+		auto & sub = it->second;
+
+		if (sub.cycle.every > 1)
+		{
+			sub.accumulate(E1, B1);
+		}
+
+		if (sub.cycle.is_due(model.get_clock()))
+		{
+			sub.push(*p.second, dt, &E1, &B1, &J1);
+		}
+	}
+
+	// current of the multi-rate species, held over their cycle
+	for (auto const &item : subcycles_)
+	{
+		LOG_CMD(J1 += *item.second.J);
 	}
 
-	LOG_CMD(B1 += dB * 0.5);	//  B(t=0 -> 1/2)
-	ExcuteCommands(commandToB_);
+	{
+		PROFILE_SCOPE("field");
+
+		LOG_CMD(B1 += dB * 0.5);	//  B(t=0 -> 1/2)
+		ExcuteCommands(commandToB_);
+	}
 // Compute Cycle End
 	model.next_timestep();
 
@@ -203,7 +203,7 @@ public:
 
 	void update_fields();
 
-	void next_timestep()
+	void next_timestep(Real dt)
 	{
 	}
 
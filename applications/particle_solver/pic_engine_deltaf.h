@@ -10,11 +10,13 @@
 
 #include <string>
 #include <tuple>
+#include <type_traits>
 
 #include "../../core/physics/physical_constants.h"
 #include "../../core/utilities/primitives.h"
 #include "../../core/utilities/ntuple.h"
 #include "../../core/particle/particle_engine.h"
+#include "../../core/particle/boris_kernel.h"
 namespace simpla
 {
 
@@ -42,10 +44,12 @@ struct ParticleEngine<PolicyPICDeltaF>
 			Real, f,
 			scalar_type, w)
 
+	/// charge_conserving: deposit J by Esirkepov's scheme in the per-cell push
 	SP_DEFINE_PROPERTIES(
 			Real, mass,
 			Real, charge,
-			Real, temperature
+			Real, temperature,
+			bool, charge_conserving
 	)
 
 	int J_at_the_center;
@@ -55,7 +59,7 @@ private:
 public:
 
 	ParticleEngine()
-			: mass(1.0), charge(1.0), temperature(1.0)
+			: mass(1.0), charge(1.0), temperature(1.0), charge_conserving(false)
 	{
 		update();
 	}
@@ -77,7 +81,7 @@ public:
 	}
 
 	template<typename TJ, typename TE, typename TB>
-	void next_timestep(Point_s * p, TJ* J, Real dt, TE const &fE, TB const & fB) const
+	void next_timestep(Point_s * p, Real dt, TJ* J, TE const &fE, TB const & fB) const
 	{
 		p->x += p->v * dt * 0.5;
 
@@ -90,12 +94,12 @@ public:
 
 		p->v += E * (cmr_ * dt * 0.5);
 
-		v_ = p->v + Cross(p->v, t);
+		v_ = p->v + cross(p->v, t);
 
-		v_ = Cross(v_, t) / (Dot(t, t) + 1.0);
+		v_ = cross(v_, t) / (dot(t, t) + 1.0);
 
 		p->v += v_;
-		auto a = (-Dot(E, p->v) * q_kT_ * dt);
+		auto a = (-dot(E, p->v) * q_kT_ * dt);
 		p->w = (-a + (1 + 0.5 * a) * p->w) / (1 - 0.5 * a);
 
 		p->v += v_;
@@ -103,10 +107,143 @@ public:
 
 		p->x += p->v * dt * 0.5;
 
-		J->scatter_cartesian(std::forward_as_tuple(p->x, p->v, p->f * charge * p->w));
+		J->scatter(p->x, p->v, p->f * charge * p->w);
 
 	}
 
+	/**
+	 *  \brief push particles [ib,ie) of one cell.
+	 *
+	 *  E,B stencils of the cell are gathered once, the Boris rotation runs
+	 *  over chunks of particles, and J is accumulated into one cell stencil
+	 *  which is added to J at the end. Particles which leave the cell during
+	 *  the push use the per-particle gather/scatter.
+	 *  If charge_conserving, J is deposited from the old and new positions
+	 *  (Esirkepov) with the new weight, J and the charge of the new weight
+	 *  satisfy the discrete continuity equation, the change of the weight is
+	 *  the delta-f source. It writes  cells -1..2 around the cell, so cells
+	 *  pushed concurrently must be at least 4 cells apart
+	 *  (parallel_for_colored).
+	 *
+	 *  \note  TJ,TE,TB are fields on the same manifold
+	 */
+	template<typename TIterator, typename TJ, typename TE, typename TB>
+	void next_timestep(TIterator ib, TIterator ie, Real dt, TJ* J, TE const &fE, TB const & fB) const
+	{
+		if (ib == ie)
+		{
+			return;
+		}
+
+		auto const & mesh = fE.domain().manifold();
+
+		typedef typename std::remove_const<typename std::remove_reference<decltype(mesh)>::type>::type mesh_type;
+
+		auto s = std::get<0>(mesh.coordinates_global_to_local(ib->x, 0UL));
+
+		typename mesh_type::template cell_stencil_type<TE> E_st;
+		typename mesh_type::template cell_stencil_type<TB> B_st;
+		typename mesh_type::template cell_stencil_type<TJ> J_st;
+
+		mesh.gather_cell(fE, s, &E_st);
+		mesh.gather_cell(fB, s, &B_st);
+		J_st.clear();
+
+		static constexpr size_t CHUNK_SIZE = 64;
+
+		Point_s * p[CHUNK_SIZE];
+		Vec3 x0[CHUNK_SIZE];
+		BorisBatch<CHUNK_SIZE> batch;
+
+		Real cmr_dt = cmr_ * dt * 0.5;
+
+		while (ib != ie)
+		{
+			size_t num = 0;
+
+			for (; ib != ie && num < CHUNK_SIZE; ++ib, ++num)
+			{
+				p[num] = &(*ib);
+			}
+
+			// gather
+			for (size_t i = 0; i < num; ++i)
+			{
+				x0[i] = p[i]->x;
+
+				p[i]->x += p[i]->v * dt * 0.5;
+
+				auto idx = mesh.coordinates_global_to_local(p[i]->x, 0UL);
+
+				Vec3 E, B;
+
+				if (std::get<0>(idx) == s)
+				{
+					E = mesh.gather_in_cell(E_st, std::get<1>(idx));
+					B = mesh.gather_in_cell(B_st, std::get<1>(idx));
+				}
+				else
+				{
+					E = fE(p[i]->x);
+					B = fB(p[i]->x);
+				}
+
+				batch.Ex[i] = E[0];
+				batch.Ey[i] = E[1];
+				batch.Ez[i] = E[2];
+				batch.Bx[i] = B[0];
+				batch.By[i] = B[1];
+				batch.Bz[i] = B[2];
+				batch.vx[i] = p[i]->v[0];
+				batch.vy[i] = p[i]->v[1];
+				batch.vz[i] = p[i]->v[2];
+				batch.w[i] = p[i]->w;
+			}
+
+			// Boris rotation
+			boris_push<BorisWeightDeltaF>(num, cmr_dt, q_kT_ * dt, &batch);
+
+			for (size_t i = 0; i < num; ++i)
+			{
+				p[i]->v[0] = batch.vx[i];
+				p[i]->v[1] = batch.vy[i];
+				p[i]->v[2] = batch.vz[i];
+				p[i]->w = batch.w[i];
+
+				p[i]->x += p[i]->v * dt * 0.5;
+			}
+
+			// scatter
+			if (charge_conserving)
+			{
+				for (size_t i = 0; i < num; ++i)
+				{
+					mesh.scatter_esirkepov(*J, x0[i], p[i]->x, p[i]->f * charge * p[i]->w, dt);
+				}
+
+				continue;
+			}
+
+			for (size_t i = 0; i < num; ++i)
+			{
+				auto idx = mesh.coordinates_global_to_local(p[i]->x, 0UL);
+
+				Real w = p[i]->f * charge * p[i]->w;
+
+				if (std::get<0>(idx) == s)
+				{
+					mesh.scatter_in_cell(&J_st, std::get<1>(idx), p[i]->v * w);
+				}
+				else
+				{
+					J->scatter(p[i]->x, p[i]->v, w);
+				}
+			}
+		}
+
+		mesh.scatter_cell(*J, s, J_st);
+	}
+
 	static inline Point_s push_forward(coordinates_type const & x, Vec3 const &v, scalar_type f)
 	{
 		return std::move(Point_s( { x, v, f }));
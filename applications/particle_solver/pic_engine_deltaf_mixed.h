@@ -0,0 +1,177 @@
+/**
+ * \file pic_engine_deltaf_mixed.h
+ *
+ * \date    2014年11月11日  下午3:12:08
+ * \author salmon
+ */
+
+#ifndef PIC_ENGINE_DELTAF_MIXED_H_
+#define PIC_ENGINE_DELTAF_MIXED_H_
+
+#include <string>
+#include <tuple>
+#include <type_traits>
+
+#include "../../core/physics/physical_constants.h"
+#include "../../core/utilities/primitives.h"
+#include "../../core/utilities/ntuple.h"
+#include "../../core/particle/particle_engine.h"
+namespace simpla
+{
+
+template<typename Policy> class ParticleEngine;
+class PolicyPICDeltaFMixed;
+
+typedef ParticleEngine<PolicyPICDeltaFMixed> PICDeltaFMixed;
+
+/**
+ * \ingroup ParticleEngine
+ * \brief \f$\delta f\f$ engine, mixed precision storage
+ *
+ *  Point_s stores the compact index 's' of the cell and the cell-relative
+ *  offset  \f$ x\in[0,1)^3\f$ in float, v,f,w are float too, so a particle
+ *  takes 40 bytes instead of 64 bytes of PICDeltaF. Push and the deposition
+ *  of J are done in double, only the stored state is rounded.
+ *
+ *  The cell index 's' is the key of the particle in the container
+ *  (KineticParticle uses it directly), push_forward/pull_back convert
+ *  to/from global coordinates and need the mesh, loaders call them by
+ *  engine_push_forward/engine_pull_back. push_forward sets w=0.
+ */
+template<>
+struct ParticleEngine<PolicyPICDeltaFMixed>
+{
+	typedef ParticleEngine<PolicyPICDeltaFMixed> this_type;
+	typedef Vec3 coordinates_type;
+	typedef Vec3 vector_type;
+	typedef Real scalar_type;
+
+	typedef float storage_type;
+
+	typedef nTuple<storage_type, 3> storage_vector_type;
+
+	SP_DEFINE_POINT_STRUCT(Point_s,
+			unsigned long, s,
+			storage_vector_type ,x,
+			storage_vector_type, v,
+			storage_type, f,
+			storage_type, w)
+
+	SP_DEFINE_PROPERTIES(
+			Real, mass,
+			Real, charge,
+			Real, temperature
+	)
+
+	int J_at_the_center;
+
+private:
+	Real cmr_, q_kT_;
+public:
+
+	ParticleEngine()
+			: mass(1.0), charge(1.0), temperature(1.0)
+	{
+		update();
+	}
+
+	void update()
+	{
+		DEFINE_PHYSICAL_CONST
+		cmr_ = charge / mass;
+		q_kT_ = charge / (temperature * boltzmann_constant);
+	}
+
+	~ParticleEngine()
+	{
+	}
+
+	static std::string get_type_as_string()
+	{
+		return "DeltaFMixed";
+	}
+
+	template<typename TJ, typename TE, typename TB>
+	void next_timestep(Point_s * p, Real dt, TJ* J, TE const &fE, TB const & fB) const
+	{
+		auto const & mesh = fE.domain().manifold();
+
+		Vec3 x, v, r;
+
+		r = p->x;
+
+		v = p->v;
+
+		x = mesh.coordinates_local_to_global(p->s, r);
+
+		Real w = p->w;
+
+		x += v * dt * 0.5;
+
+		auto B = fB(x);
+		auto E = fE(x);
+
+		Vec3 v_;
+
+		auto t = B * (cmr_ * dt * 0.5);
+
+		v += E * (cmr_ * dt * 0.5);
+
+		v_ = v + cross(v, t);
+
+		v_ = cross(v_, t) / (dot(t, t) + 1.0);
+
+		v += v_;
+		auto a = (-dot(E, v) * q_kT_ * dt);
+		w = (-a + (1 + 0.5 * a) * w) / (1 - 0.5 * a);
+
+		v += v_;
+		v += E * (cmr_ * dt * 0.5);
+
+		x += v * dt * 0.5;
+
+		J->scatter(x, v, p->f * charge * w);
+
+		std::tie(p->s, r) = mesh.coordinates_global_to_local(x, 0UL);
+
+		p->x = r;
+		p->v = v;
+		p->w = static_cast<storage_type>(w);
+	}
+
+	template<typename TM>
+	static inline Point_s push_forward(TM const & mesh, coordinates_type const & x, Vec3 const &v,
+			scalar_type f)
+	{
+		Point_s p;
+
+		Vec3 r;
+
+		std::tie(p.s, r) = mesh.coordinates_global_to_local(x, 0UL);
+
+		p.x = r;
+		p.v = v;
+		p.f = static_cast<storage_type>(f);
+		p.w = 0;
+
+		return std::move(p);
+	}
+
+	template<typename TM>
+	static inline std::tuple<coordinates_type, Vec3, scalar_type> pull_back(TM const & mesh,
+			Point_s const & p)
+	{
+		Vec3 r, v;
+
+		r = p.x;
+		v = p.v;
+
+		return std::make_tuple(mesh.coordinates_local_to_global(p.s, r), v,
+				static_cast<scalar_type>(p.f));
+	}
+
+};
+
+} // namespace simpla
+
+#endif /* PIC_ENGINE_DELTAF_MIXED_H_ */
@@ -10,8 +10,10 @@
 
 #include <string>
 #include <tuple>
-#include "../../src/utilities/data_type.h"
-#include "../../src/utilities/primitives.h"
+#include "../../core/utilities/data_type.h"
+#include "../../core/utilities/primitives.h"
+#include "../../core/utilities/ntuple.h"
+#include "../../core/particle/boris_kernel.h"
 
 namespace simpla
 {
@@ -106,9 +108,9 @@ public:
 
 		p->v += E * (cmr_ * dt * 0.5);
 
-		v_ = p->v + Cross(p->v, t);
+		v_ = p->v + cross(p->v, t);
 
-		v_ = Cross(v_, t) / (Dot(t, t) + 1.0);
+		v_ = cross(v_, t) / (dot(t, t) + 1.0);
 
 		p->v += v_ * 2.0;
 
@@ -117,16 +119,69 @@ public:
 		p->x += p->v * dt * 0.5;
 	}
 
+	/**
+	 *  \brief push particles [ib,ie), velocities are updated by boris_push
+	 *         in chunks of CHUNK_SIZE
+	 */
+	template<typename TIterator, typename TE, typename TB>
+	void next_timestep(TIterator ib, TIterator ie, Real dt, TE const &fE, TB const & fB) const
+	{
+		static constexpr size_t CHUNK_SIZE = 64;
+
+		Point_s * p[CHUNK_SIZE];
+
+		BorisBatch<CHUNK_SIZE> batch;
+
+		while (ib != ie)
+		{
+			size_t num = 0;
+
+			for (; ib != ie && num < CHUNK_SIZE; ++ib, ++num)
+			{
+				p[num] = &(*ib);
+			}
+
+			for (size_t i = 0; i < num; ++i)
+			{
+				p[i]->x += p[i]->v * dt * 0.5;
+
+				auto E = fE(p[i]->x);
+				auto B = fB(p[i]->x);
+
+				batch.Ex[i] = E[0];
+				batch.Ey[i] = E[1];
+				batch.Ez[i] = E[2];
+				batch.Bx[i] = B[0];
+				batch.By[i] = B[1];
+				batch.Bz[i] = B[2];
+				batch.vx[i] = p[i]->v[0];
+				batch.vy[i] = p[i]->v[1];
+				batch.vz[i] = p[i]->v[2];
+			}
+
+			boris_push<BorisWeightNone>(num, cmr_ * dt * 0.5, 0, &batch);
+
+			for (size_t i = 0; i < num; ++i)
+			{
+				p[i]->v[0] = batch.vx[i];
+				p[i]->v[1] = batch.vy[i];
+				p[i]->v[2] = batch.vz[i];
+
+				p[i]->x += p[i]->v * dt * 0.5;
+			}
+		}
+	}
+
 	template<typename TJ>
 	void ScatterJ(Point_s const & p, TJ * J) const
 	{
-		J->scatter_cartesian(std::make_tuple(p.x, p.v), p.f * q_);
+		J->scatter(p.x, p.v, p.f * q_);
 	}
 
 	template<typename TJ>
 	void ScatterRho(Point_s const & p, TJ * rho) const
 	{
-		rho->scatter_cartesian(std::make_tuple(p.x, 1.0), p.f * q_);
+		rho->scatter(p.x, 1.0, p.f * q_);
 	}
 
 	static inline Point_s push_forward(coordinates_type const & x, vector_type const &v, scalar_type f)
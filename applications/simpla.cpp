@@ -5,29 +5,259 @@
  *      \author  salmon
  */
 
+#include <chrono>
+#include <fstream>
 #include <functional>
 #include <iomanip>
 #include <iostream>
+#include <map>
 #include <memory>
+#include <sstream>
 #include <string>
 
 #include "../core/io/data_stream.h"
 #include "../core/simpla_defs.h"
 #include "../core/utilities/log.h"
 #include "../core/utilities/lua_state.h"
+#include "../core/utilities/memory_pool.h"
+#include "../core/utilities/ntuple.h"
 #include "../core/utilities/parse_command_line.h"
+#include "../core/utilities/perf_counter.h"
+#include "../core/utilities/profiler.h"
 #include "../core/utilities/utilities.h"
 #include "../core/parallel/message_comm.h"
+#include "../core/parallel/mpi_aux_functions.h"
 
 #include "contexts/context_factory.h"
 
 using namespace simpla;
 
+/**
+ *  benchmark mode:  'num_of_warmup' untimed steps, then 'num_of_step'
+ *  timed steps, nothing is saved.  Reports steps/s, cell updates/s,
+ *  particle pushes/s, bytes per cell update (ContextBase::get_workload)
+ *  and the time per step of each phase of next_timestep (PROFILE_SCOPE),
+ *  as JSON to 'output' if it is not empty.
+ *
+ *  \return false if steps/s < min_steps_per_second
+ */
+bool run_benchmark(ContextBase * ctx, std::size_t num_of_warmup,
+		std::size_t num_of_step, double min_steps_per_second,
+		std::string const & output)
+{
+	LOGGER << "Benchmark: warm up " << num_of_warmup << " steps";
+
+	for (std::size_t i = 0; i < num_of_warmup; ++i)
+	{
+		ctx->next_timestep();
+	}
+
+	PROFILER.clear();
+
+	LOGGER << "Benchmark: measure " << num_of_step << " steps";
+
+	GLOBAL_COMM.barrier();
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	for (std::size_t i = 0; i < num_of_step; ++i)
+	{
+		{
+			PROFILE_SCOPE("next_timestep");
+
+			ctx->next_timestep();
+		}
+
+		PROFILER.end_step();
+	}
+
+	GLOBAL_COMM.barrier();
+
+	double elapsed = std::chrono::duration<double>(
+			std::chrono::high_resolution_clock::now() - start).count();
+
+	auto work = ctx->get_workload();
+
+	double num_of_cells = work.num_of_cells;
+	double num_of_pushes = work.num_of_pushes;
+	double num_of_bytes = work.num_of_bytes;
+
+	if (GLOBAL_COMM.get_size() > 1)
+	{
+		elapsed = allreduce(elapsed, "Max");
+		num_of_cells = allreduce(num_of_cells);
+		num_of_pushes = allreduce(num_of_pushes);
+		num_of_bytes = allreduce(num_of_bytes);
+	}
+
+	double steps = static_cast<double>(num_of_step);
+
+	double steps_per_second = (elapsed > 0) ? steps / elapsed : 0;
+
+	double bytes_per_cell = (num_of_cells > 0) ? num_of_bytes / num_of_cells : 0;
+
+	// phases are the timers directly below "next_timestep",  of rank 0
+	std::map<std::string, double> phases;
+
+	std::string prefix = "next_timestep/";
+
+	for (auto const & item : PROFILER.records())
+	{
+		auto const & name = item.first;
+
+		if (name.compare(0, prefix.size(), prefix) == 0
+				&& name.find('/', prefix.size()) == std::string::npos)
+		{
+			phases[name.substr(prefix.size())] = item.second.total / steps;
+		}
+	}
+
+	INFORM << "Benchmark: " << num_of_step << " steps in " << elapsed << "[s]"
+			<< std::endl
+
+			<< "   steps/s              = " << steps_per_second << std::endl
+
+			<< "   cell updates/s       = " << num_of_cells * steps_per_second
+			<< std::endl
+
+			<< "   particle pushes/s    = " << num_of_pushes * steps_per_second
+			<< std::endl
+
+			<< "   bytes per cell update= " << bytes_per_cell;
+
+	for (auto const & item : phases)
+	{
+		INFORM << "   " << std::setw(24) << std::left << item.first
+				<< " : " << item.second << "[s/step]";
+	}
+
+	if (output != "" && GLOBAL_COMM.get_rank() == 0)
+	{
+		std::ofstream os(output);
+
+		os << "{" << std::endl
+
+		<< "\"identify\":\"" << IDENTIFY << "\"," << std::endl
+
+		<< "\"num_of_process\":" << GLOBAL_COMM.get_size() << "," << std::endl
+
+		<< "\"num_of_threads\":" << GLOBAL_COMM.get_num_of_threads() << ","
+				<< std::endl
+
+				<< "\"warmup\":" << num_of_warmup << "," << std::endl
+
+				<< "\"steps\":" << num_of_step << "," << std::endl
+
+				<< "\"time\":" << elapsed << "," << std::endl
+
+				<< "\"steps_per_second\":" << steps_per_second << ","
+				<< std::endl
+
+				<< "\"cell_updates_per_second\":"
+				<< num_of_cells * steps_per_second << "," << std::endl
+
+				<< "\"pushes_per_second\":" << num_of_pushes * steps_per_second
+				<< "," << std::endl
+
+				<< "\"bytes_per_cell_update\":" << bytes_per_cell << ","
+				<< std::endl
+
+				<< "\"phases\":{";
+
+		for (auto it = phases.begin(); it != phases.end(); ++it)
+		{
+			os << (it == phases.begin() ? "" : ",") << std::endl << "  \""
+					<< it->first << "\":" << it->second;
+		}
+
+		os << std::endl << "}" << std::endl << "}" << std::endl;
+	}
+
+	if (min_steps_per_second > 0 && steps_per_second < min_steps_per_second)
+	{
+		WARNING << "Benchmark: " << steps_per_second
+				<< " steps/s is below the threshold " << min_steps_per_second;
+
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ *  collective, write the hardware counters (--perf_counters) of every
+ *  profiler path to dataset 'name' of the HDF5 output.
+ *
+ *  The dataset is [num_of_process * num_of_paths][2 + PerfCounter::NUM_OF_EVENTS],
+ *  row  rank * num_of_paths + i  holds  calls, seconds and the counts of
+ *  path i on 'rank';  counts of unavailable counters are -1.  Attribute
+ *  "paths" lists the paths (one per line),  "columns" names the columns.
+ */
+std::string save_perf_counters(std::string const & name)
+{
+	auto paths = PROFILER.paths();
+
+	if (paths.size() == 0)
+	{
+		return "";
+	}
+
+	const int num_of_events = PerfCounter::NUM_OF_EVENTS;
+
+	std::vector<nTuple<Real, 2 + num_of_events>> data(paths.size());
+
+	for (size_t i = 0; i < paths.size(); ++i)
+	{
+		data[i] = -1;
+
+		auto it = PROFILER.records().find(paths[i]);
+
+		data[i][0] = (it == PROFILER.records().end()) ? 0 : it->second.count;
+
+		data[i][1] = (it == PROFILER.records().end()) ? 0 : it->second.total;
+
+		for (int n = 0; n < num_of_events; ++n)
+		{
+			if (PERF_COUNTER.is_available(n))
+			{
+				data[i][2 + n] =
+						(it == PROFILER.records().end()) ?
+								0 : it->second.counters[n];
+			}
+		}
+	}
+
+	std::string url = save(name, data, DataStream::SP_UNORDER);
+
+	std::string str_paths = "";
+
+	for (auto const & p : paths)
+	{
+		str_paths += p + "\n";
+	}
+
+	std::string columns = "calls,seconds";
+
+	for (int n = 0; n < num_of_events; ++n)
+	{
+		columns += "," + PerfCounter::name(n);
+	}
+
+	GLOBAL_DATA_STREAM.set_attribute(url + ".paths", str_paths);
+
+	GLOBAL_DATA_STREAM.set_attribute(url + ".columns", columns);
+
+	return url;
+}
+
 int main(int argc, char **argv)
 {
 
 	LOGGER.init(argc, argv);
 	GLOBAL_COMM.init(argc,argv);
+	PROFILER.init(argc, argv);
+	PERF_COUNTER.init(argc, argv);
+	MEMPOOL.init(argc, argv);
 	GLOBAL_DATA_STREAM.init(argc,argv);
 	GLOBAL_DATA_STREAM.cd("/");
 	LOGGER << "Register contexts." << std::endl;
@@ -44,6 +274,14 @@ int main(int argc, char **argv)
 
 	bool just_a_test = false;
 
+	bool is_benchmark = false;
+
+	std::size_t num_of_warmup = 2;
+
+	double min_steps_per_second = 0;
+
+	std::string benchmark_output = "";
+
 	ParseCmdLine(argc, argv,
 			[&](std::string const & opt,std::string const & value)->int
 			{
@@ -78,6 +316,19 @@ int main(int argc, char **argv)
 				{
 					just_a_test=true;
 				}
+				else if(opt=="benchmark")
+				{
+					is_benchmark=true;
+					benchmark_output=value;
+				}
+				else if(opt=="warmup")
+				{
+					num_of_warmup =ToValue<std::size_t >(value);
+				}
+				else if(opt=="min_steps_per_second")
+				{
+					min_steps_per_second =ToValue<double>(value);
+				}
 				else if(opt=="V")
 				{
 					INFORM<<ShowShortVersion()<< std::endl;
@@ -161,7 +412,10 @@ int main(int argc, char **argv)
 		}
 		else
 		{
-			ctx->save("/Input/");
+			if (!is_benchmark)
+			{
+				ctx->save("/Input/");
+			}
 			INFORM << std::endl << *ctx;
 		}
 	}
@@ -172,10 +426,17 @@ int main(int argc, char **argv)
 
 	TheStart();
 
+	bool is_regression = false;
+
 	if (just_a_test)
 	{
 		LOGGER << "Just test configure files";
 	}
+	else if (is_benchmark)
+	{
+		is_regression = !run_benchmark(ctx.get(), num_of_warmup, num_of_step,
+				min_steps_per_second, benchmark_output);
+	}
 	else
 	{
 		GLOBAL_DATA_STREAM.properties("Cache Depth", 20u);
@@ -188,12 +449,20 @@ int main(int argc, char **argv)
 		{
 			LOGGER << "STEP: " << i;
 
-			ctx->next_timestep();
+			{
+				PROFILE_SCOPE("next_timestep");
+
+				ctx->next_timestep();
+			}
 
 			if (i % record_stride == 0)
 			{
+				PROFILE_SCOPE("save");
+
 				ctx->save("/Save/" );
 			}
+
+			PROFILER.end_step();
 		}
 		GLOBAL_DATA_STREAM.command("Flush");
 		GLOBAL_DATA_STREAM.properties("Force Write Cache",false);
@@ -205,15 +474,58 @@ int main(int argc, char **argv)
 
 	LOGGER << "Post-Process" << START;
 
-	ctx->save("/OutPut/");
+	if (!is_benchmark)
+	{
+		ctx->save("/OutPut/");
+
+		INFORM << "OutPut Path:" << GLOBAL_DATA_STREAM.pwd();
+	}
 
-	INFORM << "OutPut Path:" << GLOBAL_DATA_STREAM.pwd();
+	bool has_counters = PERF_COUNTER.is_enabled();
+
+	// counters may fail to open on some ranks only
+	if (GLOBAL_COMM.get_size() > 1)
+	{
+		has_counters = allreduce(has_counters ? 1 : 0, "Max") > 0;
+	}
+
+	if (has_counters && !is_benchmark)
+	{
+		INFORM << "Performance counters:"
+				<< save_perf_counters("/Profile/perf_counters");
+	}
 
 	LOGGER << "Post-Process" << DONE;
 
+	INFORM << SINGLELINE;
+
+	{
+		std::ostringstream os;
+
+		PROFILER.report(os);
+
+		INFORM << "Profile:" << std::endl << os.str();
+	}
+
+	if (has_counters)
+	{
+		std::ostringstream os;
+
+		PROFILER.report_counters(os);
+
+		INFORM << "Performance counters (sum over ranks):" << std::endl
+				<< os.str();
+	}
+
 	INFORM << SINGLELINE;
 	GLOBAL_DATA_STREAM.close();
 	GLOBAL_COMM.close();
+
+	if (is_regression)
+	{
+		return 1;
+	}
+
 	TheEnd();
 
 }
@@ -0,0 +1,365 @@
+/**
+ * \file bench.h
+ *
+ * \date    2014年11月17日  上午9:20:12
+ * \author salmon
+ */
+
+#ifndef BENCH_H_
+#define BENCH_H_
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../core/simpla_defs.h"
+#include "../core/utilities/log.h"
+#include "../core/utilities/ntuple.h"
+#include "../core/utilities/parse_command_line.h"
+#include "../core/utilities/utilities.h"
+#include "../core/parallel/message_comm.h"
+#include "../core/parallel/mpi_aux_functions.h"
+
+/**
+ *  \defgroup Benchmark Benchmark
+ *  \brief  micro benchmarks of kernels, results are written as JSON
+ */
+namespace simpla
+{
+
+/**
+ *  \ingroup Benchmark
+ *  \brief  timing of one kernel
+ *
+ *   time is the  wall time of one call, max over ranks, 'work' is the
+ *   number of 'unit' processed by one call, summed over ranks.
+ */
+struct BenchRecord
+{
+	std::string name;
+
+	std::vector<std::pair<std::string, std::string>> tags; //!< JSON values
+
+	size_t repeat = 0;
+
+	double min = 0, avg = 0, max = 0;
+
+	double work = 0;
+
+	std::string unit;
+
+	double bytes = 0; //!< estimated memory traffic of one call
+
+	template<typename T>
+	BenchRecord & tag(std::string const & key, T const & v)
+	{
+		std::ostringstream os;
+		os << v;
+		tags.emplace_back(key, os.str());
+		return *this;
+	}
+
+	BenchRecord & tag(std::string const & key, std::string const & v)
+	{
+		tags.emplace_back(key, "\"" + v + "\"");
+		return *this;
+	}
+
+	BenchRecord & tag(std::string const & key, char const * v)
+	{
+		return tag(key, std::string(v));
+	}
+
+	template<typename T, size_t N>
+	BenchRecord & tag(std::string const & key, nTuple<T, N> const & v)
+	{
+		std::ostringstream os;
+
+		os << "[";
+
+		for (size_t i = 0; i < N; ++i)
+		{
+			os << (i == 0 ? "" : ",") << v[i];
+		}
+
+		os << "]";
+
+		tags.emplace_back(key, os.str());
+
+		return *this;
+	}
+};
+
+/**
+ *  \ingroup Benchmark
+ *  \brief  runs kernels, collects BenchRecord and writes them as JSON
+ *
+ *   Options:
+ *   - --warmup <n>     untimed calls before measuring, default 2
+ *   - --repeat <n>     timed calls, default 10
+ *   - --output <file>  JSON file, default stdout
+ *
+ *   other options are passed to the option function of init().
+ *
+ *  \code
+ *   { "benchmark":"bench_fetl", "identify":"...", "num_of_process":1,
+ *     "num_of_threads":4, "results":[ { "name":"curl1", "dims":[64,64,64],
+ *     "repeat":10, "time_min":..., "time_avg":..., "time_max":...,
+ *     "work":262144, "unit":"cells", "rate":..., "bandwidth":... }, ... ] }
+ *  \endcode
+ */
+class Benchmark
+{
+public:
+
+	size_t warmup = 2;
+
+	size_t repeat = 10;
+
+	std::string output = "";
+
+	Benchmark(std::string const & name) :
+			name_(name)
+	{
+	}
+
+	~Benchmark()
+	{
+	}
+
+	void init(int argc, char** argv,
+			std::function<int(std::string const &, std::string const &)> const & options =
+					nullptr)
+	{
+		GLOBAL_COMM.init(argc, argv);
+
+		ParseCmdLine(argc, argv,
+				[&](std::string const & opt,std::string const & value)->int
+				{
+					if(opt=="warmup")
+					{
+						warmup =ToValue<size_t>(value);
+					}
+					else if(opt=="repeat")
+					{
+						repeat =std::max(ToValue<size_t>(value),static_cast<size_t>(1));
+					}
+					else if(opt=="output")
+					{
+						output =value;
+					}
+					else if(options)
+					{
+						return options(opt,value);
+					}
+					return CONTINUE;
+				});
+	}
+
+	/**
+	 *  time 'fun', 'prepare' is called before every call and is not timed
+	 *
+	 * @param work  'unit' processed by one call on this rank
+	 */
+	BenchRecord & run(std::string const & name, double work,
+			std::string const & unit, std::function<void()> const & fun,
+			std::function<void()> const & prepare = nullptr)
+	{
+		for (size_t n = 0; n < warmup; ++n)
+		{
+			if (prepare)
+				prepare();
+			fun();
+		}
+
+		std::vector<double> t(repeat);
+
+		for (size_t n = 0; n < repeat; ++n)
+		{
+			if (prepare)
+				prepare();
+
+			GLOBAL_COMM.barrier();
+
+			auto start = std::chrono::high_resolution_clock::now();
+
+			fun();
+
+			t[n] = std::chrono::duration<double>(
+					std::chrono::high_resolution_clock::now() - start).count();
+		}
+
+		if (GLOBAL_COMM.get_size() > 1)
+		{
+			std::vector<double> recv(repeat);
+
+			allreduce(&t[0], &recv[0], repeat, "Max");
+
+			t.swap(recv);
+
+			work = allreduce(work);
+		}
+
+		records_.emplace_back();
+
+		BenchRecord & res = records_.back();
+
+		res.name = name;
+		res.repeat = repeat;
+		res.work = work;
+		res.unit = unit;
+		res.min = *std::min_element(t.begin(), t.end());
+		res.max = *std::max_element(t.begin(), t.end());
+		res.avg = 0;
+
+		for (auto v : t)
+		{
+			res.avg += v;
+		}
+
+		res.avg /= static_cast<double>(repeat);
+
+		VERBOSE << name_ << ": " << name << " " << res.work / res.min << " "
+				<< unit << "/s";
+
+		return res;
+	}
+
+	std::vector<BenchRecord> const & records() const
+	{
+		return records_;
+	}
+
+	std::ostream & print(std::ostream & os) const
+	{
+		os << "{" << std::endl
+
+		<< "\"benchmark\":\"" << name_ << "\"," << std::endl
+
+		<< "\"identify\":\"" << IDENTIFY << "\"," << std::endl
+
+		<< "\"num_of_process\":" << GLOBAL_COMM.get_size() << "," << std::endl
+
+		<< "\"num_of_threads\":" << GLOBAL_COMM.get_num_of_threads() << ","
+				<< std::endl
+
+				<< "\"warmup\":" << warmup << "," << std::endl
+
+				<< "\"results\":[";
+
+		for (auto it = records_.begin(); it != records_.end(); ++it)
+		{
+			auto const & r = *it;
+
+			os << (it == records_.begin() ? "" : ",") << std::endl
+
+			<< "{ \"name\":\"" << r.name << "\"";
+
+			for (auto const & item : r.tags)
+			{
+				os << ", \"" << item.first << "\":" << item.second;
+			}
+
+			os << ", \"repeat\":" << r.repeat
+
+			<< ", \"time_min\":" << r.min
+
+			<< ", \"time_avg\":" << r.avg
+
+			<< ", \"time_max\":" << r.max
+
+			<< ", \"work\":" << r.work
+
+			<< ", \"unit\":\"" << r.unit << "\""
+
+			<< ", \"rate\":" << (r.min > 0 ? r.work / r.min : 0);
+
+			if (r.bytes > 0)
+			{
+				os << ", \"bytes\":" << r.bytes << ", \"bandwidth\":"
+						<< (r.min > 0 ? r.bytes / r.min : 0);
+			}
+
+			os << " }";
+		}
+
+		os << std::endl << "]" << std::endl << "}" << std::endl;
+
+		return os;
+	}
+
+	/// rank 0 writes the JSON report to 'output' or stdout
+	void write() const
+	{
+		if (GLOBAL_COMM.get_rank() != 0)
+			return;
+
+		if (output == "")
+		{
+			print(std::cout);
+		}
+		else
+		{
+			std::ofstream fs(output);
+
+			if (!fs.good())
+			{
+				RUNTIME_ERROR("Can not open benchmark output " + output);
+			}
+
+			print(fs);
+		}
+	}
+
+private:
+
+	std::string name_;
+
+	std::vector<BenchRecord> records_;
+};
+
+/**
+ *  \ingroup Benchmark
+ *  \brief  parse mesh size  "64", "64,32,16" or "64x32x16"
+ */
+inline nTuple<size_t, 3> parse_dims(std::string const & str)
+{
+	nTuple<size_t, 3> res;
+
+	std::string s = str;
+
+	std::replace(s.begin(), s.end(), ',', ' ');
+
+	std::replace(s.begin(), s.end(), 'x', ' ');
+
+	std::istringstream is(s);
+
+	size_t n = 0;
+
+	for (; n < 3 && (is >> res[n]); ++n)
+	{
+	}
+
+	if (n == 0)
+	{
+		RUNTIME_ERROR("Illegal mesh size " + str);
+	}
+
+	for (; n < 3; ++n)
+	{
+		res[n] = res[n - 1];
+	}
+
+	return res;
+}
+
+}  // namespace simpla
+
+#endif /* BENCH_H_ */
@@ -0,0 +1,135 @@
+/**
+ * \file bench_fetl.cpp
+ *
+ * \date    2014年11月17日  上午10:02:37
+ * \author salmon
+ *
+ *  throughput of the vector calculus operators on the Cartesian structured
+ *  mesh.
+ *
+ *  usage: bench_fetl [--dims 64,64,64]... [--repeat 10] [--output fetl.json]
+ */
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+
+#include "../core/utilities/ntuple.h"
+#include "../core/utilities/primitives.h"
+#include "../core/field/field.h"
+#include "../core/manifold/manifold.h"
+#include "../core/manifold/domain.h"
+#include "../core/manifold/geometry/cartesian.h"
+#include "../core/manifold/topology/structured.h"
+#include "../core/manifold/diff_scheme/fdm.h"
+#include "../core/manifold/interpolator/interpolator.h"
+
+using namespace simpla;
+
+typedef Manifold<CartesianCoordinates<StructuredMesh, CARTESIAN_ZAXIS>,
+		FiniteDiffMethod, InterpolatorLinear> mesh_type;
+
+void bench_fetl(Benchmark & bench, nTuple<size_t, 3> const & dims)
+{
+	nTuple<Real, 3> xmin = { 0, 0, 0 };
+	nTuple<Real, 3> xmax = { 1, 1, 1 };
+	nTuple<Real, 3> k = { TWOPI, TWOPI, TWOPI };
+
+	mesh_type mesh;
+
+	mesh.dimensions(dims);
+	mesh.extents(xmin, xmax);
+	mesh.update();
+
+	auto f0 = make_field<Real>(make_domain<VERTEX>(mesh));
+	auto f1 = make_field<Real>(make_domain<EDGE>(mesh));
+	auto f2 = make_field<Real>(make_domain<FACE>(mesh));
+	auto f3 = make_field<Real>(make_domain<VOLUME>(mesh));
+
+	f0.clear();
+	f1.clear();
+	f2.clear();
+	f3.clear();
+
+	for (auto s : f0.domain())
+	{
+		f0[s] = std::sin(inner_product(k, mesh.coordinates(s)));
+	}
+	for (auto s : f1.domain())
+	{
+		f1[s] = std::sin(inner_product(k, mesh.coordinates(s)));
+	}
+	for (auto s : f2.domain())
+	{
+		f2[s] = std::cos(inner_product(k, mesh.coordinates(s)));
+	}
+	for (auto s : f3.domain())
+	{
+		f3[s] = std::cos(inner_product(k, mesh.coordinates(s)));
+	}
+
+	double num = static_cast<double>(mesh.get_num_of_elements(VERTEX));
+
+	// bytes: values read + written per cell, each value is read once
+	auto run = [&](std::string const & name,size_t num_of_read,size_t num_of_write,
+			std::function<void()> const & fun)
+	{
+		bench.run(name, num, "cells", fun)
+
+		.tag("dims", dims)
+
+		.bytes = num * (num_of_read + num_of_write) * sizeof(Real);
+	};
+
+	run("grad0", 1, 3, [&]()
+	{	f1 = grad(f0);});
+
+	run("grad3", 1, 3, [&]()
+	{	f2 = grad(f3);});
+
+	run("curl1", 3, 3, [&]()
+	{	f2 = curl(f1);});
+
+	run("curl2", 3, 3, [&]()
+	{	f1 = curl(f2);});
+
+	run("diverge1", 3, 1, [&]()
+	{	f0 = diverge(f1);});
+
+	run("diverge2", 3, 1, [&]()
+	{	f3 = diverge(f2);});
+}
+
+int main(int argc, char **argv)
+{
+	LOGGER.init(argc, argv);
+
+	Benchmark bench("bench_fetl");
+
+	std::vector<nTuple<size_t, 3>> dims;
+
+	bench.init(argc, argv,
+			[&](std::string const & opt,std::string const & value)->int
+			{
+				if(opt=="dims")
+				{
+					dims.push_back(parse_dims(value));
+				}
+				return CONTINUE;
+			});
+
+	if (dims.size() == 0)
+	{
+		dims.push_back(parse_dims("32"));
+		dims.push_back(parse_dims("64"));
+	}
+
+	for (auto const & d : dims)
+	{
+		bench_fetl(bench, d);
+	}
+
+	bench.write();
+}
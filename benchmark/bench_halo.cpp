@@ -0,0 +1,147 @@
+/**
+ * \file bench_halo.cpp
+ *
+ * \date    2014年11月17日  下午4:40:51
+ * \author salmon
+ *
+ *  latency and bandwidth of the ghost exchange
+ *
+ *  - update_ghosts : DistributedArray ghost exchange of a scalar (VERTEX)
+ *                    and a vector (EDGE/FACE) array, work is the number of
+ *                    bytes received by all ranks
+ *  - ring          : MPI_Sendrecv to the next rank, message size 8B-2MB,
+ *                    the lower bound of update_ghosts
+ *
+ *  usage: mpirun -np 4 bench_halo [--dims 64,64,64]... [--gw 2]
+ *                                 [--repeat 10] [--output halo.json]
+ */
+
+#include <string>
+#include <vector>
+
+#include "bench.h"
+
+#include "../core/utilities/ntuple.h"
+#include "../core/utilities/primitives.h"
+#include "../core/parallel/distributed_array.h"
+
+using namespace simpla;
+
+/// bytes received by this rank in one update_ghosts
+size_t ghost_size(DistributedArray const & darray, size_t value_size)
+{
+	size_t res = 0;
+
+	for (auto const & item : darray.send_recv_)
+	{
+		size_t count = value_size;
+
+		for (int i = 0; i < darray.ndims; ++i)
+		{
+			count *= (item.recv_end[i] - item.recv_begin[i]);
+		}
+
+		res += count;
+	}
+
+	return res;
+}
+
+template<typename TV>
+void bench_update_ghosts(Benchmark & bench, nTuple<size_t, 3> const & dims,
+		size_t gw, std::string const & value_type)
+{
+	nTuple<size_t, 3> begin = { 0, 0, 0 };
+
+	DistributedArray darray;
+
+	darray.init(3, begin, dims, gw);
+
+	std::vector<TV> data(darray.memory_size());
+
+	for (auto & v : data)
+	{
+		v = GLOBAL_COMM.get_rank();
+	}
+
+	size_t bytes = ghost_size(darray, sizeof(TV));
+
+	auto & r = bench.run("update_ghosts", bytes, "bytes", [&]()
+	{
+		update_ghosts(&data[0],darray);
+	});
+
+	r.tag("dims", dims).tag("gw", gw).tag("value_type", value_type)
+
+	.tag("num_of_neighbours", darray.send_recv_.size());
+
+	r.bytes = r.work;
+}
+
+void bench_ring(Benchmark & bench, size_t size)
+{
+	int rank = GLOBAL_COMM.get_rank();
+	int num = GLOBAL_COMM.get_size();
+
+	std::vector<char> send(size), recv(size);
+
+	bench.run("ring", size, "bytes", [&]()
+	{
+		MPI_Sendrecv(&send[0], size, MPI_BYTE, (rank + 1) % num, 0,
+				&recv[0], size, MPI_BYTE, (rank + num - 1) % num, 0,
+				GLOBAL_COMM.comm(), MPI_STATUS_IGNORE);
+	}).tag("message_size", size).bytes = size * num;
+}
+
+int main(int argc, char **argv)
+{
+	LOGGER.init(argc, argv);
+
+	Benchmark bench("bench_halo");
+
+	std::vector<nTuple<size_t, 3>> dims;
+
+	size_t gw = 2;
+
+	bench.init(argc, argv,
+			[&](std::string const & opt,std::string const & value)->int
+			{
+				if(opt=="dims")
+				{
+					dims.push_back(parse_dims(value));
+				}
+				else if(opt=="gw")
+				{
+					gw=ToValue<size_t>(value);
+				}
+				return CONTINUE;
+			});
+
+	if (dims.size() == 0)
+	{
+		dims.push_back(parse_dims("32"));
+		dims.push_back(parse_dims("64"));
+	}
+
+	if (GLOBAL_COMM.get_size() <= 1)
+	{
+		WARNING << "bench_halo: only one process, no ghost is exchanged";
+	}
+
+	for (auto const & d : dims)
+	{
+		bench_update_ghosts<Real>(bench, d, gw, "scalar");
+
+		bench_update_ghosts<nTuple<Real, 3>>(bench, d, gw, "vector");
+	}
+
+	if (GLOBAL_COMM.get_size() > 1)
+	{
+		for (size_t size = 8; size <= (4UL << 20); size *= 8)
+		{
+			bench_ring(bench, size);
+		}
+	}
+
+	bench.write();
+}
@@ -0,0 +1,249 @@
+/**
+ * \file bench_particle.cpp
+ *
+ * \date    2014年11月17日  下午2:15:06
+ * \author salmon
+ *
+ *  gather, scatter, push and sort rates of the  PIC kernels, on one thread
+ *  per rank.
+ *
+ *  - gather   : E(x),B(x) at every particle
+ *  - scatter  : linear J deposit / charge conserving (Esirkepov) deposit
+ *  - push     : per-cell Boris push of the engine ( gather + rotation +
+ *               deposit),  for each deposit scheme
+ *  - sort     : ContainerPool::sort, re-bin the particles after one push
+ *
+ *  usage: bench_particle [--dims 32,32,32]... [--pic 16]... [--repeat 10]
+ *                        [--output particle.json]
+ */
+
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+
+#include "../core/utilities/ntuple.h"
+#include "../core/utilities/primitives.h"
+#include "../core/utilities/container_pool.h"
+#include "../core/field/field.h"
+#include "../core/manifold/manifold.h"
+#include "../core/manifold/domain.h"
+#include "../core/manifold/geometry/cartesian.h"
+#include "../core/manifold/topology/structured.h"
+#include "../core/manifold/diff_scheme/fdm.h"
+#include "../core/manifold/interpolator/interpolator.h"
+#include "../applications/particle_solver/pic_engine_deltaf.h"
+
+using namespace simpla;
+
+typedef Manifold<CartesianCoordinates<StructuredMesh, CARTESIAN_ZAXIS>,
+		FiniteDiffMethod, InterpolatorLinear> mesh_type;
+
+typedef PICDeltaF engine_type;
+
+typedef typename engine_type::Point_s point_type;
+
+typedef typename mesh_type::compact_index_type mid_type;
+
+typedef ContainerPool<mid_type, point_type> pool_type;
+
+void bench_particle(Benchmark & bench, nTuple<size_t, 3> const & dims,
+		size_t pic)
+{
+	nTuple<Real, 3> xmin = { 0, 0, 0 };
+	nTuple<Real, 3> xmax = { 1, 1, 1 };
+	nTuple<Real, 3> k = { TWOPI, TWOPI, TWOPI };
+
+	mesh_type mesh;
+
+	mesh.dimensions(dims);
+	mesh.extents(xmin, xmax);
+	mesh.update();
+
+	auto E = make_field<Real>(make_domain<EDGE>(mesh));
+	auto B = make_field<Real>(make_domain<FACE>(mesh));
+	auto J = make_field<Real>(make_domain<EDGE>(mesh));
+
+	E.clear();
+	B.clear();
+	J.clear();
+
+	for (auto s : E.domain())
+	{
+		E[s] = std::sin(inner_product(k, mesh.coordinates(s)));
+	}
+	for (auto s : B.domain())
+	{
+		B[s] = 1.0 + 0.1 * std::cos(inner_product(k, mesh.coordinates(s)));
+	}
+
+	// particles are uniform in every cell, v ~ N(0,1), one push moves a
+	// particle 0.1 cell on average
+	auto dx = mesh.dx();
+
+	Real dt = 0.1 * std::min(std::min(dx[0], dx[1]), dx[2]);
+
+	pool_type pool([&](point_type const & p)->mid_type
+	{
+		return std::get<0>(mesh.coordinates_global_to_local(p.x, 0UL));
+	});
+
+	std::mt19937 gen(GLOBAL_COMM.get_rank());
+
+	std::uniform_real_distribution<Real> uniform(0, 1);
+
+	std::normal_distribution<Real> normal(0, 1);
+
+	for (auto s : make_domain<VOLUME>(mesh))
+	{
+		for (size_t n = 0; n < pic; ++n)
+		{
+			nTuple<Real, 3> r = { uniform(gen), uniform(gen), uniform(gen) };
+
+			point_type p;
+
+			p.x = mesh.coordinates_local_to_global(s, r);
+			p.v = nTuple<Real, 3>( { normal(gen), normal(gen), normal(gen) });
+			p.f = 1.0;
+			p.w = 0.0;
+
+			pool.insert(std::move(p));
+		}
+	}
+
+	double num = static_cast<double>(pool.size());
+
+	std::vector<point_type> particles;
+
+	particles.reserve(pool.size());
+
+	for (auto const & item : pool)
+	{
+		particles.insert(particles.end(), item.second.begin(), item.second.end());
+	}
+
+	engine_type engine;
+
+	engine.mass = 1.0;
+	engine.charge = 1.0;
+	engine.temperature = 1.0;
+	engine.update();
+
+	auto tag = [&](BenchRecord & r)->BenchRecord &
+	{
+		return r.tag("engine", engine_type::get_type_as_string())
+
+		.tag("dims", dims).tag("pic", pic);
+	};
+
+	// bytes: particle is read (and written) once, fields are cached
+	Real sum = 0;
+
+	tag(bench.run("gather", num, "particles", [&]()
+	{
+		for(auto const & p:particles)
+		{
+			auto Ev = E(p.x);
+			auto Bv = B(p.x);
+			sum += Ev[0] + Bv[2];
+		}
+	})).bytes = num * sizeof(Vec3);
+
+	tag(bench.run("scatter", num, "particles", [&]()
+	{
+		for(auto const & p:particles)
+		{
+			J.scatter(p.x, p.v, p.f * p.w);
+		}
+	}, [&]()
+	{	J.clear();})).tag("deposit", "linear").bytes = num * 2 * sizeof(Vec3);
+
+	tag(bench.run("scatter", num, "particles", [&]()
+	{
+		for(auto const & p:particles)
+		{
+			mesh.scatter_esirkepov(J, p.x, p.x + p.v * dt, p.f * p.w, dt);
+		}
+	}, [&]()
+	{	J.clear();})).tag("deposit", "esirkepov").bytes = num * 2 * sizeof(Vec3);
+
+	pool_type pushed(pool);
+
+	for (int conserving = 0; conserving < 2; ++conserving)
+	{
+		engine.charge_conserving = (conserving != 0);
+
+		tag(bench.run("push", num, "particles", [&]()
+		{
+			for(auto & item:pushed)
+			{
+				engine.next_timestep(item.second.begin(), item.second.end(), dt, &J, E, B);
+			}
+		}, [&]()
+		{
+			pushed = pool;
+			J.clear();
+		}))
+
+		.tag("deposit", conserving != 0 ? "esirkepov" : "linear")
+
+		.bytes = num * 2 * sizeof(point_type);
+	}
+
+	pool_type sorted(pool);
+
+	tag(bench.run("sort", num, "particles", [&]()
+	{
+		sorted.sort();
+	}, [&]()
+	{	sorted = pushed;})).bytes = num * 2 * sizeof(point_type);
+
+	VERBOSE << "Checksum " << sum;
+}
+
+int main(int argc, char **argv)
+{
+	LOGGER.init(argc, argv);
+
+	Benchmark bench("bench_particle");
+
+	std::vector<nTuple<size_t, 3>> dims;
+
+	std::vector<size_t> pic;
+
+	bench.init(argc, argv,
+			[&](std::string const & opt,std::string const & value)->int
+			{
+				if(opt=="dims")
+				{
+					dims.push_back(parse_dims(value));
+				}
+				else if(opt=="pic")
+				{
+					pic.push_back(ToValue<size_t>(value));
+				}
+				return CONTINUE;
+			});
+
+	if (dims.size() == 0)
+	{
+		dims.push_back(parse_dims("32"));
+	}
+
+	if (pic.size() == 0)
+	{
+		pic.push_back(16);
+	}
+
+	for (auto const & d : dims)
+	{
+		for (auto n : pic)
+		{
+			bench_particle(bench, d, n);
+		}
+	}
+
+	bench.write();
+}
@@ -141,6 +141,8 @@ public:
 		if (empty())
 		{
 			container_traits<container_type>::allocate(size()).swap(data_);
+
+			container_traits<container_type>::first_touch(data_, domain_);
 		}
 
 	}
@@ -8,6 +8,7 @@
 #ifndef CONTEXT_BASE_H_
 #define CONTEXT_BASE_H_
 
+#include <cstddef>
 #include <iostream>
 #include <string>
 
@@ -41,6 +42,24 @@ public:
 
 	virtual bool empty() const =0;
 
+	/**
+	 *  work of one next_timestep() on this rank, reported by the benchmark
+	 *  mode of simpla (--benchmark)
+	 */
+	struct WorkLoad
+	{
+		size_t num_of_cells = 0;
+
+		size_t num_of_pushes = 0; //!< particle pushes
+
+		size_t num_of_bytes = 0; //!< field data streamed by the field solver
+	};
+
+	virtual WorkLoad get_workload() const
+	{
+		return WorkLoad();
+	}
+
 	virtual operator bool() const
 	{
 		return !empty();
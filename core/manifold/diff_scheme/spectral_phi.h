@@ -0,0 +1,241 @@
+/**
+ * \file spectral_phi.h
+ *
+ * \date    2014年11月13日  上午10:21:05
+ * \author salmon
+ */
+
+#ifndef SPECTRAL_PHI_H_
+#define SPECTRAL_PHI_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <tuple>
+#include <vector>
+
+#include "../../utilities/primitives.h"
+#include "../../utilities/log.h"
+#include "../../physics/constants.h"
+#include "../../numeric/fft.h"
+
+namespace simpla
+{
+
+/** \ingroup DiffScheme
+ *  \brief  FFT helper along the periodic (toroidal) axis
+ *
+ *   Transforms a real field  \f$f(\ldots,\phi_j)\f$ on \f$n_\phi\f$ points of
+ *   a line to harmonics \f$\hat{f}_m, m\in[0,N)\f$ and back,
+ *   \f$ f=\mathrm{Re}\hat{f}_0+2\mathrm{Re}\sum_{m>0}\hat{f}_m e^{i m\phi}\f$;
+ *   \f$\partial_\phi\f$ is the multiplication by \f$ i m \f$ (d_phi).
+ *   No field solver uses it yet, and modes are not split over ranks: the
+ *   phi axis must be local to each rank.
+ *
+ *   A batch is 'num_of_lines' lines, line 'l' starts at f+line_offset[l] and
+ *   its points are 'phi_stride' apart (see phi_lines). Mode space data are
+ *   stored as  modes[l*num_of_modes()+m].
+ */
+class SpectralPhi
+{
+public:
+	typedef SpectralPhi this_type;
+
+private:
+	size_t num_of_phi_ = 0;
+	size_t num_of_modes_ = 0;
+
+	Real phi_length_ = TWOPI;
+
+	FFTPlan<Real> plan_;
+
+public:
+
+	SpectralPhi()
+	{
+	}
+
+	~SpectralPhi()
+	{
+	}
+
+	static std::string get_type_as_string()
+	{
+		return "SpectralPhi";
+	}
+
+	template<typename TDict>
+	bool load(TDict const & dict)
+	{
+		if (!dict)
+			return false;
+
+		init(dict["NumOfPhi"].template as<size_t>(),
+				dict["NumOfModes"].template as<size_t>());
+
+		phi_length_ = dict["PhiLength"].template as<Real>(TWOPI);
+
+		return true;
+	}
+
+	template<typename OS>
+	OS & print(OS & os) const
+	{
+		os << "\tSpectralPhi = { NumOfPhi = " << num_of_phi_
+				<< ", NumOfModes = " << num_of_modes_ << ", PhiLength = "
+				<< phi_length_ << " }," << std::endl;
+		return os;
+	}
+
+	/**
+	 * @param num_of_phi    points along phi, line must not be decomposed
+	 * @param num_of_modes  harmonics kept,  num_of_modes<= num_of_phi/2+1
+	 */
+	void init(size_t num_of_phi, size_t num_of_modes)
+	{
+		if (num_of_phi == 0)
+		{
+			RUNTIME_ERROR("SpectralPhi: num_of_phi == 0 ");
+		}
+
+		num_of_phi_ = num_of_phi;
+
+		num_of_modes_ = std::min(num_of_modes, num_of_phi / 2 + 1);
+
+		if (num_of_modes_ < num_of_modes)
+		{
+			WARNING << "SpectralPhi: modes >" << num_of_modes_
+					<< " are not resolved by " << num_of_phi << " points";
+		}
+
+		plan_.init(num_of_phi_);
+	}
+
+	size_t num_of_phi() const
+	{
+		return num_of_phi_;
+	}
+	size_t num_of_modes() const
+	{
+		return num_of_modes_;
+	}
+
+	/// toroidal wave number of mode 'm', \f$ 2\pi m/L_\phi \f$
+	Real wave_number(size_t m) const
+	{
+		return TWOPI * static_cast<Real>(m) / phi_length_;
+	}
+
+	/**
+	 *  real space -> modes,  batched  r2c
+	 */
+	void forward(Real const * f, size_t num_of_lines, size_t const * line_offset,
+			size_t phi_stride, Complex * modes) const
+	{
+		for (size_t l = 0; l < num_of_lines; ++l)
+		{
+			plan_.forward(f + line_offset[l], phi_stride,
+					modes + l * num_of_modes_, 0, num_of_modes_);
+		}
+	}
+
+	/**
+	 *  modes -> real space, batched  c2r
+	 */
+	void backward(Complex const * modes, size_t num_of_lines, Real * f,
+			size_t const * line_offset, size_t phi_stride) const
+	{
+		for (size_t l = 0; l < num_of_lines; ++l)
+		{
+			plan_.backward(modes + l * num_of_modes_, num_of_modes_,
+					f + line_offset[l], phi_stride);
+		}
+	}
+
+	/**
+	 *  \f$ \hat{f}_m \leftarrow (i k_m)^{order}\hat{f}_m \f$
+	 */
+	void derivative(Complex * modes, size_t num_of_lines, size_t order = 1) const
+	{
+		size_t nm = num_of_modes_;
+
+		std::vector<Complex> factor(nm);
+
+		for (size_t m = 0; m < nm; ++m)
+		{
+			Complex ik(0, wave_number(m));
+			Complex a(1, 0);
+			for (size_t n = 0; n < order; ++n)
+			{
+				a *= ik;
+			}
+			factor[m] = a;
+		}
+
+		for (size_t l = 0; l < num_of_lines; ++l)
+			for (size_t m = 0; m < nm; ++m)
+			{
+				modes[l * nm + m] *= factor[m];
+			}
+	}
+
+	/**
+	 *  \f$ \partial^{order}_\phi f \f$ in real space, filtered to N modes
+	 */
+	void d_phi(Real const * f, Real * df, size_t num_of_lines,
+			size_t const * line_offset, size_t phi_stride,
+			size_t order = 1) const
+	{
+		std::vector<Complex> modes(num_of_lines * num_of_modes_);
+
+		forward(f, num_of_lines, line_offset, phi_stride, &modes[0]);
+
+		derivative(&modes[0], num_of_lines, order);
+
+		backward(&modes[0], num_of_lines, df, line_offset, phi_stride);
+	}
+
+};
+
+/**
+ *  \ingroup DiffScheme
+ *  \brief offsets of phi-lines of a scalar local array of 'mesh'
+ *
+ *   only inner (non-ghost) points, phi axis must not be decomposed.
+ *
+ * @return  <line offsets, phi stride>
+ */
+template<typename TM>
+std::tuple<std::vector<size_t>, size_t> phi_lines(TM const & mesh,
+		size_t phi_axis)
+{
+	typename TM::index_tuple dims, begin, count;
+
+	std::tie(dims, begin, count) = mesh.get_local_memory_shape();
+
+	size_t strides[3];
+
+	strides[2] = 1;
+	strides[1] = dims[2];
+	strides[0] = dims[1] * dims[2];
+
+	size_t a1 = (phi_axis + 1) % 3, a2 = (phi_axis + 2) % 3;
+
+	std::vector<size_t> offsets;
+
+	offsets.reserve(count[a1] * count[a2]);
+
+	for (size_t i = 0; i < count[a1]; ++i)
+		for (size_t j = 0; j < count[a2]; ++j)
+		{
+			offsets.push_back(
+					(begin[phi_axis]) * strides[phi_axis]
+							+ (begin[a1] + i) * strides[a1]
+							+ (begin[a2] + j) * strides[a2]);
+		}
+
+	return std::make_tuple(std::move(offsets), strides[phi_axis]);
+}
+
+}  // namespace simpla
+
+#endif /* SPECTRAL_PHI_H_ */
@@ -52,6 +52,10 @@ public:
 			range_(g.select(iform)), manifold_(g)/*, parent_(*this)*/
 	{
 	}
+	Domain(manifold_type const & g, range_type const & r) :
+			range_(r), manifold_(g)
+	{
+	}
 	// Copy constructor.
 	Domain(const this_type& rhs) :
 			range_(rhs.range_), manifold_(rhs.manifold_)/*, parent_(rhs.parent_) */
@@ -151,6 +155,22 @@ public:
 }
 ;
 
+/**
+ *  sub-domain 'n' of 'num', i.e. tile of thread 'n'
+ */
+template<typename TG, size_t IFORM>
+Domain<TG, IFORM> split(Domain<TG, IFORM> const & d, size_t num, size_t n)
+{
+	return std::move(
+			Domain<TG, IFORM>(d.manifold(), split(d.range_, num, n)));
+}
+
+template<typename TG, size_t IFORM>
+size_t split_extent(Domain<TG, IFORM> const & d)
+{
+	return split_extent(d.range_);
+}
+
 template<size_t IFORM, typename TM>
 Domain<TM, IFORM> make_domain(TM const & m)
 {
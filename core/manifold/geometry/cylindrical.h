@@ -11,6 +11,7 @@
 #include <iostream>
 #include <utility>
 #include <cmath>
+#include <vector>
 #include "../../utilities/ntuple.h"
 #include "../../utilities/primitives.h"
 #include "../../utilities/utilities.h"
@@ -563,40 +564,101 @@ public:
 	Real cell_volume(compact_index_type s) const
 	{
 		return topology_type::cell_volume(s) * volume_[1] * volume_[2]
-				* volume_[4] * get_coordinates(s)[RAxis];
+				* volume_[4] * R_(s);
 	}
 
 	scalar_type volume(compact_index_type s) const
 	{
 		size_t  n = topology_type::node_id(s);
 		return topology_type::volume(s) * volume_[n]
-				* (((n & (1UL << (ndims - PhiAxis - 1))) > 0) ?
-						get_coordinates(s)[RAxis] : 1.0);
+				* (((n & (1UL << (ndims - PhiAxis - 1))) > 0) ? R_(s) : 1.0);
 	}
 
 	scalar_type inv_volume(compact_index_type s) const
 	{
 		size_t  n = topology_type::node_id(s);
 		return topology_type::inv_volume(s) * inv_volume_[n]
-				/ (((n & (1UL << (ndims - PhiAxis - 1))) > 0) ?
-						get_coordinates(s)[RAxis] : 1.0);
+				* (((n & (1UL << (ndims - PhiAxis - 1))) > 0) ? inv_R_(s) : 1.0);
 	}
 
 	scalar_type dual_volume(compact_index_type s) const
 	{
 		size_t  n = topology_type::node_id(topology_type::dual(s));
 		return topology_type::dual_volume(s) * volume_[n]
-				* (((n & (1UL << (ndims - PhiAxis - 1))) > 0) ?
-						get_coordinates(s)[RAxis] : 1.0);
+				* (((n & (1UL << (ndims - PhiAxis - 1))) > 0) ? R_(s) : 1.0);
 	}
 	scalar_type inv_dual_volume(compact_index_type s) const
 	{
 		size_t  n = topology_type::node_id(topology_type::dual(s));
 		return topology_type::inv_dual_volume(s) * inv_volume_[n]
-				/ (((n & (1UL << (ndims - PhiAxis - 1))) > 0) ?
-						get_coordinates(s)[RAxis] : 1.0);
+				* (((n & (1UL << (ndims - PhiAxis - 1))) > 0) ? inv_R_(s) : 1.0);
 	}
 //! @}
+
+//! @name  metric tables along R
+//!  R and 1/R at every half grid point of local (outer) range, built by
+//!  update(). The entry is picked by the R digits of compact index 's',
+//!  no decompact or coordinates transform in stencils of FDM/FVM.
+//! @{
+private:
+
+	std::vector<Real> R_table_, inv_R_table_;
+
+	index_type R_table_begin_ = 0;
+
+	/// index of 's' along R,  in unit of half grid
+	static index_type R_half_index_(compact_index_type s)
+	{
+		return ((s >> (topology_type::INDEX_DIGITS * (ndims - RAxis - 1)))
+				& topology_type::INDEX_MASK)
+				>> (topology_type::MAX_DEPTH_OF_TREE - 1);
+	}
+
+	Real R_from_half_index_(index_type h) const
+	{
+		Real x = (static_cast<Real>(h) * 0.5
+				- static_cast<Real>(topology_type::global_begin_[RAxis]))
+				/ static_cast<Real>(topology_type::global_count_[RAxis]);
+
+		return x * length_[RAxis] + shift_[RAxis];
+	}
+
+	void update_metric_tables_()
+	{
+		R_table_begin_ = (topology_type::local_outer_begin_[RAxis] << 1) - 1;
+
+		size_t num = ((topology_type::local_outer_end_[RAxis] << 1) + 2)
+				- R_table_begin_;
+
+		R_table_.resize(num);
+		inv_R_table_.resize(num);
+
+		for (size_t i = 0; i < num; ++i)
+		{
+			R_table_[i] = R_from_half_index_(R_table_begin_ + i);
+			inv_R_table_[i] = 1.0 / R_table_[i];
+		}
+	}
+
+public:
+
+	inline Real R_(compact_index_type s) const
+	{
+		index_type n = R_half_index_(s) - R_table_begin_;
+
+		return (n < R_table_.size()) ?
+				R_table_[n] : R_from_half_index_(R_half_index_(s));
+	}
+
+	inline Real inv_R_(compact_index_type s) const
+	{
+		index_type n = R_half_index_(s) - R_table_begin_;
+
+		return (n < inv_R_table_.size()) ?
+				inv_R_table_[n] : 1.0 / R_from_half_index_(R_half_index_(s));
+	}
+//! @}
+//! @}
 }
 ;
 
@@ -723,6 +785,8 @@ bool CylindricalCoordinates<TTopology, IPhiAxis>::update()
 
 	inv_volume_[7] /* 111 */= inv_volume_[1] * inv_volume_[2] * inv_volume_[4];
 
+	update_metric_tables_();
+
 	updatedt();
 
 	return true;
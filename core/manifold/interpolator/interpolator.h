@@ -8,6 +8,8 @@
 #ifndef INTERPOLATOR_H_
 #define INTERPOLATOR_H_
 
+#include <algorithm>
+#include <cmath>
 //#include "../../fetl/field_constant.h"
 #include "../../utilities/ntuple.h"
 #include "../../utilities/primitives.h"
@@ -201,6 +203,347 @@ public:
 				geo->coordinates_global_to_local(x, topology_type::_DA), w);
 	}
 
+
+	/**
+	 *  \brief values of one field  around a cell, shared by all particles of
+	 *   that cell.
+	 *
+	 *   Points of component 'n' are s+shift(n)+a*X+b*Y+c*Z, a,b,c in {-1,0,1},
+	 *   stored at v[n][((a+1)*3+(b+1))*3+(c+1)]. -1 is used only in directions
+	 *   where the component is staggered by half a cell.
+	 */
+	template<typename TV, size_t IFORM>
+	struct CellStencil
+	{
+		static constexpr size_t iform = IFORM;
+
+		static constexpr size_t num_of_comps =
+				(IFORM == EDGE || IFORM == FACE) ? 3 : 1;
+
+		typedef TV value_type;
+
+		typedef typename std::conditional<num_of_comps == 3, nTuple<TV, 3>, TV>::type field_value_type;
+
+		TV v[num_of_comps][27];
+
+		void clear()
+		{
+			for (size_t n = 0; n < num_of_comps; ++n)
+				for (size_t k = 0; k < 27; ++k)
+				{
+					v[n][k] = 0;
+				}
+		}
+	};
+
+	template<typename TF> using cell_stencil_type=
+	CellStencil<typename field_traits<TF>::value_type, field_traits<TF>::iform>;
+
+private:
+
+	/// bit 'i' is set if component 'n' of IFORM is staggered in  direction 'i'
+	static constexpr unsigned int stagger_(size_t iform, size_t n)
+	{
+		return (iform == VERTEX) ? 0U : ((iform == EDGE) ? (1U << n) :
+
+				((iform == FACE) ? (7U & (~(1U << n))) : 7U));
+	}
+
+	static typename G::index_type stencil_point_(typename G::index_type s,
+			unsigned int stagger, int a, int b, int c)
+	{
+		auto X = (topology_type::_DI) << 1;
+		auto Y = (topology_type::_DJ) << 1;
+		auto Z = (topology_type::_DK) << 1;
+
+		if ((stagger & 1U) != 0)
+			s += topology_type::_DI;
+		if ((stagger & 2U) != 0)
+			s += topology_type::_DJ;
+		if ((stagger & 4U) != 0)
+			s += topology_type::_DK;
+
+		s = (a < 0) ? (s - X) : (s + a * X);
+		s = (b < 0) ? (s - Y) : (s + b * Y);
+		s = (c < 0) ? (s - Z) : (s + c * Z);
+
+		return s;
+	}
+
+	/**
+	 * @param r  local coordinates in cell, in [0,1)
+	 * @param o  offset of the lower stencil point
+	 * @param w  weight of the upper stencil point
+	 */
+	static void stencil_weight_(coordinates_type const & r,
+			unsigned int stagger, int * o, Real * w)
+	{
+		for (int i = 0; i < 3; ++i)
+		{
+			Real t = ((stagger >> i) & 1U) != 0 ? (r[i] - 0.5) : r[i];
+
+			o[i] = (t < 0) ? -1 : 0;
+
+			w[i] = t - o[i];
+		}
+	}
+
+	static size_t stencil_offset_(int a, int b, int c)
+	{
+		return ((a + 1) * 3 + (b + 1)) * 3 + (c + 1);
+	}
+
+	template<typename TV>
+	static void set_comp_(TV & res, size_t, TV const & v)
+	{
+		res = v;
+	}
+	template<typename TV>
+	static void set_comp_(nTuple<TV, 3> & res, size_t n, TV const & v)
+	{
+		res[n] = v;
+	}
+	template<typename TV>
+	static TV const & get_comp_(TV const & v, size_t)
+	{
+		return v;
+	}
+	template<typename TV>
+	static TV const & get_comp_(nTuple<TV, 3> const & v, size_t n)
+	{
+		return v[n];
+	}
+
+public:
+
+	/**
+	 *  \brief load the stencil of field 'f' around vertex cell 's'
+	 */
+	template<typename TF>
+	void gather_cell(TF const & f, typename G::index_type s,
+			cell_stencil_type<TF> * st) const
+	{
+		typedef cell_stencil_type<TF> stencil_type;
+
+		for (size_t n = 0; n < stencil_type::num_of_comps; ++n)
+		{
+			unsigned int stagger = stagger_(stencil_type::iform, n);
+
+			for (int a = -1; a <= 1; ++a)
+				for (int b = -1; b <= 1; ++b)
+					for (int c = -1; c <= 1; ++c)
+					{
+						bool used = (a >= 0 || (stagger & 1U) != 0)
+								&& (b >= 0 || (stagger & 2U) != 0)
+								&& (c >= 0 || (stagger & 4U) != 0);
+
+						st->v[n][stencil_offset_(a, b, c)] =
+								used ? get_value(f,
+												stencil_point_(s, stagger, a, b,
+														c)) : 0;
+					}
+		}
+	}
+
+	/**
+	 *  \brief interpolate at local coordinates 'r' of the stencil cell, r in [0,1)
+	 */
+	template<typename TS>
+	typename TS::field_value_type gather_in_cell(TS const & st,
+			coordinates_type const & r) const
+	{
+		typename TS::field_value_type res;
+
+		for (size_t n = 0; n < TS::num_of_comps; ++n)
+		{
+			int o[3];
+			Real w[3];
+
+			stencil_weight_(r, stagger_(TS::iform, n), o, w);
+
+			typename TS::value_type v = 0;
+
+			for (int a = 0; a <= 1; ++a)
+				for (int b = 0; b <= 1; ++b)
+					for (int c = 0; c <= 1; ++c)
+					{
+						v += st.v[n][stencil_offset_(o[0] + a, o[1] + b,
+								o[2] + c)] * (a ? w[0] : 1.0 - w[0])
+								* (b ? w[1] : 1.0 - w[1])
+								* (c ? w[2] : 1.0 - w[2]);
+					}
+
+			set_comp_(res, n, v);
+		}
+		return std::move(res);
+	}
+
+	/**
+	 *  \brief accumulate 'v' at local coordinates 'r' into the stencil,  r in [0,1)
+	 */
+	template<typename TS>
+	void scatter_in_cell(TS * st, coordinates_type const & r,
+			typename TS::field_value_type const & v) const
+	{
+		for (size_t n = 0; n < TS::num_of_comps; ++n)
+		{
+			int o[3];
+			Real w[3];
+
+			stencil_weight_(r, stagger_(TS::iform, n), o, w);
+
+			auto const & u = get_comp_(v, n);
+
+			for (int a = 0; a <= 1; ++a)
+				for (int b = 0; b <= 1; ++b)
+					for (int c = 0; c <= 1; ++c)
+					{
+						st->v[n][stencil_offset_(o[0] + a, o[1] + b, o[2] + c)] +=
+								u * (a ? w[0] : 1.0 - w[0])
+										* (b ? w[1] : 1.0 - w[1])
+										* (c ? w[2] : 1.0 - w[2]);
+					}
+		}
+	}
+
+	/**
+	 *  \brief add  the accumulated stencil  to field 'f' around vertex cell 's'
+	 */
+	template<typename TF>
+	void scatter_cell(TF & f, typename G::index_type s,
+			cell_stencil_type<TF> const & st) const
+	{
+		typedef cell_stencil_type<TF> stencil_type;
+
+		for (size_t n = 0; n < stencil_type::num_of_comps; ++n)
+		{
+			unsigned int stagger = stagger_(stencil_type::iform, n);
+
+			for (int a = -1; a <= 1; ++a)
+				for (int b = -1; b <= 1; ++b)
+					for (int c = -1; c <= 1; ++c)
+					{
+						auto const & v = st.v[n][stencil_offset_(a, b, c)];
+
+						if (v != 0)
+						{
+							get_value(f, stencil_point_(s, stagger, a, b, c)) +=
+									v;
+						}
+					}
+		}
+	}
+
+private:
+
+	/**
+	 *  linear shape of a point at u in (-1,2) on vertices -1,0,1,2
+	 */
+	static void esirkepov_shape_(Real u, Real * S)
+	{
+#pragma omp simd
+		for (int n = 0; n < 4; ++n)
+		{
+			S[n] = std::max(0.0, 1.0 - std::abs(u - (n - 1)));
+		}
+	}
+
+public:
+
+	/**
+	 *  \brief charge conserving current deposition (Esirkepov 2001)
+	 *
+	 *   Deposit the current of a particle with charge 'q', moving  from x0 to
+	 *   x1 in 'dt', to EDGE field J. The displacement must be less than one
+	 *   cell in every direction. J satisfies the discrete continuity equation
+	 *   with the linear charge assignment of the old and new positions, and
+	 *   J summed over edges is q*(x1-x0)/dt, as scatter(J,x,v,q) with v=(x1-x0)/dt.
+	 *   The stencil is fixed to 3 vertices per axis by the direction of the
+	 *   motion, every edge of it is written, zero or not.
+	 *
+	 *   'q' is constant during the motion, a change of the particle weight
+	 *   (delta-f) is a source of charge, not a current, and is not in J.
+	 */
+	template<typename TJ>
+	void scatter_esirkepov(TJ & J, coordinates_type const & x0,
+			coordinates_type const & x1, Real q, Real dt) const
+	{
+		auto X = (topology_type::_DI) << 1;
+		auto Y = (topology_type::_DJ) << 1;
+		auto Z = (topology_type::_DK) << 1;
+
+		auto idx = geo->coordinates_global_to_local(x0, 0UL);
+
+		typename G::index_type s = std::get<0>(idx);
+
+		coordinates_type dx = geo->dx(s);
+
+		Real S0[3][4], DS[3][4];
+
+		// stencil of axis i is vertices o[i]-1 .. o[i]+nv[i]-2, vertices -1,0,1
+		// if the particle moves to u<0, else 0,1,2 ( 0,1 on a degenerate axis)
+		int o[3], nv[3];
+
+		for (int i = 0; i < 3; ++i)
+		{
+			Real u0 = std::get<1>(idx)[i];
+
+			Real u1 = u0 + ((dx[i] > 0) ? (x1[i] - x0[i]) / dx[i] : 0);
+
+			esirkepov_shape_(u0, S0[i]);
+			esirkepov_shape_(u1, DS[i]);
+
+			for (int n = 0; n < 4; ++n)
+			{
+				DS[i][n] -= S0[i][n];
+			}
+
+			o[i] = (u1 < 0) ? 0 : 1;
+			nv[i] = (dx[i] > 0) ? 3 : 2;
+		}
+
+		// vertex (-1,-1,-1) of the stencil
+		s = ((s - X) - Y) - Z;
+
+		typename G::index_type D[3] = { X, Y, Z };
+
+		for (int i = 0; i < 3; ++i)
+		{
+			int j = (i + 1) % 3, k = (i + 2) % 3;
+
+			if (dx[i] <= 0)
+			{
+				continue;
+			}
+
+			Real a = -q * dx[i] / dt;
+
+			typename G::index_type shift =
+					(i == 0) ? topology_type::_DI :
+					((i == 1) ? topology_type::_DJ : topology_type::_DK);
+
+			for (int m = o[j]; m < o[j] + nv[j]; ++m)
+				for (int n = o[k]; n < o[k] + nv[k]; ++n)
+				{
+					Real w = S0[j][m] * S0[k][n] + 0.5 * DS[j][m] * S0[k][n]
+							+ 0.5 * S0[j][m] * DS[k][n]
+							+ DS[j][m] * DS[k][n] / 3.0;
+
+					Real acc = 0;
+
+					// edge l is between vertex l and l+1, the current of the
+					// last edge of the stencil is zero
+					for (int l = o[i]; l < o[i] + nv[i] - 1; ++l)
+					{
+						acc += DS[i][l] * w;
+
+						get_value(J, s + shift + l * D[i] + m * D[j] + n * D[k]) +=
+								a * acc;
+					}
+				}
+		}
+	}
+
 }
 ;
 
@@ -0,0 +1,613 @@
+/**
+ * \file interpolator_bspline.h
+ *
+ * \date    2014年10月23日  下午2:16:40
+ * \author salmon
+ */
+
+#ifndef INTERPOLATOR_BSPLINE_H_
+#define INTERPOLATOR_BSPLINE_H_
+
+#include <utility>
+
+#include "../../utilities/ntuple.h"
+#include "../../utilities/primitives.h"
+#include "interpolator.h"
+
+namespace simpla
+{
+
+template<typename ...> class field_traits;
+
+/**
+ * \ingroup Interpolator
+ *
+ * \brief  1D B-spline shape function of ORDER, ORDER+1 points
+ *
+ *  \code int offset=bspline_shape<ORDER>::weight(r,w) \endcode
+ *  r is the local coordinate in [0,1) relative to point 's', w[n] is the weight
+ *  of point s+offset+n, offset is in [min_offset,max_offset]
+ */
+template<size_t ORDER> struct bspline_shape;
+
+template<> struct bspline_shape<1>
+{
+	static constexpr size_t num_of_points = 2;
+
+	static constexpr int min_offset = 0;
+
+	static constexpr int max_offset = 0;
+
+	static int weight(Real r, Real * w)
+	{
+		w[0] = 1.0 - r;
+		w[1] = r;
+		return 0;
+	}
+};
+
+template<> struct bspline_shape<2>
+{
+	static constexpr size_t num_of_points = 3;
+
+	static constexpr int min_offset = -1;
+
+	static constexpr int max_offset = 0;
+
+	static int weight(Real r, Real * w)
+	{
+		int i0 = static_cast<int>(r + 0.5); // nearest point
+
+		Real d = r - i0;
+
+		w[0] = 0.5 * (0.5 - d) * (0.5 - d);
+		w[1] = 0.75 - d * d;
+		w[2] = 0.5 * (0.5 + d) * (0.5 + d);
+
+		return i0 - 1;
+	}
+};
+
+template<> struct bspline_shape<3>
+{
+	static constexpr size_t num_of_points = 4;
+
+	static constexpr int min_offset = -1;
+
+	static constexpr int max_offset = -1;
+
+	static int weight(Real r, Real * w)
+	{
+		Real r2 = r * r;
+		Real r3 = r2 * r;
+
+		w[0] = (1.0 - r) * (1.0 - r) * (1.0 - r) / 6.0;
+		w[1] = (4.0 - 6.0 * r2 + 3.0 * r3) / 6.0;
+		w[2] = (1.0 + 3.0 * r + 3.0 * r2 - 3.0 * r3) / 6.0;
+		w[3] = r3 / 6.0;
+
+		return -1;
+	}
+};
+
+/**
+ * \ingroup Interpolator
+ *
+ * \brief  B-spline  interpolator of ORDER (1 linear, 2 quadratic, 3 cubic)
+ *
+ *  Same interface as InterpolatorLinear. Weights of a point are the tensor
+ *  product of 1D shape functions, (ORDER+1)^3 points per component. The
+ *  weight table is built first, then the stencil is a fixed length
+ *  dot product, both loops have compile-time trip counts and are vectorized.
+ *
+ *  The per-cell interface (gather_cell, gather_in_cell, scatter_in_cell,
+ *  scatter_cell) keeps the points that particles of one cell can touch in
+ *  a fixed array, cell_width^3 per component (3^3 linear, 5^3 quadratic
+ *  and cubic), as CellStencil of InterpolatorLinear. scatter_esirkepov is
+ *  the linear scheme of InterpolatorLinear, J is charge conserving with
+ *  respect to the linear charge assignment, not to the B-spline one.
+ */
+template<typename G, size_t ORDER>
+class InterpolatorBSpline
+{
+
+public:
+	typedef InterpolatorBSpline<G, ORDER> this_type;
+
+	typedef G geometry_type;
+
+	typedef typename G::coordinates_type coordinates_type;
+	typedef typename G::topology_type topology_type;
+
+	static constexpr size_t order = ORDER;
+
+	static constexpr size_t num_of_points = bspline_shape<ORDER>::num_of_points;
+
+	static constexpr size_t stencil_size = num_of_points * num_of_points
+			* num_of_points;
+
+	/// first point of the per-cell stencil along an axis, relative to the cell
+	static constexpr int cell_lower = bspline_shape<ORDER>::min_offset - 1;
+
+	/// points of the per-cell stencil along an axis
+	static constexpr size_t cell_width =
+			static_cast<size_t>(bspline_shape<ORDER>::max_offset
+					+ static_cast<int>(num_of_points) - cell_lower);
+
+	static constexpr size_t cell_stencil_size = cell_width * cell_width
+			* cell_width;
+
+	G const * geo;
+	InterpolatorBSpline(G const * g) :
+			geo(g)
+	{
+	}
+	InterpolatorBSpline() :
+			geo(nullptr)
+	{
+	}
+	InterpolatorBSpline(this_type const & r) :
+			geo(r.geo)
+	{
+	}
+	~InterpolatorBSpline()
+	{
+	}
+
+	void geometry(G const*g)
+	{
+		geo = g;
+	}
+	G const &geometry() const
+	{
+		return *geo;
+	}
+
+private:
+
+	static typename G::index_type shift_(typename G::index_type s, int n,
+			typename G::index_type D)
+	{
+		return (n < 0) ? (s - static_cast<typename G::index_type>(-n) * D) :
+				(s + static_cast<typename G::index_type>(n) * D);
+	}
+
+	/**
+	 *  weights  and the first point of  stencil
+	 */
+	template<typename TIDX>
+	static typename G::index_type stencil_(TIDX const & idx, Real * w)
+	{
+		auto X = (topology_type::_DI) << 1;
+		auto Y = (topology_type::_DJ) << 1;
+		auto Z = (topology_type::_DK) << 1;
+
+		typename G::coordinates_type r = std::get<1>(idx);
+		typename G::index_type s = std::get<0>(idx);
+
+		Real wx[num_of_points], wy[num_of_points], wz[num_of_points];
+
+		s = shift_(s, bspline_shape<ORDER>::weight(r[0], wx), X);
+		s = shift_(s, bspline_shape<ORDER>::weight(r[1], wy), Y);
+		s = shift_(s, bspline_shape<ORDER>::weight(r[2], wz), Z);
+
+		for (size_t i = 0; i < num_of_points; ++i)
+			for (size_t j = 0; j < num_of_points; ++j)
+			{
+				Real wxy = wx[i] * wy[j];
+#pragma omp simd
+				for (size_t k = 0; k < num_of_points; ++k)
+				{
+					w[(i * num_of_points + j) * num_of_points + k] = wxy * wz[k];
+				}
+			}
+
+		return s;
+	}
+
+	template<typename TD, typename TIDX>
+	inline auto gather_impl_(TD const & f,
+			TIDX const & idx) const -> decltype(get_value(f, std::get<0>(idx) )* std::get<1>(idx)[0])
+	{
+		auto X = (topology_type::_DI) << 1;
+		auto Y = (topology_type::_DJ) << 1;
+		auto Z = (topology_type::_DK) << 1;
+
+		Real w[stencil_size];
+
+		typename G::index_type s = stencil_(idx, w);
+
+		typename std::remove_const<
+				typename std::remove_reference<decltype(get_value(f, s))>::type>::type v[stencil_size];
+
+		for (size_t i = 0; i < num_of_points; ++i)
+			for (size_t j = 0; j < num_of_points; ++j)
+				for (size_t k = 0; k < num_of_points; ++k)
+				{
+					v[(i * num_of_points + j) * num_of_points + k] = get_value(f,
+							s + i * X + j * Y + k * Z);
+				}
+
+		decltype(get_value(f, s) * w[0]) res = v[0] * w[0];
+
+		for (size_t n = 1; n < stencil_size; ++n)
+		{
+			res += v[n] * w[n];
+		}
+
+		return res;
+	}
+
+public:
+
+	template<typename TF>
+	inline auto gather(TF const &f,
+			coordinates_type const & r) const //
+					ENABLE_IF_DECL_RET_TYPE((field_traits<TF >::iform==VERTEX),
+							( gather_impl_(f, geo->coordinates_global_to_local(r, 0UL) )))
+
+	template<typename TF>
+	auto gather(TF const &f,
+			coordinates_type const & r) const
+					ENABLE_IF_DECL_RET_TYPE((field_traits<TF >::iform==EDGE),
+							make_nTuple(
+									gather_impl_(f, geo->coordinates_global_to_local(r, (topology_type::_DI)) ),
+									gather_impl_(f, geo->coordinates_global_to_local(r, (topology_type::_DJ)) ),
+									gather_impl_(f, geo->coordinates_global_to_local(r, (topology_type::_DK)) )
+							))
+
+	template<typename TF>
+	auto gather(TF const &f,
+			coordinates_type const & r) const
+					ENABLE_IF_DECL_RET_TYPE(
+							(field_traits<TF >::iform==FACE),
+							make_nTuple(
+									gather_impl_(f, geo->coordinates_global_to_local(r,((topology_type::_DJ | topology_type::_DK))) ),
+									gather_impl_(f, geo->coordinates_global_to_local(r,((topology_type::_DK | topology_type::_DI))) ),
+									gather_impl_(f, geo->coordinates_global_to_local(r,((topology_type::_DI | topology_type::_DJ))) )
+							) )
+
+	template<typename TF>
+	auto gather(TF const &f,
+			coordinates_type const & x) const
+					ENABLE_IF_DECL_RET_TYPE((field_traits<TF >::iform==VOLUME),
+							gather_impl_(f, geo->coordinates_global_to_local(x, (topology_type::_DA)) ))
+
+private:
+	template<typename TF, typename IDX, typename TV>
+	inline void scatter_impl_(TF &f, IDX const& idx, TV const & v) const
+	{
+		auto X = (topology_type::_DI) << 1;
+		auto Y = (topology_type::_DJ) << 1;
+		auto Z = (topology_type::_DK) << 1;
+
+		Real w[stencil_size];
+
+		typename G::index_type s = stencil_(idx, w);
+
+		for (size_t i = 0; i < num_of_points; ++i)
+			for (size_t j = 0; j < num_of_points; ++j)
+				for (size_t k = 0; k < num_of_points; ++k)
+				{
+					get_value(f, s + i * X + j * Y + k * Z) += v
+							* w[(i * num_of_points + j) * num_of_points + k];
+				}
+	}
+public:
+
+	template<typename TF, typename TV, typename TW>
+	auto scatter(TF &f, coordinates_type const & x, TV const &u,
+			TW const &w) const ->typename std::enable_if< (field_traits<TF >::iform==VERTEX)>::type
+	{
+		scatter_impl_(f, geo->coordinates_global_to_local(x, 0UL), u * w);
+	}
+
+	template<typename TF, typename TV, typename TW>
+	auto scatter(TF &f, coordinates_type const & x, TV const &u,
+			TW const & w) const ->typename std::enable_if< (field_traits<TF >::iform==EDGE)>::type
+	{
+		scatter_impl_(f,
+				geo->coordinates_global_to_local(x, (topology_type::_DI)),
+				u[0] * w);
+		scatter_impl_(f,
+				geo->coordinates_global_to_local(x, (topology_type::_DJ)),
+				u[1] * w);
+		scatter_impl_(f,
+				geo->coordinates_global_to_local(x, (topology_type::_DK)),
+				u[2] * w);
+	}
+
+	template<typename TF, typename TV, typename TW>
+	auto scatter(TF &f, coordinates_type const & x, TV const &u,
+			TW const &w) const ->typename std::enable_if< (field_traits<TF >::iform==FACE)>::type
+	{
+		scatter_impl_(f,
+				geo->coordinates_global_to_local(x,
+						((topology_type::_DJ | topology_type::_DK))), u[0] * w);
+		scatter_impl_(f,
+				geo->coordinates_global_to_local(x,
+						((topology_type::_DK | topology_type::_DI))), u[1] * w);
+		scatter_impl_(f,
+				geo->coordinates_global_to_local(x,
+						((topology_type::_DI | topology_type::_DJ))), u[2] * w);
+	}
+
+	template<typename TF, typename TV, typename TW>
+	auto scatter(TF &f, coordinates_type const & x, TV const &u,
+			TW const &w) const ->typename std::enable_if< (field_traits<TF >::iform==VOLUME)>::type
+	{
+		scatter_impl_(f,
+				geo->coordinates_global_to_local(x, topology_type::_DA), w);
+	}
+
+	/**
+	 *  \brief values of one field around a cell, shared by all particles of
+	 *   that cell.
+	 *
+	 *   Point (a,b,c) of component 'n', a,b,c in [cell_lower,
+	 *   cell_lower+cell_width), is stored at v[n][cell_offset_(a,b,c)].
+	 */
+	template<typename TV, size_t IFORM>
+	struct CellStencil
+	{
+		static constexpr size_t iform = IFORM;
+
+		static constexpr size_t num_of_comps =
+				(IFORM == EDGE || IFORM == FACE) ? 3 : 1;
+
+		typedef TV value_type;
+
+		typedef typename std::conditional<num_of_comps == 3, nTuple<TV, 3>, TV>::type field_value_type;
+
+		TV v[num_of_comps][cell_stencil_size];
+
+		void clear()
+		{
+			for (size_t n = 0; n < num_of_comps; ++n)
+				for (size_t k = 0; k < cell_stencil_size; ++k)
+				{
+					v[n][k] = 0;
+				}
+		}
+	};
+
+	template<typename TF> using cell_stencil_type=
+	CellStencil<typename field_traits<TF>::value_type, field_traits<TF>::iform>;
+
+private:
+
+	/// bit 'i' is set if component 'n' of IFORM is staggered in  direction 'i'
+	static constexpr unsigned int stagger_(size_t iform, size_t n)
+	{
+		return (iform == VERTEX) ? 0U : ((iform == EDGE) ? (1U << n) :
+
+				((iform == FACE) ? (7U & (~(1U << n))) : 7U));
+	}
+
+	static size_t cell_offset_(int a, int b, int c)
+	{
+		return ((a - cell_lower) * cell_width + (b - cell_lower)) * cell_width
+				+ (c - cell_lower);
+	}
+
+	static typename G::index_type cell_point_(typename G::index_type s,
+			unsigned int stagger, int a, int b, int c)
+	{
+		if ((stagger & 1U) != 0)
+			s += topology_type::_DI;
+		if ((stagger & 2U) != 0)
+			s += topology_type::_DJ;
+		if ((stagger & 4U) != 0)
+			s += topology_type::_DK;
+
+		s = shift_(s, a, (topology_type::_DI) << 1);
+		s = shift_(s, b, (topology_type::_DJ) << 1);
+		s = shift_(s, c, (topology_type::_DK) << 1);
+
+		return s;
+	}
+
+	/**
+	 *  weights along one axis of local coordinate 'r' in [0,1)
+	 *  \return first point, relative to the cell
+	 */
+	static int cell_weight_(Real r, bool staggered, Real * w)
+	{
+		Real t = staggered ? (r - 0.5) : r;
+
+		int o = (t < 0) ? -1 : 0;
+
+		return o + bspline_shape<ORDER>::weight(t - o, w);
+	}
+
+	/// points [lo,hi] of an axis which particles of the cell can touch
+	static void cell_range_(bool staggered, int * lo, int * hi)
+	{
+		*lo = staggered ? cell_lower : bspline_shape<ORDER>::min_offset;
+
+		*hi = bspline_shape<ORDER>::max_offset
+				+ static_cast<int>(num_of_points) - 1;
+	}
+
+	template<typename TV>
+	static void set_comp_(TV & res, size_t, TV const & v)
+	{
+		res = v;
+	}
+	template<typename TV>
+	static void set_comp_(nTuple<TV, 3> & res, size_t n, TV const & v)
+	{
+		res[n] = v;
+	}
+	template<typename TV>
+	static TV const & get_comp_(TV const & v, size_t)
+	{
+		return v;
+	}
+	template<typename TV>
+	static TV const & get_comp_(nTuple<TV, 3> const & v, size_t n)
+	{
+		return v[n];
+	}
+
+public:
+
+	/**
+	 *  \brief load the stencil of field 'f' around vertex cell 's'
+	 */
+	template<typename TF>
+	void gather_cell(TF const & f, typename G::index_type s,
+			cell_stencil_type<TF> * st) const
+	{
+		typedef cell_stencil_type<TF> stencil_type;
+
+		st->clear();
+
+		for (size_t n = 0; n < stencil_type::num_of_comps; ++n)
+		{
+			unsigned int stagger = stagger_(stencil_type::iform, n);
+
+			int lo[3], hi[3];
+
+			for (int i = 0; i < 3; ++i)
+			{
+				cell_range_(((stagger >> i) & 1U) != 0, &lo[i], &hi[i]);
+			}
+
+			for (int a = lo[0]; a <= hi[0]; ++a)
+				for (int b = lo[1]; b <= hi[1]; ++b)
+					for (int c = lo[2]; c <= hi[2]; ++c)
+					{
+						st->v[n][cell_offset_(a, b, c)] = get_value(f,
+								cell_point_(s, stagger, a, b, c));
+					}
+		}
+	}
+
+	/**
+	 *  \brief interpolate at local coordinates 'r' of the stencil cell, r in [0,1)
+	 */
+	template<typename TS>
+	typename TS::field_value_type gather_in_cell(TS const & st,
+			coordinates_type const & r) const
+	{
+		typename TS::field_value_type res;
+
+		for (size_t n = 0; n < TS::num_of_comps; ++n)
+		{
+			unsigned int stagger = stagger_(TS::iform, n);
+
+			Real wx[num_of_points], wy[num_of_points], wz[num_of_points];
+
+			int a = cell_weight_(r[0], (stagger & 1U) != 0, wx);
+			int b = cell_weight_(r[1], (stagger & 2U) != 0, wy);
+			int c = cell_weight_(r[2], (stagger & 4U) != 0, wz);
+
+			typename TS::value_type v = 0;
+
+			for (size_t i = 0; i < num_of_points; ++i)
+				for (size_t j = 0; j < num_of_points; ++j)
+				{
+					Real wxy = wx[i] * wy[j];
+
+					auto const * p = &st.v[n][cell_offset_(a + i, b + j, c)];
+
+					for (size_t k = 0; k < num_of_points; ++k)
+					{
+						v += p[k] * (wxy * wz[k]);
+					}
+				}
+
+			set_comp_(res, n, v);
+		}
+		return std::move(res);
+	}
+
+	/**
+	 *  \brief accumulate 'v' at local coordinates 'r' into the stencil,  r in [0,1)
+	 */
+	template<typename TS>
+	void scatter_in_cell(TS * st, coordinates_type const & r,
+			typename TS::field_value_type const & v) const
+	{
+		for (size_t n = 0; n < TS::num_of_comps; ++n)
+		{
+			unsigned int stagger = stagger_(TS::iform, n);
+
+			Real wx[num_of_points], wy[num_of_points], wz[num_of_points];
+
+			int a = cell_weight_(r[0], (stagger & 1U) != 0, wx);
+			int b = cell_weight_(r[1], (stagger & 2U) != 0, wy);
+			int c = cell_weight_(r[2], (stagger & 4U) != 0, wz);
+
+			auto const & u = get_comp_(v, n);
+
+			for (size_t i = 0; i < num_of_points; ++i)
+				for (size_t j = 0; j < num_of_points; ++j)
+				{
+					Real wxy = wx[i] * wy[j];
+
+					auto * p = &st->v[n][cell_offset_(a + i, b + j, c)];
+
+					for (size_t k = 0; k < num_of_points; ++k)
+					{
+						p[k] += u * (wxy * wz[k]);
+					}
+				}
+		}
+	}
+
+	/**
+	 *  \brief add  the accumulated stencil  to field 'f' around vertex cell 's'
+	 */
+	template<typename TF>
+	void scatter_cell(TF & f, typename G::index_type s,
+			cell_stencil_type<TF> const & st) const
+	{
+		typedef cell_stencil_type<TF> stencil_type;
+
+		for (size_t n = 0; n < stencil_type::num_of_comps; ++n)
+		{
+			unsigned int stagger = stagger_(stencil_type::iform, n);
+
+			int lo[3], hi[3];
+
+			for (int i = 0; i < 3; ++i)
+			{
+				cell_range_(((stagger >> i) & 1U) != 0, &lo[i], &hi[i]);
+			}
+
+			for (int a = lo[0]; a <= hi[0]; ++a)
+				for (int b = lo[1]; b <= hi[1]; ++b)
+					for (int c = lo[2]; c <= hi[2]; ++c)
+					{
+						auto const & v = st.v[n][cell_offset_(a, b, c)];
+
+						if (v != 0)
+						{
+							get_value(f, cell_point_(s, stagger, a, b, c)) += v;
+						}
+					}
+		}
+	}
+
+public:
+
+	template<typename TJ>
+	void scatter_esirkepov(TJ & J, coordinates_type const & x0,
+			coordinates_type const & x1, Real q, Real dt) const
+	{
+		InterpolatorLinear<G>(geo).scatter_esirkepov(J, x0, x1, q, dt);
+	}
+
+}
+;
+
+template<typename G> using InterpolatorQuadratic=InterpolatorBSpline<G,2>;
+
+template<typename G> using InterpolatorCubic=InterpolatorBSpline<G,3>;
+
+}
+// namespace simpla
+
+#endif /* INTERPOLATOR_BSPLINE_H_ */
@@ -0,0 +1,220 @@
+/**
+ * \file interpolator_bspline_test.cpp
+ *
+ * \date    2014年11月21日  下午2:10:36
+ * \author salmon
+ */
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <random>
+
+#include "interpolator_bspline.h"
+#include "interpolator_mock_test.h"
+
+using namespace simpla;
+
+template<typename TInterpolator>
+class TestBSpline: public testing::Test
+{
+protected:
+	void SetUp()
+	{
+		interpolator.geometry(&geometry);
+	}
+public:
+	typedef MockGeometry::coordinates_type coordinates_type;
+
+	MockGeometry geometry;
+
+	TInterpolator interpolator;
+
+	std::mt19937 gen;
+
+	coordinates_type random_point()
+	{
+		std::uniform_real_distribution<Real> dist(2, 3);
+		return coordinates_type( { dist(gen), dist(gen), dist(gen) });
+	}
+};
+
+typedef testing::Types<InterpolatorQuadratic<MockGeometry>,
+		InterpolatorCubic<MockGeometry> > BSplineTypes;
+
+TYPED_TEST_CASE(TestBSpline, BSplineTypes);
+
+/**
+ *  scatter of a unit charge: weights sum to one (partition of unity), the
+ *  weighted mean of the points is the position of the charge (first moment)
+ */
+TYPED_TEST(TestBSpline, partition_of_unity){
+{
+	for (int n = 0; n < 100; ++n)
+	{
+		auto x = TestFixture::random_point();
+
+		MockField<VERTEX> rho;
+
+		TestFixture::interpolator.scatter(rho, x, 1.0, 1.0);
+
+		EXPECT_EQ(std::pow(TypeParam::num_of_points, 3), rho.data.size());
+
+		Real sum = 0;
+
+		typename TestFixture::coordinates_type moment = { 0, 0, 0 };
+
+		for (auto const & item : rho.data)
+		{
+			sum += item.second;
+
+			moment += MockGeometry::coordinates(item.first) * item.second;
+		}
+
+		EXPECT_NEAR(1.0, sum, 1.0e-12);
+
+		for (int i = 0; i < 3; ++i)
+		{
+			EXPECT_NEAR(x[i], moment[i], 1.0e-12);
+		}
+
+		// each component of EDGE  on its own staggered points
+		MockField<EDGE> J;
+
+		typename TestFixture::coordinates_type u = { 1, 2, 3 };
+
+		TestFixture::interpolator.scatter(J, x, u, 1.0);
+
+		typename TestFixture::coordinates_type J_sum = { 0, 0, 0 };
+		typename TestFixture::coordinates_type J_moment[3];
+
+		for (int i = 0; i < 3; ++i)
+		{
+			J_moment[i] = typename TestFixture::coordinates_type( { 0, 0, 0 });
+		}
+
+		for (auto const & item : J.data)
+		{
+			int c = MockGeometry::component(item.first);
+
+			J_sum[c] += item.second;
+
+			J_moment[c] += MockGeometry::coordinates(item.first) * item.second;
+		}
+
+		for (int c = 0; c < 3; ++c)
+		{
+			EXPECT_NEAR(u[c], J_sum[c], 1.0e-12);
+
+			for (int i = 0; i < 3; ++i)
+			{
+				EXPECT_NEAR(u[c] * x[i], J_moment[c][i], 1.0e-12);
+			}
+		}
+	}
+}
+}
+
+/**
+ *  gather reproduces linear functions exactly
+ */
+TYPED_TEST(TestBSpline, gather_linear){
+{
+	MockField<VERTEX> f;
+	MockField<EDGE> E;
+
+	typename TestFixture::coordinates_type k = { 0.3, -0.7, 1.1 };
+
+	Real b = 0.5;
+
+	// vertices and x-edges  around [2,3)^3
+	for (int i = -1; i < 7; ++i)
+		for (int j = -1; j < 7; ++j)
+			for (int l = -1; l < 7; ++l)
+			{
+				typename TestFixture::coordinates_type x = { Real(i), Real(j), Real(l) };
+
+				auto s = std::get<0>(TestFixture::geometry.coordinates_global_to_local(x, 0UL));
+
+				f[s] = inner_product(k, x) + b;
+
+				x[0] += 0.5;
+				E[std::get<0>(TestFixture::geometry.coordinates_global_to_local(x, MockTopology::_DI))] =
+				inner_product(k, x);
+			}
+
+	for (int n = 0; n < 100; ++n)
+	{
+		auto x = TestFixture::random_point();
+
+		EXPECT_NEAR(inner_product(k, x) + b,
+				TestFixture::interpolator.gather(f, x), 1.0e-12);
+
+		EXPECT_NEAR(inner_product(k, x),
+				TestFixture::interpolator.gather(E, x)[0], 1.0e-12);
+	}
+}
+}
+
+/**
+ *  the per-cell interface gives the same values as gather/scatter
+ */
+TYPED_TEST(TestBSpline, cell_stencil){
+{
+	typedef typename TypeParam::template cell_stencil_type<MockField<EDGE>> stencil_type;
+
+	MockField<EDGE> E, J0, J1;
+
+	for (int n = 0; n < 1000; ++n)
+	{
+		auto x = TestFixture::random_point();
+
+		E[std::get<0>(TestFixture::geometry.coordinates_global_to_local(x, MockTopology::_DI))] = x[0];
+		E[std::get<0>(TestFixture::geometry.coordinates_global_to_local(x, MockTopology::_DK))] = x[2];
+	}
+
+	auto x0 = TestFixture::random_point();
+
+	auto s = std::get<0>(TestFixture::geometry.coordinates_global_to_local(x0, 0UL));
+
+	stencil_type E_st, J_st;
+
+	TestFixture::interpolator.gather_cell(E, s, &E_st);
+
+	J_st.clear();
+
+	for (int n = 0; n < 20; ++n)
+	{
+		auto x = TestFixture::random_point();
+
+		auto idx = TestFixture::geometry.coordinates_global_to_local(x, 0UL);
+
+		if (std::get<0>(idx) != s)
+		{
+			continue;
+		}
+
+		auto v0 = TestFixture::interpolator.gather(E, x);
+		auto v1 = TestFixture::interpolator.gather_in_cell(E_st, std::get<1>(idx));
+
+		for (int i = 0; i < 3; ++i)
+		{
+			EXPECT_NEAR(v0[i], v1[i], 1.0e-12);
+		}
+
+		typename TestFixture::coordinates_type u = { 1, -2, 3 };
+
+		TestFixture::interpolator.scatter(J0, x, u, 0.5);
+
+		TestFixture::interpolator.scatter_in_cell(&J_st, std::get<1>(idx), u * 0.5);
+	}
+
+	TestFixture::interpolator.scatter_cell(J1, s, J_st);
+
+	EXPECT_EQ(J0.data.size(), J1.data.size());
+
+	for (auto const & item : J0.data)
+	{
+		EXPECT_NEAR(item.second, J1[item.first], 1.0e-12);
+	}
+}
+}
@@ -0,0 +1,173 @@
+/**
+ * \file interpolator_esirkepov_test.cpp
+ *
+ * \date    2014年11月20日  上午9:40:02
+ * \author salmon
+ */
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <random>
+#include <set>
+
+#include "interpolator.h"
+#include "interpolator_mock_test.h"
+
+using namespace simpla;
+
+class TestEsirkepov: public testing::Test
+{
+protected:
+	void SetUp()
+	{
+		interpolator.geometry(&geometry);
+	}
+public:
+	typedef MockGeometry::coordinates_type coordinates_type;
+	typedef MockGeometry::index_type index_type;
+
+	MockGeometry geometry;
+
+	InterpolatorLinear<MockGeometry> interpolator;
+
+	std::mt19937 gen;
+
+	Real dt = 0.3;
+
+	coordinates_type random_point()
+	{
+		std::uniform_real_distribution<Real> dist(2, 3);
+		return coordinates_type( { dist(gen), dist(gen), dist(gen) });
+	}
+
+	/// displacement less than one cell, every third one is in a plane
+	coordinates_type random_step(int n)
+	{
+		std::uniform_real_distribution<Real> dist(-0.9, 0.9);
+
+		coordinates_type d = { dist(gen), dist(gen), dist(gen) };
+
+		if (n % 3 == 0)
+		{
+			d[2] = 0;
+		}
+		return d;
+	}
+
+	/**
+	 *  max over vertices of |rho1-rho0 + dt * div J - source|
+	 */
+	Real continuity_error(MockField<VERTEX> const & rho0,
+			MockField<VERTEX> const & rho1, MockField<EDGE> const & J,
+			MockField<VERTEX> const & source) const
+	{
+		index_type H[3] = { MockTopology::_DI, MockTopology::_DJ,
+				MockTopology::_DK };
+
+		std::set<index_type> vertices;
+
+		for (auto const & item : rho0.data)
+			vertices.insert(item.first);
+		for (auto const & item : rho1.data)
+			vertices.insert(item.first);
+		for (auto const & item : J.data)
+		{
+			index_type h = H[MockGeometry::component(item.first)];
+			vertices.insert(item.first - h);
+			vertices.insert(item.first + h);
+		}
+
+		Real res = 0;
+
+		for (auto v : vertices)
+		{
+			Real div = 0;
+
+			for (int i = 0; i < 3; ++i)
+			{
+				div += J[v + H[i]] - J[v - H[i]];
+			}
+
+			res = std::max(res,
+					std::abs(rho1[v] - rho0[v] + dt * div - source[v]));
+		}
+
+		return res;
+	}
+
+};
+
+TEST_F(TestEsirkepov, continuity)
+{
+	Real q = 0.7;
+
+	MockField<VERTEX> no_source;
+
+	for (int n = 0; n < 200; ++n)
+	{
+		MockField<EDGE> J;
+		MockField<VERTEX> rho0, rho1;
+
+		coordinates_type x0 = random_point();
+		coordinates_type x1 = x0 + random_step(n);
+
+		interpolator.scatter_esirkepov(J, x0, x1, q, dt);
+
+		interpolator.scatter(rho0, x0, q, 1.0);
+		interpolator.scatter(rho1, x1, q, 1.0);
+
+		EXPECT_LT(continuity_error(rho0, rho1, J, no_source), 1.0e-12);
+
+		// J summed over edges is q*(x1-x0)/dt
+		coordinates_type sum = { 0, 0, 0 };
+
+		for (auto const & item : J.data)
+		{
+			sum[MockGeometry::component(item.first)] += item.second;
+		}
+
+		for (int i = 0; i < 3; ++i)
+		{
+			EXPECT_NEAR(q * (x1[i] - x0[i]) / dt, sum[i], 1.0e-12);
+		}
+
+		// fixed stencil,  3x3 vertices x 2 edges for each direction
+		EXPECT_EQ(3 * 3 * 3 * 2, J.data.size());
+	}
+}
+
+/**
+ *  delta-f particle: the weight changes from w0 to w1 during the push, J is
+ *  deposited with the new weight. J is the current of the motion of charge
+ *  w1, the change w1-w0 is a source of charge at the old position, which is
+ *  the delta-f source term and not a current.
+ */
+TEST_F(TestEsirkepov, continuity_delta_f)
+{
+	for (int n = 0; n < 200; ++n)
+	{
+		std::uniform_real_distribution<Real> dist(-1, 1);
+
+		Real w0 = dist(gen), w1 = dist(gen);
+
+		MockField<EDGE> J;
+		MockField<VERTEX> rho0, rho1, source, rho0_w1;
+
+		coordinates_type x0 = random_point();
+		coordinates_type x1 = x0 + random_step(n);
+
+		interpolator.scatter_esirkepov(J, x0, x1, w1, dt);
+
+		interpolator.scatter(rho0, x0, w0, 1.0);
+		interpolator.scatter(rho0_w1, x0, w1, 1.0);
+		interpolator.scatter(rho1, x1, w1, 1.0);
+
+		interpolator.scatter(source, x0, w1 - w0, 1.0);
+
+		MockField<VERTEX> no_source;
+
+		EXPECT_LT(continuity_error(rho0_w1, rho1, J, no_source), 1.0e-12);
+
+		EXPECT_LT(continuity_error(rho0, rho1, J, source), 1.0e-12);
+	}
+}
@@ -0,0 +1,125 @@
+/**
+ * \file interpolator_mock_test.h
+ *
+ * \date    2014年11月20日  上午9:12:40
+ * \author salmon
+ *
+ *  unit Cartesian geometry and sparse fields for tests of the interpolators,
+ *  without the structured mesh
+ */
+
+#ifndef INTERPOLATOR_MOCK_TEST_H_
+#define INTERPOLATOR_MOCK_TEST_H_
+
+#include <cmath>
+#include <map>
+#include <tuple>
+
+#include "../../utilities/ntuple.h"
+#include "../../utilities/primitives.h"
+#include "../../utilities/sp_type_traits.h"
+
+namespace simpla
+{
+template<typename ...> class field_traits;
+
+struct MockTopology
+{
+	static constexpr size_t _DI = 1UL << 40;
+	static constexpr size_t _DJ = 1UL << 20;
+	static constexpr size_t _DK = 1UL;
+	static constexpr size_t _DA = _DI | _DJ | _DK;
+};
+
+/**
+ *  infinite mesh with unit cells, index of a point is 20 bits per axis of
+ *  half grid steps, offset by OFFSET cells
+ */
+struct MockGeometry
+{
+	typedef MockTopology topology_type;
+	typedef nTuple<Real, 3> coordinates_type;
+	typedef size_t index_type;
+
+	static constexpr size_t OFFSET = 1000;
+
+	coordinates_type dx(index_type = 0) const
+	{
+		return coordinates_type( { 1, 1, 1 });
+	}
+
+	std::tuple<index_type, coordinates_type> coordinates_global_to_local(
+			coordinates_type x, index_type shift) const
+	{
+		index_type sh[3] = { (shift >> 40) & 1, (shift >> 20) & 1, shift & 1 };
+
+		index_type unit[3] = { topology_type::_DI, topology_type::_DJ,
+				topology_type::_DK };
+
+		coordinates_type r;
+
+		index_type s = 0;
+
+		for (int i = 0; i < 3; ++i)
+		{
+			Real t = x[i] - 0.5 * sh[i];
+			Real fl = std::floor(t);
+			r[i] = t - fl;
+			s += (static_cast<index_type>(fl + OFFSET) * 2 + sh[i]) * unit[i];
+		}
+
+		return std::make_tuple(s, r);
+	}
+
+	coordinates_type coordinates_local_to_global(index_type s,
+			coordinates_type const & r) const
+	{
+		return coordinates(s) + r;
+	}
+
+	/// position of point 's'
+	static coordinates_type coordinates(index_type s)
+	{
+		return coordinates_type( {
+
+		static_cast<Real>((s >> 40) & 0xFFFFF) * 0.5 - OFFSET,
+
+		static_cast<Real>((s >> 20) & 0xFFFFF) * 0.5 - OFFSET,
+
+		static_cast<Real>(s & 0xFFFFF) * 0.5 - OFFSET
+
+		});
+	}
+
+	/// component of EDGE/FACE point 's' , 0,1,2
+	static int component(index_type s)
+	{
+		return ((s >> 40) & 1) ? 0 : (((s >> 20) & 1) ? 1 : 2);
+	}
+};
+
+template<size_t IFORM>
+struct MockField
+{
+	std::map<size_t, Real> data;
+
+	Real & operator[](size_t s)
+	{
+		return data[s];
+	}
+	Real operator[](size_t s) const
+	{
+		auto it = data.find(s);
+		return it == data.end() ? 0 : it->second;
+	}
+};
+
+template<size_t IFORM> struct field_traits<MockField<IFORM>>
+{
+	static constexpr size_t iform = IFORM;
+	typedef Real value_type;
+};
+
+}  // namespace simpla
+
+#endif /* INTERPOLATOR_MOCK_TEST_H_ */
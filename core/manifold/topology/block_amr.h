@@ -0,0 +1,967 @@
+/**
+ * \file block_amr.h
+ *
+ * \date    2014年11月14日  上午9:05:31
+ * \author salmon
+ */
+
+#ifndef BLOCK_AMR_H_
+#define BLOCK_AMR_H_
+
+#include <cstddef>
+#include <map>
+#include <vector>
+
+#include "../../utilities/ntuple.h"
+#include "../../utilities/primitives.h"
+#include "../../utilities/log.h"
+
+namespace simpla
+{
+
+/**
+ *  \ingroup Topology
+ *  \brief  prototype of block-structured adaptive mesh refinement, octree
+ *          of blocks
+ *
+ *   Prototype, standalone: blocks own plain std::vector storage, there is
+ *   no Field or ContainerPool binding, so neither fields nor KineticParticle
+ *   can live on the hierarchy yet, and no solver in the tree uses it.
+ *
+ *   Same tree as OcForest: every tree root is a block of level 0, a refined
+ *   block has 8 children of level+1 with half cell width. Every block,
+ *   leaf or not, carries BlockSize^3 cell-centered values and one ghost
+ *   layer; the leaves are the solution, inner blocks hold the restriction
+ *   of their children. Only cell-centered scalars (TV with + and * Real)
+ *   are supported, there are no staggered (edge/face) fields.
+ *
+ *   - fill_ghosts: same level copy, fine->coarse average (restriction),
+ *                  coarse->fine linear interpolation
+ *   - advance_conservative: finite volume update of the leaves, fluxes on
+ *                  coarse-fine faces are replaced by the sum of the fine
+ *                  fluxes (refluxing), so \f$\sum u\,dV\f$ is conserved
+ *   - regrid: refine/coarsen by a cell criterion, keeps 2:1 balance
+ *   - leaf_key: key of the leaf block containing x. It is only a hash,
+ *               i.e. of a ContainerPool, regrid moves no particles, pools
+ *               must be re-binned by ContainerPool::sort after regrid.
+ *
+ *   Domain boundaries are periodic or zero-gradient.
+ */
+template<typename TV>
+class BlockAMR
+{
+public:
+	typedef BlockAMR<TV> this_type;
+
+	typedef TV value_type;
+
+	typedef long index_type;
+
+	typedef nTuple<index_type, 3> index_tuple;
+
+	typedef nTuple<Real, 3> coordinates_type;
+
+	typedef unsigned long key_type;
+
+	static constexpr size_t ndims = 3;
+
+	static constexpr index_type GHOST_WIDTH = 1;
+
+	static constexpr size_t MAX_LEVEL = 15;
+
+	struct Block
+	{
+		size_t level;
+		index_tuple idx; //!< block index at its level
+		bool is_leaf;
+		std::vector<value_type> data;
+	};
+
+	typedef std::map<key_type, Block> container_type;
+
+private:
+
+	static constexpr unsigned int KEY_DIGITS = 20;
+
+	static constexpr key_type KEY_MASK = (1UL << KEY_DIGITS) - 1;
+
+	index_type block_size_ = 8;
+
+	index_tuple root_dims_;
+
+	coordinates_type xmin_, xmax_;
+
+	nTuple<bool, 3> periodic_;
+
+	size_t max_level_ = 0;
+
+	container_type blocks_;
+
+public:
+
+	BlockAMR()
+	{
+	}
+
+	~BlockAMR()
+	{
+	}
+
+	BlockAMR(this_type const &) = delete;
+
+	this_type & operator=(this_type const &) = delete;
+
+	static std::string get_type_as_string()
+	{
+		return "BlockAMR";
+	}
+
+	template<typename TDict>
+	bool load(TDict const & dict)
+	{
+		if (!dict)
+			return false;
+
+		try
+		{
+			init(dict["Dimensions"].template as<index_tuple>(),
+					dict["BlockSize"].template as<index_type>(8),
+					dict["Min"].template as<coordinates_type>(),
+					dict["Max"].template as<coordinates_type>(),
+					dict["MaxLevel"].template as<size_t>(2),
+					dict["Periodic"].template as<nTuple<bool, 3>>(
+							nTuple<bool, 3>( { true, true, true })));
+		} catch (...)
+		{
+			PARSER_ERROR("Configure BlockAMR error!");
+		}
+
+		return true;
+	}
+
+	template<typename OS>
+	OS & print(OS & os) const
+	{
+		os << "\tBlockAMR = { Dimensions = " << root_dims_ << ", BlockSize = "
+				<< block_size_ << ", MaxLevel = " << max_level_
+				<< ", NumOfBlocks = " << blocks_.size() << " }," << std::endl;
+		return os;
+	}
+
+	/**
+	 * @param root_dims   number of level 0 blocks
+	 * @param block_size  cells per block along each axis
+	 */
+	void init(index_tuple const & root_dims, index_type block_size,
+			coordinates_type const & xmin, coordinates_type const & xmax,
+			size_t max_level = 2, nTuple<bool, 3> const & periodic = nTuple<
+					bool, 3>( { true, true, true }),
+			value_type const & v = value_type())
+	{
+		if (block_size <= 0 || max_level > MAX_LEVEL)
+		{
+			RUNTIME_ERROR("BlockAMR: illegal block size or max level");
+		}
+
+		root_dims_ = root_dims;
+		block_size_ = block_size;
+		xmin_ = xmin;
+		xmax_ = xmax;
+		max_level_ = max_level;
+		periodic_ = periodic;
+
+		blocks_.clear();
+
+		index_tuple b;
+
+		for (b[0] = 0; b[0] < root_dims_[0]; ++b[0])
+			for (b[1] = 0; b[1] < root_dims_[1]; ++b[1])
+				for (b[2] = 0; b[2] < root_dims_[2]; ++b[2])
+				{
+					Block & blk = blocks_[make_key(0, b)];
+					blk.level = 0;
+					blk.idx = b;
+					blk.is_leaf = true;
+					blk.data.resize(num_of_cells_with_ghost(), v);
+				}
+	}
+
+	index_type block_size() const
+	{
+		return block_size_;
+	}
+	size_t max_level() const
+	{
+		return max_level_;
+	}
+	size_t num_of_blocks() const
+	{
+		return blocks_.size();
+	}
+	size_t num_of_leaves() const
+	{
+		size_t count = 0;
+		for (auto const & item : blocks_)
+		{
+			if (item.second.is_leaf)
+				++count;
+		}
+		return count;
+	}
+	size_t num_of_cells_with_ghost() const
+	{
+		index_type m = block_size_ + 2 * GHOST_WIDTH;
+		return m * m * m;
+	}
+
+	typename container_type::iterator begin()
+	{
+		return blocks_.begin();
+	}
+	typename container_type::iterator end()
+	{
+		return blocks_.end();
+	}
+	typename container_type::const_iterator begin() const
+	{
+		return blocks_.begin();
+	}
+	typename container_type::const_iterator end() const
+	{
+		return blocks_.end();
+	}
+
+	Block const * find(size_t level, index_tuple const & b) const
+	{
+		auto it = blocks_.find(make_key(level, b));
+		return it == blocks_.end() ? nullptr : &(it->second);
+	}
+
+	static key_type make_key(size_t level, index_tuple const & b)
+	{
+		return (static_cast<key_type>(level) << (KEY_DIGITS * 3))
+				| ((static_cast<key_type>(b[0]) & KEY_MASK) << (KEY_DIGITS * 2))
+				| ((static_cast<key_type>(b[1]) & KEY_MASK) << (KEY_DIGITS))
+				| (static_cast<key_type>(b[2]) & KEY_MASK);
+	}
+
+	/// cell width at 'level'
+	coordinates_type dx(size_t level) const
+	{
+		coordinates_type res;
+		for (int n = 0; n < 3; ++n)
+		{
+			res[n] = (xmax_[n] - xmin_[n])
+					/ static_cast<Real>((root_dims_[n] * block_size_) << level);
+		}
+		return res;
+	}
+
+	Real cell_volume(size_t level) const
+	{
+		return NProduct(dx(level));
+	}
+
+	/// i,j,k in [-GHOST_WIDTH, BlockSize+GHOST_WIDTH)
+	size_t local_index(index_type i, index_type j, index_type k) const
+	{
+		index_type m = block_size_ + 2 * GHOST_WIDTH;
+		return ((i + GHOST_WIDTH) * m + (j + GHOST_WIDTH)) * m + k
+				+ GHOST_WIDTH;
+	}
+
+	value_type & at(Block & b, index_type i, index_type j, index_type k) const
+	{
+		return b.data[local_index(i, j, k)];
+	}
+	value_type const & at(Block const & b, index_type i, index_type j,
+			index_type k) const
+	{
+		return b.data[local_index(i, j, k)];
+	}
+
+	/// center of cell (i,j,k) of block 'b'
+	coordinates_type coordinates(Block const & b, index_type i, index_type j,
+			index_type k) const
+	{
+		auto d = dx(b.level);
+		index_tuple l = { i, j, k };
+		coordinates_type res;
+		for (int n = 0; n < 3; ++n)
+		{
+			res[n] = xmin_[n]
+					+ (static_cast<Real>(b.idx[n] * block_size_ + l[n]) + 0.5)
+							* d[n];
+		}
+		return res;
+	}
+
+	/// key of the leaf block containing 'x', valid until the next regrid
+	key_type leaf_key(coordinates_type const & x) const
+	{
+		size_t level = 0;
+
+		while (true)
+		{
+			auto d = dx(level);
+			index_tuple b;
+			for (int n = 0; n < 3; ++n)
+			{
+				index_type g = static_cast<index_type>(std::floor(
+						(x[n] - xmin_[n]) / d[n]));
+				b[n] = wrap_(level, n, g) / block_size_;
+			}
+
+			key_type key = make_key(level, b);
+
+			auto it = blocks_.find(key);
+
+			if (it == blocks_.end())
+			{
+				RUNTIME_ERROR("BlockAMR: broken tree");
+			}
+
+			if (it->second.is_leaf)
+			{
+				return key;
+			}
+			++level;
+		}
+		return 0;
+	}
+
+	/// fill every cell of the leaves by fun(x)
+	template<typename TFun>
+	void assign(TFun const & fun)
+	{
+		for (auto & item : blocks_)
+		{
+			Block & b = item.second;
+			for (index_type i = 0; i < block_size_; ++i)
+				for (index_type j = 0; j < block_size_; ++j)
+					for (index_type k = 0; k < block_size_; ++k)
+					{
+						at(b, i, j, k) = fun(coordinates(b, i, j, k));
+					}
+		}
+	}
+
+	/// \f$\sum_{leaf} u\, dV\f$
+	value_type integrate() const
+	{
+		value_type res = 0;
+		for (auto const & item : blocks_)
+		{
+			Block const & b = item.second;
+			if (!b.is_leaf)
+				continue;
+
+			value_type s = 0;
+			for (index_type i = 0; i < block_size_; ++i)
+				for (index_type j = 0; j < block_size_; ++j)
+					for (index_type k = 0; k < block_size_; ++k)
+					{
+						s += at(b, i, j, k);
+					}
+			res += s * cell_volume(b.level);
+		}
+		return res;
+	}
+
+	void refine(key_type key);
+
+	void coarsen(key_type key);
+
+	void restrict_all();
+
+	void fill_ghosts();
+
+	template<typename TFun>
+	void regrid(TFun const & tag);
+
+	template<typename TFlux>
+	void advance_conservative(Real dt, TFlux const & flux);
+
+private:
+
+	index_type level_extent_(size_t level, int n) const
+	{
+		return (root_dims_[n] * block_size_) << level;
+	}
+
+	/// periodic wrap or clamp of global cell index 'g' on axis 'n'
+	index_type wrap_(size_t level, int n, index_type g) const
+	{
+		index_type e = level_extent_(level, n);
+
+		if (periodic_[n])
+		{
+			g %= e;
+			return g < 0 ? g + e : g;
+		}
+		else
+		{
+			return g < 0 ? 0 : (g >= e ? e - 1 : g);
+		}
+	}
+
+	/// neighbour block index, false if it is outside of a non-periodic domain
+	bool neighbour_(size_t level, index_tuple b, int n, index_type shift,
+			index_tuple * res) const
+	{
+		index_type e = root_dims_[n] << level;
+
+		b[n] += shift;
+
+		if (b[n] < 0 || b[n] >= e)
+		{
+			if (!periodic_[n])
+				return false;
+			b[n] = (b[n] % e + e) % e;
+		}
+		*res = b;
+		return true;
+	}
+
+	/// value of global cell 'g' at 'level', or of the coarser cell covering it
+	value_type sample_(size_t level, index_tuple g) const
+	{
+		while (true)
+		{
+			index_tuple b;
+			for (int n = 0; n < 3; ++n)
+			{
+				b[n] = g[n] / block_size_;
+			}
+
+			auto it = blocks_.find(make_key(level, b));
+
+			if (it != blocks_.end())
+			{
+				return at(it->second, g[0] - b[0] * block_size_,
+						g[1] - b[1] * block_size_, g[2] - b[2] * block_size_);
+			}
+			--level;
+			for (int n = 0; n < 3; ++n)
+			{
+				g[n] >>= 1;
+			}
+		}
+		return value_type();
+	}
+
+	/**
+	 *  value of global cell 'g' at 'level', if 'g' is not in a block of
+	 *  'level',  trilinear interpolation of the 8 nearest cells of level-1
+	 */
+	value_type interpolate_(size_t level, index_tuple const & g) const
+	{
+		index_tuple b;
+		for (int n = 0; n < 3; ++n)
+		{
+			b[n] = g[n] / block_size_;
+		}
+
+		if (level == 0 || blocks_.find(make_key(level, b)) != blocks_.end())
+		{
+			return sample_(level, g);
+		}
+
+		// coarse cell, side of the fine cell center in it
+		index_tuple c, side;
+		for (int n = 0; n < 3; ++n)
+		{
+			c[n] = g[n] >> 1;
+			side[n] = (g[n] & 1) ? 1 : -1;
+		}
+
+		value_type res = 0;
+
+		for (int q = 0; q < 8; ++q)
+		{
+			index_tuple id;
+			Real w = 1.0;
+
+			for (int n = 0; n < 3; ++n)
+			{
+				if ((q >> n) & 1)
+				{
+					id[n] = wrap_(level - 1, n, c[n] + side[n]);
+					w *= 0.25;
+				}
+				else
+				{
+					id[n] = c[n];
+					w *= 0.75;
+				}
+			}
+
+			res += sample_(level - 1, id) * w;
+		}
+
+		return res;
+	}
+
+	bool has_grand_children_(Block const & b) const
+	{
+		if (b.is_leaf)
+			return false;
+
+		for (int c = 0; c < 8; ++c)
+		{
+			index_tuple cb = { 2 * b.idx[0] + ((c >> 2) & 1), 2 * b.idx[1]
+					+ ((c >> 1) & 1), 2 * b.idx[2] + (c & 1) };
+
+			auto it = blocks_.find(make_key(b.level + 1, cb));
+
+			if (it != blocks_.end() && !it->second.is_leaf)
+				return true;
+		}
+		return false;
+	}
+	/// average of the 8 fine cells under coarse global cell 'g' of 'level'
+	value_type restrict_cell_(size_t level, index_tuple const & g) const
+	{
+		value_type s = 0;
+
+		for (int c = 0; c < 8; ++c)
+		{
+			index_tuple f = { 2 * g[0] + ((c >> 2) & 1), 2 * g[1]
+					+ ((c >> 1) & 1), 2 * g[2] + (c & 1) };
+			s += sample_(level + 1, f);
+		}
+		return s * 0.125;
+	}
+};
+
+/**
+ *  split a leaf into 8 children, piecewise constant prolongation
+ */
+template<typename TV>
+void BlockAMR<TV>::refine(key_type key)
+{
+	auto it = blocks_.find(key);
+
+	if (it == blocks_.end() || !it->second.is_leaf
+			|| it->second.level >= max_level_)
+	{
+		return;
+	}
+
+	Block & parent = it->second;
+
+	parent.is_leaf = false;
+
+	size_t level = parent.level + 1;
+
+	for (int c = 0; c < 8; ++c)
+	{
+		index_tuple cb = { 2 * parent.idx[0] + ((c >> 2) & 1), 2
+				* parent.idx[1] + ((c >> 1) & 1), 2 * parent.idx[2] + (c & 1) };
+
+		Block & child = blocks_[make_key(level, cb)];
+		child.level = level;
+		child.idx = cb;
+		child.is_leaf = true;
+		child.data.resize(num_of_cells_with_ghost());
+
+		for (index_type i = 0; i < block_size_; ++i)
+			for (index_type j = 0; j < block_size_; ++j)
+				for (index_type k = 0; k < block_size_; ++k)
+				{
+					at(child, i, j, k) = at(parent,
+							((cb[0] * block_size_ + i) >> 1)
+									- parent.idx[0] * block_size_,
+							((cb[1] * block_size_ + j) >> 1)
+									- parent.idx[1] * block_size_,
+							((cb[2] * block_size_ + k) >> 1)
+									- parent.idx[2] * block_size_);
+				}
+	}
+}
+
+/**
+ *  remove the 8 children of 'key', they must be leaves
+ */
+template<typename TV>
+void BlockAMR<TV>::coarsen(key_type key)
+{
+	auto it = blocks_.find(key);
+
+	if (it == blocks_.end() || it->second.is_leaf
+			|| has_grand_children_(it->second))
+	{
+		return;
+	}
+
+	Block & parent = it->second;
+
+	index_tuple g;
+
+	for (index_type i = 0; i < block_size_; ++i)
+		for (index_type j = 0; j < block_size_; ++j)
+			for (index_type k = 0; k < block_size_; ++k)
+			{
+				g = index_tuple( { parent.idx[0] * block_size_ + i,
+						parent.idx[1] * block_size_ + j, parent.idx[2]
+								* block_size_ + k });
+
+				at(parent, i, j, k) = restrict_cell_(parent.level, g);
+			}
+
+	for (int c = 0; c < 8; ++c)
+	{
+		index_tuple cb = { 2 * parent.idx[0] + ((c >> 2) & 1), 2
+				* parent.idx[1] + ((c >> 1) & 1), 2 * parent.idx[2] + (c & 1) };
+
+		blocks_.erase(make_key(parent.level + 1, cb));
+	}
+
+	parent.is_leaf = true;
+}
+
+/**
+ *  inner blocks <- average of children, finest level first
+ */
+template<typename TV>
+void BlockAMR<TV>::restrict_all()
+{
+	for (size_t level = max_level_; level-- > 0;)
+	{
+		for (auto & item : blocks_)
+		{
+			Block & b = item.second;
+
+			if (b.level != level || b.is_leaf)
+				continue;
+
+			for (index_type i = 0; i < block_size_; ++i)
+				for (index_type j = 0; j < block_size_; ++j)
+					for (index_type k = 0; k < block_size_; ++k)
+					{
+						at(b, i, j, k) = restrict_cell_(level, index_tuple( {
+								b.idx[0] * block_size_ + i, b.idx[1]
+										* block_size_ + j, b.idx[2]
+										* block_size_ + k }));
+					}
+		}
+	}
+}
+
+/**
+ *  ghost cells of the leaves, from the same level if it exists (inner blocks
+ *  hold the restriction of finer leaves), else linear interpolation of the
+ *  coarser level
+ */
+template<typename TV>
+void BlockAMR<TV>::fill_ghosts()
+{
+	restrict_all();
+
+	index_type lo = -GHOST_WIDTH, hi = block_size_ + GHOST_WIDTH;
+
+	for (auto & item : blocks_)
+	{
+		Block & b = item.second;
+
+		if (!b.is_leaf)
+			continue;
+
+		for (index_type i = lo; i < hi; ++i)
+			for (index_type j = lo; j < hi; ++j)
+				for (index_type k = lo; k < hi; ++k)
+				{
+					if (i >= 0 && i < block_size_ && j >= 0 && j < block_size_
+							&& k >= 0 && k < block_size_)
+						continue;
+
+					index_tuple l = { i, j, k };
+					index_tuple g;
+					for (int n = 0; n < 3; ++n)
+					{
+						g[n] = wrap_(b.level, n, b.idx[n] * block_size_ + l[n]);
+					}
+
+					at(b, i, j, k) = interpolate_(b.level, g);
+				}
+	}
+}
+
+/**
+ *  \brief refine leaves with a tagged cell, coarsen parents without
+ *
+ *  'tag(x,v)' is the criterion of a cell with center 'x' and value 'v'.
+ *  After refinement, leaves are refined until neighbour levels differ by
+ *  at most one.
+ */
+template<typename TV>
+template<typename TFun>
+void BlockAMR<TV>::regrid(TFun const & tag)
+{
+	restrict_all();
+
+	auto is_tagged = [&](Block const & b)
+	{
+		for (index_type i = 0; i < block_size_; ++i)
+		for (index_type j = 0; j < block_size_; ++j)
+		for (index_type k = 0; k < block_size_; ++k)
+		{
+			if (tag(coordinates(b, i, j, k), at(b, i, j, k)))
+			return true;
+		}
+		return false;
+	};
+
+	std::vector<key_type> to_refine, to_coarsen;
+
+	for (auto const & item : blocks_)
+	{
+		Block const & b = item.second;
+
+		if (b.is_leaf)
+		{
+			if (b.level < max_level_ && is_tagged(b))
+				to_refine.push_back(item.first);
+		}
+		else if (!has_grand_children_(b) && !is_tagged(b))
+		{
+			to_coarsen.push_back(item.first);
+		}
+	}
+
+	for (auto key : to_coarsen)
+	{
+		// keep 2:1 balance, no finer than level+1 next to the coarsened block
+		Block const & b = blocks_[key];
+
+		bool balanced = true;
+
+		for (int n = 0; n < 3 && balanced; ++n)
+			for (index_type shift :
+			{ -1, 1 })
+			{
+				index_tuple nb;
+				if (!neighbour_(b.level, b.idx, n, shift, &nb))
+					continue;
+				auto it = blocks_.find(make_key(b.level, nb));
+				if (it != blocks_.end() && has_grand_children_(it->second))
+				{
+					balanced = false;
+					break;
+				}
+			}
+
+		if (balanced)
+			coarsen(key);
+	}
+
+	for (auto key : to_refine)
+	{
+		refine(key);
+	}
+
+	// 2:1 balance
+	bool changed = true;
+
+	while (changed)
+	{
+		changed = false;
+
+		std::vector<key_type> keys;
+
+		for (auto const & item : blocks_)
+		{
+			Block const & b = item.second;
+
+			if (!b.is_leaf || b.level < 2)
+				continue;
+
+			for (int n = 0; n < 3; ++n)
+				for (index_type shift :
+				{ -1, 1 })
+				{
+					index_tuple nb;
+
+					if (!neighbour_(b.level - 1, b.idx / 2, n, shift, &nb))
+						continue;
+
+					// refine the leaf covering 'nb' until level-1 exists
+					size_t level = b.level - 1;
+
+					while (blocks_.find(make_key(level, nb)) == blocks_.end())
+					{
+						--level;
+						nb = nb / 2;
+					}
+
+					if (level + 1 < b.level)
+					{
+						keys.push_back(make_key(level, nb));
+					}
+				}
+		}
+
+		for (auto key : keys)
+		{
+			auto it = blocks_.find(key);
+			if (it != blocks_.end() && it->second.is_leaf)
+			{
+				refine(key);
+				changed = true;
+			}
+		}
+	}
+}
+
+/**
+ *  \brief  \f$ u \leftarrow u - dt\,\nabla\cdot F \f$ on the leaves
+ *
+ *  'flux(uL,uR,n)' is the numerical flux through the face between uL and uR
+ *  normal to axis n. Coarse faces next to a refined neighbour take the
+ *  average of the four fine face fluxes (refluxing).
+ */
+template<typename TV>
+template<typename TFlux>
+void BlockAMR<TV>::advance_conservative(Real dt, TFlux const & flux)
+{
+	fill_ghosts();
+
+	index_type N = block_size_;
+
+	index_type num_of_faces = (N + 1) * N * N;
+
+	// face flux [n][ face index along n, t0, t1 ]
+	auto face_index = [=](int n, index_type f, index_type a, index_type b)
+	{
+		return (f*N+a)*N+b;
+	};
+
+	auto cell = [=](int n, index_type f, index_type a, index_type b)
+	{
+		index_tuple l;
+		l[n]=f;
+		l[(n+1)%3]=a;
+		l[(n+2)%3]=b;
+		return l;
+	};
+
+	std::map<key_type, std::vector<value_type>> fluxes;
+
+	for (auto & item : blocks_)
+	{
+		Block & b = item.second;
+
+		if (!b.is_leaf)
+			continue;
+
+		auto & F = fluxes[item.first];
+
+		F.resize(3 * num_of_faces);
+
+		for (int n = 0; n < 3; ++n)
+			for (index_type f = 0; f <= N; ++f)
+				for (index_type a = 0; a < N; ++a)
+					for (index_type c = 0; c < N; ++c)
+					{
+						index_tuple r = cell(n, f, a, c);
+						index_tuple l = r;
+						l[n] -= 1;
+
+						F[n * num_of_faces + face_index(n, f, a, c)] = flux(
+								at(b, l[0], l[1], l[2]), at(b, r[0], r[1], r[2]),
+								n);
+					}
+	}
+
+	// refluxing
+	for (auto & item : blocks_)
+	{
+		Block & b = item.second;
+
+		if (!b.is_leaf)
+			continue;
+
+		auto & F = fluxes[item.first];
+
+		for (int n = 0; n < 3; ++n)
+			for (index_type shift :
+			{ -1, 1 })
+			{
+				index_tuple nb;
+
+				if (!neighbour_(b.level, b.idx, n, shift, &nb))
+					continue;
+
+				auto it = blocks_.find(make_key(b.level, nb));
+
+				if (it == blocks_.end() || it->second.is_leaf)
+					continue;
+
+				// face of 'b' and fine face in the children of 'nb'
+				index_type f = (shift > 0) ? N : 0;
+
+				index_type fine_f = (shift > 0) ? 0 : N;
+
+				int n1 = (n + 1) % 3, n2 = (n + 2) % 3;
+
+				for (index_type a = 0; a < N; ++a)
+					for (index_type c = 0; c < N; ++c)
+					{
+						value_type s = 0;
+
+						for (int q = 0; q < 4; ++q)
+						{
+							index_tuple gf; // fine global transverse cell
+							gf[n1] = 2 * (b.idx[n1] * N + a) + ((q >> 1) & 1);
+							gf[n2] = 2 * (b.idx[n2] * N + c) + (q & 1);
+
+							index_tuple cb;
+							cb[n] = 2 * nb[n] + ((shift > 0) ? 0 : 1);
+							cb[n1] = gf[n1] / N;
+							cb[n2] = gf[n2] / N;
+
+							auto const & fF = fluxes[make_key(b.level + 1, cb)];
+
+							s += fF[n * num_of_faces
+									+ face_index(n, fine_f, gf[n1] - cb[n1] * N,
+											gf[n2] - cb[n2] * N)];
+						}
+
+						F[n * num_of_faces + face_index(n, f, a, c)] = s * 0.25;
+					}
+			}
+	}
+
+	for (auto & item : blocks_)
+	{
+		Block & b = item.second;
+
+		if (!b.is_leaf)
+			continue;
+
+		auto const & F = fluxes[item.first];
+
+		auto d = dx(b.level);
+
+		for (int n = 0; n < 3; ++n)
+		{
+			Real a = dt / d[n];
+
+			for (index_type f = 0; f < N; ++f)
+				for (index_type t0 = 0; t0 < N; ++t0)
+					for (index_type t1 = 0; t1 < N; ++t1)
+					{
+						index_tuple l = cell(n, f, t0, t1);
+
+						at(b, l[0], l[1], l[2]) -= a
+								* (F[n * num_of_faces + face_index(n, f + 1, t0, t1)]
+										- F[n * num_of_faces
+												+ face_index(n, f, t0, t1)]);
+					}
+		}
+	}
+}
+
+}  // namespace simpla
+
+#endif /* BLOCK_AMR_H_ */
@@ -2367,6 +2367,36 @@ inline StructuredMesh::range_type split(
 	return std::move(StructuredMesh::range_type(range.mesh, b, e, shift));
 }
 
+/**
+ *  number of cells along the axis that split(range,...) cuts, the longest one
+ */
+inline size_t split_extent(StructuredMesh::range_type const & range)
+{
+	static constexpr size_t ndims = StructuredMesh::ndims;
+
+	StructuredMesh::iterator ib = begin(range);
+	StructuredMesh::iterator ie = end(range);
+
+	if (!(ib != ie))
+	{
+		return 0;
+	}
+
+	auto b = ib.self_;
+	decltype(b) e = (--ie).self_ + 1;
+
+	decltype(b) count = e - b;
+
+	size_t L = 0;
+
+	for (int i = 0; i < ndims; ++i)
+	{
+		L = std::max(L, static_cast<size_t>(count[i]));
+	}
+
+	return L;
+}
+
 }
 // namespace simpla
 
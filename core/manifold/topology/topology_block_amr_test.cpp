@@ -0,0 +1,263 @@
+/*
+ * @file topology_block_amr_test.cpp
+ *
+ * @date created on: 2014-11-14
+ *      @Author: salmon
+ */
+
+#include <gtest/gtest.h>
+#include <cmath>
+
+#include "../../utilities/log.h"
+#include "../../utilities/container_pool.h"
+#include "block_amr.h"
+
+using namespace simpla;
+
+class TestBlockAMR: public testing::Test
+{
+protected:
+	void SetUp()
+	{
+		LOGGER.set_stdout_visable_level(10);
+
+		amr.init(nTuple<long, 3>( { 2, 2, 2 }), 4, xmin, xmax, 2);
+
+		amr.assign([&](coordinates_type const & x)
+		{
+			return profile(x);
+		});
+	}
+public:
+	typedef BlockAMR<Real> amr_type;
+	typedef typename amr_type::coordinates_type coordinates_type;
+
+	amr_type amr;
+
+	coordinates_type xmin = { 0, 0, 0 };
+	coordinates_type xmax = { 1, 1, 1 };
+
+	static Real profile(coordinates_type const & x)
+	{
+		return std::exp(-50.0 * ((x[0] - 0.3) * (x[0] - 0.3)
+				+ (x[1] - 0.5) * (x[1] - 0.5)));
+	}
+
+	// refine where the profile is steep
+	std::function<bool(coordinates_type const &, Real)> tag =
+			[](coordinates_type const & x, Real v)
+			{
+				return v > 0.3 && v < 0.9;
+			};
+};
+
+TEST_F(TestBlockAMR, regrid)
+{
+	EXPECT_EQ(8, amr.num_of_leaves());
+
+	amr.regrid(tag);
+
+	amr.assign([&](coordinates_type const & x)
+	{
+		return profile(x);
+	});
+
+	amr.regrid(tag);
+
+	EXPECT_GT(amr.num_of_leaves(), 8);
+
+	size_t max_level = 0;
+
+	for (auto const & item : amr)
+	{
+		auto const & b = item.second;
+
+		max_level = std::max(max_level, b.level);
+
+		if (!b.is_leaf)
+			continue;
+
+		// 2:1 balance of face neighbours
+		for (int n = 0; n < 3; ++n)
+			for (long shift :
+			{ -1, 1 })
+			{
+				if (b.level < 2)
+					continue;
+
+				typename amr_type::index_tuple nb = b.idx / 2;
+				nb[n] = ((nb[n] + shift) % (2L << (b.level - 1)) + (2L << (b.level - 1)))
+						% (2L << (b.level - 1));
+
+				EXPECT_NE(nullptr, amr.find(b.level - 1, nb));
+			}
+	}
+
+	EXPECT_EQ(2, max_level);
+
+	// nothing tagged, coarsened back to the roots
+	amr.regrid([](coordinates_type const &, Real)
+	{
+		return false;
+	});
+
+	amr.regrid([](coordinates_type const &, Real)
+	{
+		return false;
+	});
+
+	EXPECT_EQ(8, amr.num_of_leaves());
+}
+
+TEST_F(TestBlockAMR, ghosts)
+{
+	amr.regrid(tag);
+	amr.regrid(tag);
+
+	amr.assign([](coordinates_type const & x)
+	{
+		return 1.0;
+	});
+
+	amr.fill_ghosts();
+
+	for (auto const & item : amr)
+	{
+		auto const & b = item.second;
+
+		if (!b.is_leaf)
+			continue;
+
+		for (auto v : b.data)
+		{
+			EXPECT_DOUBLE_EQ(1.0, v);
+		}
+	}
+}
+
+/**
+ *  coarse->fine ghosts are interpolated linearly, exact for linear profiles
+ */
+TEST_F(TestBlockAMR, ghosts_linear)
+{
+	amr_type amr1;
+
+	amr1.init(nTuple<long, 3>( { 2, 2, 2 }), 4, xmin, xmax, 1, nTuple<bool, 3>( {
+			false, false, false }));
+
+	amr1.refine(amr_type::make_key(0, typename amr_type::index_tuple( { 0, 0, 0 })));
+
+	auto linear = [](coordinates_type const & x)
+	{
+		return 1.0+2.0*x[0]+3.0*x[1]-x[2];
+	};
+
+	amr1.assign(linear);
+
+	amr1.fill_ghosts();
+
+	long N = amr1.block_size();
+
+	// fine cells with a coarse neighbour, away from the domain boundary
+	long lo = 2, hi = 2 * 2 * N - 2;
+
+	size_t count = 0;
+
+	for (auto const & item : amr1)
+	{
+		auto const & b = item.second;
+
+		if (!b.is_leaf || b.level != 1)
+			continue;
+
+		for (long i = -1; i <= N; ++i)
+			for (long j = -1; j <= N; ++j)
+				for (long k = -1; k <= N; ++k)
+				{
+					typename amr_type::index_tuple g = { b.idx[0] * N + i, b.idx[1]
+							* N + j, b.idx[2] * N + k };
+
+					if (g[0] < lo || g[0] >= hi || g[1] < lo || g[1] >= hi
+							|| g[2] < lo || g[2] >= hi)
+						continue;
+
+					// inside the refined root block
+					if (g[0] < 2 * N && g[1] < 2 * N && g[2] < 2 * N)
+						continue;
+
+					EXPECT_NEAR(linear(amr1.coordinates(b, i, j, k)),
+							amr1.at(b, i, j, k), 1.0e-12);
+
+					++count;
+				}
+	}
+
+	EXPECT_GT(count, 0);
+}
+
+TEST_F(TestBlockAMR, reflux)
+{
+	amr.regrid(tag);
+	amr.regrid(tag);
+
+	Real total = amr.integrate();
+
+	coordinates_type a = { 1.0, 0.5, 0.25 };
+
+	// upwind advection, flux  = a u
+	for (int step = 0; step < 10; ++step)
+	{
+		amr.advance_conservative(0.01, [&](Real l, Real r, int n)
+		{
+			return a[n] * l;
+		});
+	}
+
+	EXPECT_NEAR(total, amr.integrate(), 1.0e-12 * std::abs(total));
+}
+
+TEST_F(TestBlockAMR, particle_pool)
+{
+	amr.regrid(tag);
+	amr.regrid(tag);
+
+	typedef coordinates_type point_type;
+
+	ContainerPool<typename amr_type::key_type, point_type> pool(
+			[&](point_type const & x)
+			{
+				return amr.leaf_key(x);
+			});
+
+	for (int i = 0; i < 100; ++i)
+	{
+		pool.insert(point_type( { (i % 10) * 0.1 + 0.05, (i / 10) * 0.1 + 0.05,
+				0.5 }));
+	}
+
+	for (auto const & item : pool)
+	{
+		for (auto const & x : item.second)
+		{
+			EXPECT_EQ(item.first, amr.leaf_key(x));
+		}
+	}
+
+	EXPECT_EQ(100, pool.size());
+
+	// blocks follow the hierarchy after regrid
+	amr.regrid([](coordinates_type const &, Real)
+	{
+		return false;
+	});
+
+	pool.sort();
+
+	EXPECT_EQ(100, pool.size());
+
+	for (auto const & item : pool)
+		for (auto const & x : item.second)
+		{
+			EXPECT_EQ(item.first, amr.leaf_key(x));
+		}
+}
@@ -23,6 +23,7 @@
 #include "../utilities/utilities.h"
 #include "../utilities/sp_iterator_filter.h"
 #include "../utilities/sp_range_filter.h"
+#include "../utilities/sp_range_indexed.h"
 #include "../utilities/sp_type_traits.h"
 
 #include "../numeric/pointinpolygon.h"
@@ -276,8 +277,25 @@ public:
 		{	return m&(~t);});
 	}
 
+	/**
+	 *  selection is evaluated once and materialized as a sorted index list,
+	 *  which is cheap to iterate, split and intersect. Slabs of split are
+	 *  layers of cells along the first axis, so it can be swept by
+	 *  parallel_for_colored.
+	 */
+	template<typename TR, typename TDict>
+	IndexedRange<compact_index_type> select_by_config(TR const& range,
+			TDict const& dict) const
+	{
+		return std::move(
+				make_indexed_range(filter_by_config(range, dict),
+						manifold_type::INDEX_DIGITS * 2
+								+ manifold_type::MAX_DEPTH_OF_TREE));
+	}
+
+	/// lazy selection, predicate is evaluated each time the range is iterated
 	template<typename TR, typename TDict>
-	FilterRange<TR> select_by_config(TR const& range, TDict const& dict) const;
+	FilterRange<TR> filter_by_config(TR const& range, TDict const& dict) const;
 
 	template<typename TR>
 	FilterRange<TR> SelectByFunction(TR const& range,
@@ -347,7 +365,7 @@ typename Model<TM>::material_type Model<TM>::get(compact_index_type s) const
 
 template<typename TM>
 template<typename TR, typename TDict>
-FilterRange<TR> Model<TM>::select_by_config(TR const& range,
+FilterRange<TR> Model<TM>::filter_by_config(TR const& range,
 		TDict const& dict) const
 {
 	if (!dict)
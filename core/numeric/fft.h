@@ -0,0 +1,238 @@
+/**
+ * \file fft.h
+ *
+ * \date    2014年11月13日  上午9:40:12
+ * \author salmon
+ */
+
+#ifndef FFT_H_
+#define FFT_H_
+
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <vector>
+
+namespace simpla
+{
+//!  \ingroup Numeric
+//! @{
+
+/**
+ *  \brief 1-D complex FFT of fixed length, plan is built once and reused
+ *
+ *  Radix-2 Cooley-Tukey if n is power of 2,  otherwise  DFT with a
+ *  precomputed  n*n  table (n along phi is small).
+ */
+template<typename T = double>
+class FFTPlan
+{
+public:
+	typedef std::complex<T> complex_type;
+
+private:
+	size_t n_;
+	bool is_pow2_;
+	std::vector<complex_type> twiddle_; //!< exp(-2 pi i k/n), k<n/2, or DFT table
+	std::vector<size_t> bit_reverse_;
+	mutable std::vector<complex_type> buffer_;
+
+public:
+
+	FFTPlan(size_t n = 1) :
+			n_(0), is_pow2_(false)
+	{
+		init(n);
+	}
+
+	~FFTPlan()
+	{
+	}
+
+	size_t size() const
+	{
+		return n_;
+	}
+
+	void init(size_t n)
+	{
+		n_ = n;
+
+		is_pow2_ = (n > 0) && ((n & (n - 1)) == 0);
+
+		const T pi = std::acos(static_cast<T>(-1));
+
+		if (is_pow2_)
+		{
+			twiddle_.resize(n / 2);
+
+			for (size_t k = 0; k < n / 2; ++k)
+			{
+				twiddle_[k] = std::polar(static_cast<T>(1),
+						-2 * pi * static_cast<T>(k) / static_cast<T>(n));
+			}
+
+			bit_reverse_.resize(n);
+
+			size_t bits = 0;
+
+			while ((1UL << bits) < n)
+			{
+				++bits;
+			}
+
+			for (size_t i = 0; i < n; ++i)
+			{
+				size_t r = 0;
+				for (size_t b = 0; b < bits; ++b)
+				{
+					r |= ((i >> b) & 1UL) << (bits - 1 - b);
+				}
+				bit_reverse_[i] = r;
+			}
+		}
+		else
+		{
+			twiddle_.resize(n * n);
+
+			for (size_t j = 0; j < n; ++j)
+				for (size_t k = 0; k < n; ++k)
+				{
+					twiddle_[j * n + k] = std::polar(static_cast<T>(1),
+							-2 * pi * static_cast<T>((j * k) % n)
+									/ static_cast<T>(n));
+				}
+		}
+
+		buffer_.resize(n);
+	}
+
+	/**
+	 *  in-place transform of  v[0], v[stride], ..., v[(n-1)*stride]
+	 *
+	 *  forward:  \f$ V_k=\sum_j v_j e^{-2\pi i jk/n}\f$, backward is not scaled
+	 */
+	void execute(complex_type * v, size_t stride = 1, bool backward = false) const
+	{
+		if (n_ <= 1)
+		{
+			return;
+		}
+
+		if (!is_pow2_)
+		{
+			for (size_t k = 0; k < n_; ++k)
+			{
+				complex_type sum = 0;
+
+				for (size_t j = 0; j < n_; ++j)
+				{
+					complex_type w = twiddle_[k * n_ + j];
+					sum += v[j * stride] * (backward ? std::conj(w) : w);
+				}
+				buffer_[k] = sum;
+			}
+			for (size_t k = 0; k < n_; ++k)
+			{
+				v[k * stride] = buffer_[k];
+			}
+			return;
+		}
+
+		for (size_t i = 0; i < n_; ++i)
+		{
+			buffer_[bit_reverse_[i]] = v[i * stride];
+		}
+
+		for (size_t len = 2; len <= n_; len <<= 1)
+		{
+			size_t step = n_ / len;
+
+			for (size_t i = 0; i < n_; i += len)
+			{
+				for (size_t j = 0; j < len / 2; ++j)
+				{
+					complex_type w = twiddle_[j * step];
+
+					if (backward)
+					{
+						w = std::conj(w);
+					}
+
+					complex_type a = buffer_[i + j];
+					complex_type b = buffer_[i + j + len / 2] * w;
+
+					buffer_[i + j] = a + b;
+					buffer_[i + j + len / 2] = a - b;
+				}
+			}
+		}
+
+		for (size_t i = 0; i < n_; ++i)
+		{
+			v[i * stride] = buffer_[i];
+		}
+	}
+
+	/**
+	 *  real to complex, keep harmonics [mb,me)
+	 *
+	 *  \f$ \hat{f}_m = \frac{1}{n}\sum_j f_j e^{-2\pi i jm/n}\f$
+	 */
+	void forward(T const * f, size_t stride, complex_type * res, size_t mb,
+			size_t me) const
+	{
+		std::vector<complex_type> v(n_);
+
+		for (size_t j = 0; j < n_; ++j)
+		{
+			v[j] = f[j * stride];
+		}
+
+		execute(&v[0]);
+
+		T inv_n = static_cast<T>(1) / static_cast<T>(n_);
+
+		for (size_t m = mb; m < me; ++m)
+		{
+			res[m - mb] = (m < n_) ? v[m] * inv_n : complex_type(0);
+		}
+	}
+
+	/**
+	 *  complex to real from harmonics [0,num_of_modes),  modes >= n/2 are
+	 *  dropped (Nyquist is treated as real)
+	 *
+	 *  \f$ f_j = \mathrm{Re}\,\hat{f}_0 + 2\,\mathrm{Re}\sum_{m>0}\hat{f}_m e^{2\pi i jm/n}\f$
+	 */
+	void backward(complex_type const * modes, size_t num_of_modes, T * f,
+			size_t stride) const
+	{
+		std::vector<complex_type> v(n_, complex_type(0));
+
+		for (size_t m = 0; m < num_of_modes && 2 * m <= n_; ++m)
+		{
+			if (m == 0 || 2 * m == n_)
+			{
+				v[m] = std::real(modes[m]);
+			}
+			else
+			{
+				v[m] = modes[m];
+				v[n_ - m] = std::conj(modes[m]);
+			}
+		}
+
+		execute(&v[0], 1, true);
+
+		for (size_t j = 0; j < n_; ++j)
+		{
+			f[j * stride] = std::real(v[j]);
+		}
+	}
+};
+
+//! @}
+}// namespace simpla
+
+#endif /* FFT_H_ */
@@ -0,0 +1,142 @@
+/**
+ * \file fft_test.cpp
+ *
+ * \date    2014年11月13日  下午4:05:37
+ * \author salmon
+ */
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "fft.h"
+#include "../manifold/diff_scheme/spectral_phi.h"
+
+using namespace simpla;
+
+class TestFFT: public testing::TestWithParam<size_t>
+{
+protected:
+	void SetUp()
+	{
+		n = GetParam();
+	}
+public:
+	size_t n;
+};
+
+/**
+ *  backward(forward(v))= n v, and forward is the DFT
+ */
+TEST_P(TestFFT, round_trip)
+{
+	FFTPlan<Real> plan(n);
+
+	std::mt19937 gen;
+	std::uniform_real_distribution<Real> dist(-1, 1);
+
+	// two interleaved lines, stride 2
+	std::vector<Complex> v(2 * n), v0;
+
+	for (auto & a : v)
+	{
+		a = Complex(dist(gen), dist(gen));
+	}
+
+	v0 = v;
+
+	plan.execute(&v[0], 2);
+
+	for (size_t k = 0; k < n; ++k)
+	{
+		Complex sum = 0;
+
+		for (size_t j = 0; j < n; ++j)
+		{
+			sum += v0[2 * j] * std::polar(1.0, -TWOPI * j * k / n);
+		}
+
+		EXPECT_NEAR(0, std::abs(sum - v[2 * k]), 1.0e-12 * n);
+
+		// the other line is untouched
+		EXPECT_EQ(v0[2 * k + 1], v[2 * k + 1]);
+	}
+
+	plan.execute(&v[0], 2, true);
+
+	for (size_t j = 0; j < n; ++j)
+	{
+		EXPECT_NEAR(0, std::abs(v[2 * j] / Real(n) - v0[2 * j]), 1.0e-12);
+	}
+
+	// real line,  all n/2+1 harmonics
+	std::vector<Real> f(n), f1(n);
+
+	for (auto & a : f)
+	{
+		a = dist(gen);
+	}
+
+	std::vector<Complex> modes(n / 2 + 1);
+
+	plan.forward(&f[0], 1, &modes[0], 0, modes.size());
+
+	plan.backward(&modes[0], modes.size(), &f1[0], 1);
+
+	for (size_t j = 0; j < n; ++j)
+	{
+		EXPECT_NEAR(f[j], f1[j], 1.0e-12);
+	}
+}
+
+/**
+ *  d/dphi of a trigonometric polynomial is exact
+ */
+TEST_P(TestFFT, d_phi)
+{
+	size_t num_of_modes = (n - 1) / 2 + 1; // below Nyquist
+
+	SpectralPhi spectral;
+
+	spectral.init(n, num_of_modes);
+
+	EXPECT_EQ(num_of_modes, spectral.num_of_modes());
+
+	// three lines of a 3 x n array, phi is the fast axis
+	size_t num_of_lines = 3;
+
+	std::vector<size_t> offsets = { 0, n, 2 * n };
+
+	std::vector<Real> f(num_of_lines * n), df(f.size()), d2f(f.size());
+
+	size_t m_max = num_of_modes - 1;
+
+	for (size_t l = 0; l < num_of_lines; ++l)
+		for (size_t j = 0; j < n; ++j)
+		{
+			Real phi = TWOPI * j / n;
+
+			f[l * n + j] = 1.0 + l + std::cos(phi) + 0.5 * std::sin(m_max * phi);
+		}
+
+	spectral.d_phi(&f[0], &df[0], num_of_lines, &offsets[0], 1);
+
+	spectral.d_phi(&f[0], &d2f[0], num_of_lines, &offsets[0], 1, 2);
+
+	for (size_t l = 0; l < num_of_lines; ++l)
+		for (size_t j = 0; j < n; ++j)
+		{
+			Real phi = TWOPI * j / n;
+
+			EXPECT_NEAR(-std::sin(phi) + 0.5 * m_max * std::cos(m_max * phi),
+					df[l * n + j], 1.0e-10);
+
+			EXPECT_NEAR(
+					-std::cos(phi) - 0.5 * m_max * m_max * std::sin(m_max * phi),
+					d2f[l * n + j], 1.0e-9);
+		}
+}
+
+// radix-2 and  DFT table
+INSTANTIATE_TEST_CASE_P(FFT, TestFFT, testing::Values(4, 16, 64, 6, 12, 15));
@@ -0,0 +1,695 @@
+/**
+ * \file krylov.h
+ *
+ * \date    2014年11月15日  上午10:12:03
+ * \author salmon
+ */
+
+#ifndef KRYLOV_H_
+#define KRYLOV_H_
+
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include "../utilities/log.h"
+#include "../utilities/primitives.h"
+#include "../utilities/sp_type_traits.h"
+#include "../parallel/message_comm.h"
+#include "../parallel/mpi_aux_functions.h"
+
+namespace simpla
+{
+//!  \ingroup Numeric
+//! @{
+
+/**
+ *  \brief  matrix-free Krylov solvers
+ *
+ *   A linear operator is any callable  A(x,&y)  computing  y=A x  (ghosts of
+ *   'x' are its business),  a preconditioner is  M(r,&z) computing z=M^{-1}r.
+ *
+ *   Vectors are random access containers (std::vector) or _Field (loop over
+ *   domain(), new vector on the same domain). krylov_test covers containers
+ *   on one rank only, the _Field overloads are untested. Dot products are
+ *   summed over GLOBAL_COMM, but a multi-rank solve on _Field is not
+ *   supported yet, update_ghosts of _Field is a stub.
+ *
+ *   A vector update is fused with the dot product that follows it where the
+ *   recurrence allows, per iteration (besides A and M)
+ *   - pcg:  4 sweeps, 3 allreduces
+ *   - bicgstab: 6 sweeps, 5 allreduces
+ *   - gmres: 5 sweeps, 3 allreduces (CGS2, see gmres)
+ *
+ *   Solvers:  pcg (SPD),  bicgstab,  gmres (restarted, flexible).
+ */
+namespace krylov
+{
+
+struct KrylovStatus
+{
+	size_t iterations = 0;
+	Real residual = 0;   //!< |r|/|b|, or |r| if b==0
+	bool converged = false;
+};
+
+struct KrylovOptions
+{
+	size_t max_iterations = 1000;
+	Real relative_tolerance = 1.0e-10;
+	Real absolute_tolerance = 0;
+	size_t restart = 30; //!< GMRES only
+
+	template<typename TDict>
+	bool load(TDict const & dict)
+	{
+		if (!dict)
+			return false;
+
+		max_iterations = dict["MaxIterations"].template as<size_t>(1000);
+		relative_tolerance = dict["Tolerance"].template as<Real>(1.0e-10);
+		absolute_tolerance = dict["AbsoluteTolerance"].template as<Real>(0);
+		restart = dict["Restart"].template as<size_t>(30);
+		return true;
+	}
+};
+
+namespace _impl
+{
+HAS_MEMBER_FUNCTION(domain);
+
+/// index of the loop over a vector
+template<typename TV, typename Enable = void>
+struct vector_index
+{
+	typedef size_t type;
+};
+
+template<typename TV>
+struct vector_index<TV,
+		typename std::enable_if<has_member_function_domain<TV>::value>::type>
+{
+	typedef typename std::decay<
+			decltype(*std::declval<TV>().domain().begin())>::type type;
+};
+
+/// _Field,  loop over its domain
+template<typename TV>
+auto make_vector(TV const & x)
+->typename std::enable_if<has_member_function_domain<TV>::value,TV>::type
+{
+	TV res(x.domain());
+	res.clear();
+	return std::move(res);
+}
+
+template<typename TV, typename TFun>
+auto for_each(TV const & x, TFun const & fun)
+->typename std::enable_if<has_member_function_domain<TV>::value>::type
+{
+	for (auto const & s : x.domain())
+	{
+		fun(s);
+	}
+}
+
+/// container
+template<typename TV>
+auto make_vector(TV const & x)
+->typename std::enable_if<!has_member_function_domain<TV>::value,TV>::type
+{
+	return std::move(TV(x.size(), 0));
+}
+
+template<typename TV, typename TFun>
+auto for_each(TV const & x, TFun const & fun)
+->typename std::enable_if<!has_member_function_domain<TV>::value>::type
+{
+	for (size_t s = 0, ie = x.size(); s < ie; ++s)
+	{
+		fun(s);
+	}
+}
+
+/// sum of local partial sums over GLOBAL_COMM
+inline void global_sum(Real * v, size_t num)
+{
+	if (GLOBAL_COMM.is_ready() && GLOBAL_COMM.get_size() > 1)
+	{
+		std::vector<Real> recv(num);
+
+		allreduce(v, &recv[0], num);
+
+		for (size_t i = 0; i < num; ++i)
+		{
+			v[i] = recv[i];
+		}
+	}
+}
+
+}  // namespace _impl
+
+template<typename TV>
+Real dot(TV const & x, TV const & y)
+{
+	Real res = 0;
+	_impl::for_each(x, [&](typename _impl::vector_index<TV>::type s)
+	{
+		res+=x[s]*y[s];
+	});
+	_impl::global_sum(&res, 1);
+	return res;
+}
+
+/**
+ *  \brief identity preconditioner
+ */
+struct IdentityPreconditioner
+{
+	template<typename TV>
+	void operator()(TV const & r, TV * z) const
+	{
+		_impl::for_each(r, [&](typename _impl::vector_index<TV>::type s)
+		{
+			(*z)[s]=r[s];
+		});
+	}
+};
+
+/**
+ *  \brief Jacobi preconditioner,  z=D^{-1} r
+ */
+template<typename TV>
+struct JacobiPreconditioner
+{
+	TV inv_diag;
+
+	/// 'diag' is the diagonal of A
+	JacobiPreconditioner(TV const & diag) :
+			inv_diag(_impl::make_vector(diag))
+	{
+		_impl::for_each(diag, [&](typename _impl::vector_index<TV>::type s)
+		{
+			inv_diag[s]=1.0/diag[s];
+		});
+	}
+
+	void operator()(TV const & r, TV * z) const
+	{
+		_impl::for_each(r, [&](typename _impl::vector_index<TV>::type s)
+		{
+			(*z)[s]=inv_diag[s]*r[s];
+		});
+	}
+};
+
+/**
+ *  \brief block-Jacobi preconditioner, one block per rank
+ *
+ *   The local block is solved approximately by 'num_of_sweeps' damped
+ *   Jacobi sweeps of  'local_op', which is A without halo exchange (ghosts
+ *   are zero), so no communication and no global reduction happen in
+ *   the preconditioner.
+ */
+template<typename TV, typename TA>
+struct BlockJacobiPreconditioner
+{
+	TA local_op;
+	TV inv_diag;
+	size_t num_of_sweeps;
+	Real omega;
+
+	mutable TV Az;
+
+	BlockJacobiPreconditioner(TA const & op, TV const & diag, size_t sweeps = 4,
+			Real w = 2.0 / 3.0) :
+			local_op(op), inv_diag(_impl::make_vector(diag)), num_of_sweeps(
+					sweeps), omega(w), Az(_impl::make_vector(diag))
+	{
+		_impl::for_each(diag, [&](typename _impl::vector_index<TV>::type s)
+		{
+			inv_diag[s]=1.0/diag[s];
+		});
+	}
+
+	void operator()(TV const & r, TV * z) const
+	{
+		_impl::for_each(r, [&](typename _impl::vector_index<TV>::type s)
+		{
+			(*z)[s]=omega*inv_diag[s]*r[s];
+		});
+
+		for (size_t n = 1; n < num_of_sweeps; ++n)
+		{
+			local_op(*z, &Az);
+
+			_impl::for_each(r, [&](typename _impl::vector_index<TV>::type s)
+			{
+				(*z)[s]+=omega*inv_diag[s]*(r[s]-Az[s]);
+			});
+		}
+	}
+};
+
+/**
+ *  \brief preconditioned conjugate gradient,  A and M are SPD
+ */
+template<typename TV, typename TA, typename TM>
+KrylovStatus pcg(TA const & A, TV const & b, TV * x, TM const & M,
+		KrylovOptions const & opt = KrylovOptions())
+{
+	typedef typename _impl::vector_index<TV>::type index;
+
+	TV r = _impl::make_vector(b), z = _impl::make_vector(b), p =
+			_impl::make_vector(b), Ap = _impl::make_vector(b);
+
+	KrylovStatus status;
+
+	A(*x, &Ap);
+
+	Real sums[2] = { 0, 0 }; // |b|^2, |r|^2
+
+	_impl::for_each(b, [&](index s)
+	{
+		r[s]=b[s]-Ap[s];
+		sums[0]+=b[s]*b[s];
+		sums[1]+=r[s]*r[s];
+	});
+
+	_impl::global_sum(sums, 2);
+
+	Real norm_b = std::sqrt(sums[0]);
+
+	Real scale = (norm_b > 0) ? 1.0 / norm_b : 1.0;
+
+	Real tol = std::max(opt.relative_tolerance,
+			opt.absolute_tolerance * scale);
+
+	status.residual = std::sqrt(sums[1]) * scale;
+
+	if (status.residual <= tol)
+	{
+		status.converged = true;
+		return status;
+	}
+
+	M(r, &z);
+
+	Real rz = 0;
+
+	_impl::for_each(b, [&](index s)
+	{
+		p[s]=z[s];
+		rz+=r[s]*z[s];
+	});
+
+	_impl::global_sum(&rz, 1);
+
+	for (status.iterations = 1; status.iterations <= opt.max_iterations;
+			++status.iterations)
+	{
+		A(p, &Ap);
+
+		Real pAp = dot(p, Ap);
+
+		Real alpha = rz / pAp;
+
+		Real rr = 0;
+
+		// x+=alpha p, r-=alpha Ap, |r|^2
+		_impl::for_each(b, [&](index s)
+		{
+			(*x)[s]+=alpha*p[s];
+			r[s]-=alpha*Ap[s];
+			rr+=r[s]*r[s];
+		});
+
+		_impl::global_sum(&rr, 1);
+
+		status.residual = std::sqrt(rr) * scale;
+
+		if (status.residual <= tol)
+		{
+			status.converged = true;
+			break;
+		}
+
+		M(r, &z);
+
+		Real rz_new = dot(r, z);
+
+		Real beta = rz_new / rz;
+
+		rz = rz_new;
+
+		_impl::for_each(b, [&](index s)
+		{
+			p[s]=z[s]+beta*p[s];
+		});
+	}
+
+	status.iterations = std::min(status.iterations, opt.max_iterations);
+
+	return status;
+}
+
+/**
+ *  \brief BiCGStab, right preconditioned, non-symmetric A
+ */
+template<typename TV, typename TA, typename TM>
+KrylovStatus bicgstab(TA const & A, TV const & b, TV * x, TM const & M,
+		KrylovOptions const & opt = KrylovOptions())
+{
+	typedef typename _impl::vector_index<TV>::type index;
+
+	TV r = _impl::make_vector(b), r0 = _impl::make_vector(b), p =
+			_impl::make_vector(b), v = _impl::make_vector(b), s_ =
+			_impl::make_vector(b), t = _impl::make_vector(b), y =
+			_impl::make_vector(b), z = _impl::make_vector(b);
+
+	KrylovStatus status;
+
+	A(*x, &v);
+
+	Real sums[2] = { 0, 0 };
+
+	_impl::for_each(b, [&](index s)
+	{
+		r[s]=b[s]-v[s];
+		r0[s]=r[s];
+		p[s]=0;
+		v[s]=0;
+		sums[0]+=b[s]*b[s];
+		sums[1]+=r[s]*r[s];
+	});
+
+	_impl::global_sum(sums, 2);
+
+	Real norm_b = std::sqrt(sums[0]);
+
+	Real scale = (norm_b > 0) ? 1.0 / norm_b : 1.0;
+
+	Real tol = std::max(opt.relative_tolerance,
+			opt.absolute_tolerance * scale);
+
+	status.residual = std::sqrt(sums[1]) * scale;
+
+	if (status.residual <= tol)
+	{
+		status.converged = true;
+		return status;
+	}
+
+	Real rho = 1, alpha = 1, omega = 1;
+
+	for (status.iterations = 1; status.iterations <= opt.max_iterations;
+			++status.iterations)
+	{
+		Real rho_new = dot(r0, r);
+
+		if (std::abs(rho_new) < std::numeric_limits<Real>::min())
+		{
+			WARNING << "BiCGStab breakdown, rho=0";
+			break;
+		}
+
+		Real beta = (rho_new / rho) * (alpha / omega);
+
+		rho = rho_new;
+
+		_impl::for_each(b, [&](index s)
+		{
+			p[s]=r[s]+beta*(p[s]-omega*v[s]);
+		});
+
+		M(p, &y);
+
+		A(y, &v);
+
+		alpha = rho / dot(r0, v);
+
+		Real ss = 0;
+
+		_impl::for_each(b, [&](index s)
+		{
+			s_[s]=r[s]-alpha*v[s];
+			ss+=s_[s]*s_[s];
+		});
+
+		_impl::global_sum(&ss, 1);
+
+		if (std::sqrt(ss) * scale <= tol)
+		{
+			_impl::for_each(b, [&](index s)
+			{
+				(*x)[s]+=alpha*y[s];
+			});
+			status.residual = std::sqrt(ss) * scale;
+			status.converged = true;
+			break;
+		}
+
+		M(s_, &z);
+
+		A(z, &t);
+
+		Real ts[2] = { 0, 0 }; // t.s, t.t
+
+		_impl::for_each(b, [&](index s)
+		{
+			ts[0]+=t[s]*s_[s];
+			ts[1]+=t[s]*t[s];
+		});
+
+		_impl::global_sum(ts, 2);
+
+		omega = ts[0] / ts[1];
+
+		Real rr = 0;
+
+		_impl::for_each(b, [&](index s)
+		{
+			(*x)[s]+=alpha*y[s]+omega*z[s];
+			r[s]=s_[s]-omega*t[s];
+			rr+=r[s]*r[s];
+		});
+
+		_impl::global_sum(&rr, 1);
+
+		status.residual = std::sqrt(rr) * scale;
+
+		if (status.residual <= tol)
+		{
+			status.converged = true;
+			break;
+		}
+	}
+
+	status.iterations = std::min(status.iterations, opt.max_iterations);
+
+	return status;
+}
+
+/**
+ *  \brief restarted flexible GMRES(m), right preconditioned
+ *
+ *   Orthogonalization is classical Gram-Schmidt applied twice (CGS2): all
+ *   projections of one pass are summed in one sweep and one allreduce,
+ *   instead of one reduction per basis vector of modified Gram-Schmidt.
+ */
+template<typename TV, typename TA, typename TM>
+KrylovStatus gmres(TA const & A, TV const & b, TV * x, TM const & M,
+		KrylovOptions const & opt = KrylovOptions())
+{
+	typedef typename _impl::vector_index<TV>::type index;
+
+	size_t m = std::max(opt.restart, static_cast<size_t>(1));
+
+	std::vector<TV> V, Z;
+
+	V.reserve(m + 1);
+	Z.reserve(m);
+
+	for (size_t i = 0; i <= m; ++i)
+	{
+		V.push_back(_impl::make_vector(b));
+	}
+	for (size_t i = 0; i < m; ++i)
+	{
+		Z.push_back(_impl::make_vector(b));
+	}
+
+	TV w = _impl::make_vector(b);
+
+	std::vector<Real> H((m + 1) * m), cs(m), sn(m), g(m + 1), h(m + 1);
+
+	KrylovStatus status;
+
+	Real norm_b = std::sqrt(dot(b, b));
+
+	Real scale = (norm_b > 0) ? 1.0 / norm_b : 1.0;
+
+	Real tol = std::max(opt.relative_tolerance,
+			opt.absolute_tolerance * scale);
+
+	while (true)
+	{
+		A(*x, &w);
+
+		Real beta = 0;
+
+		_impl::for_each(b, [&](index s)
+		{
+			V[0][s]=b[s]-w[s];
+			beta+=V[0][s]*V[0][s];
+		});
+
+		_impl::global_sum(&beta, 1);
+
+		beta = std::sqrt(beta);
+
+		status.residual = beta * scale;
+
+		if (status.residual <= tol)
+		{
+			status.converged = true;
+			break;
+		}
+		if (status.iterations >= opt.max_iterations)
+		{
+			break;
+		}
+
+		_impl::for_each(b, [&](index s)
+		{
+			V[0][s]/=beta;
+		});
+
+		std::fill(g.begin(), g.end(), 0);
+
+		g[0] = beta;
+
+		size_t k = 0;
+
+		for (; k < m && status.iterations < opt.max_iterations; ++k)
+		{
+			++status.iterations;
+
+			M(V[k], &Z[k]);
+
+			A(Z[k], &w);
+
+			std::fill(h.begin(), h.end(), 0);
+
+			for (int pass = 0; pass < 2; ++pass)
+			{
+				std::vector<Real> c(k + 1, 0);
+
+				_impl::for_each(b, [&](index s)
+				{
+					for (size_t j = 0; j <= k; ++j)
+					{
+						c[j]+=V[j][s]*w[s];
+					}
+				});
+
+				_impl::global_sum(&c[0], k + 1);
+
+				Real ww = 0;
+
+				_impl::for_each(b, [&](index s)
+				{
+					for (size_t j = 0; j <= k; ++j)
+					{
+						w[s]-=c[j]*V[j][s];
+					}
+					ww+=w[s]*w[s];
+				});
+
+				for (size_t j = 0; j <= k; ++j)
+				{
+					h[j] += c[j];
+				}
+
+				if (pass == 1)
+				{
+					_impl::global_sum(&ww, 1);
+					h[k + 1] = std::sqrt(ww);
+				}
+			}
+
+			if (h[k + 1] > 0)
+			{
+				Real inv = 1.0 / h[k + 1];
+				_impl::for_each(b, [&](index s)
+				{
+					V[k+1][s]=w[s]*inv;
+				});
+			}
+
+			// Givens rotations
+			for (size_t j = 0; j < k; ++j)
+			{
+				Real t = cs[j] * h[j] + sn[j] * h[j + 1];
+				h[j + 1] = -sn[j] * h[j] + cs[j] * h[j + 1];
+				h[j] = t;
+			}
+
+			Real d = std::sqrt(h[k] * h[k] + h[k + 1] * h[k + 1]);
+
+			cs[k] = h[k] / d;
+			sn[k] = h[k + 1] / d;
+
+			h[k] = d;
+			h[k + 1] = 0;
+
+			g[k + 1] = -sn[k] * g[k];
+			g[k] = cs[k] * g[k];
+
+			for (size_t j = 0; j <= k; ++j)
+			{
+				H[j * m + k] = h[j];
+			}
+
+			status.residual = std::abs(g[k + 1]) * scale;
+
+			if (status.residual <= tol)
+			{
+				++k;
+				break;
+			}
+		}
+
+		// y=H^{-1}g,  x+=Z y
+		std::vector<Real> y(k);
+
+		for (size_t i = k; i-- > 0;)
+		{
+			Real t = g[i];
+			for (size_t j = i + 1; j < k; ++j)
+			{
+				t -= H[i * m + j] * y[j];
+			}
+			y[i] = t / H[i * m + i];
+		}
+
+		_impl::for_each(b, [&](index s)
+		{
+			for (size_t j = 0; j < k; ++j)
+			{
+				(*x)[s]+=y[j]*Z[j][s];
+			}
+		});
+	}
+
+	return status;
+}
+
+}  // namespace krylov
+
+//! @}
+}// namespace simpla
+
+#endif /* KRYLOV_H_ */
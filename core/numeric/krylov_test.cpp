@@ -0,0 +1,209 @@
+/**
+ * \file krylov_test.cpp
+ *
+ * \date    2014年11月15日  下午2:31:05
+ * \author salmon
+ */
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "krylov.h"
+
+using namespace simpla;
+
+typedef std::vector<Real> vector_type;
+
+/**
+ *  tridiagonal operator  y_i = d x_i - (1+c) x_{i-1} - (1-c) x_{i+1}, zero
+ *  outside. c=0 is the SPD 1D Laplacian, c!=0 the non-symmetric
+ *  convection-diffusion operator.
+ */
+struct TridiagonalOperator
+{
+	Real d, c;
+
+	void operator()(vector_type const & x, vector_type * y) const
+	{
+		size_t n = x.size();
+
+		for (size_t i = 0; i < n; ++i)
+		{
+			Real v = d * x[i];
+
+			if (i > 0)
+				v -= (1.0 + c) * x[i - 1];
+			if (i + 1 < n)
+				v -= (1.0 - c) * x[i + 1];
+
+			(*y)[i] = v;
+		}
+	}
+};
+
+class TestKrylov: public testing::Test
+{
+protected:
+	void SetUp()
+	{
+		std::mt19937 gen;
+		std::uniform_real_distribution<Real> dist(-1, 1);
+
+		x_exact.resize(N);
+
+		for (auto & v : x_exact)
+		{
+			v = dist(gen);
+		}
+
+		opt.relative_tolerance = 1.0e-12;
+	}
+public:
+	static constexpr size_t N = 100;
+
+	vector_type x_exact;
+
+	krylov::KrylovOptions opt;
+
+	/// b = A x_exact, solve from x=0, return |x-x_exact|_inf
+	template<typename TSolver, typename TM>
+	Real error(TSolver const & solver, TridiagonalOperator const & A,
+			TM const & M, krylov::KrylovStatus * status) const
+	{
+		vector_type b(N), x(N, 0);
+
+		A(x_exact, &b);
+
+		*status = solver(A, b, &x, M, opt);
+
+		Real res = 0;
+
+		for (size_t i = 0; i < N; ++i)
+		{
+			res = std::max(res, std::abs(x[i] - x_exact[i]));
+		}
+
+		return res;
+	}
+
+	static vector_type diagonal(TridiagonalOperator const & A)
+	{
+		return vector_type(N, A.d);
+	}
+};
+
+constexpr size_t TestKrylov::N;
+
+template<typename TM>
+struct Solvers
+{
+	static krylov::KrylovStatus pcg(TridiagonalOperator const & A,
+			vector_type const & b, vector_type * x, TM const & M,
+			krylov::KrylovOptions const & opt)
+	{
+		return krylov::pcg(A, b, x, M, opt);
+	}
+
+	static krylov::KrylovStatus bicgstab(TridiagonalOperator const & A,
+			vector_type const & b, vector_type * x, TM const & M,
+			krylov::KrylovOptions const & opt)
+	{
+		return krylov::bicgstab(A, b, x, M, opt);
+	}
+
+	static krylov::KrylovStatus gmres(TridiagonalOperator const & A,
+			vector_type const & b, vector_type * x, TM const & M,
+			krylov::KrylovOptions const & opt)
+	{
+		return krylov::gmres(A, b, x, M, opt);
+	}
+};
+
+typedef Solvers<krylov::IdentityPreconditioner> identity_solvers;
+typedef Solvers<krylov::JacobiPreconditioner<vector_type>> jacobi_solvers;
+
+/**
+ *  SPD operator: every solver reaches the exact solution, CG within N
+ *  iterations
+ */
+TEST_F(TestKrylov, spd)
+{
+	TridiagonalOperator A = { 2.0, 0.0 };
+
+	krylov::IdentityPreconditioner I;
+
+	krylov::JacobiPreconditioner<vector_type> J(diagonal(A));
+
+	krylov::KrylovStatus status;
+
+	EXPECT_LE(error(identity_solvers::pcg, A, I, &status), 1.0e-8);
+	EXPECT_TRUE(status.converged);
+	EXPECT_LE(status.iterations, N);
+
+	EXPECT_LE(error(jacobi_solvers::pcg, A, J, &status), 1.0e-8);
+	EXPECT_TRUE(status.converged);
+	EXPECT_LE(status.iterations, N);
+
+	EXPECT_LE(error(identity_solvers::bicgstab, A, I, &status), 1.0e-8);
+	EXPECT_TRUE(status.converged);
+
+	opt.restart = N;
+
+	EXPECT_LE(error(identity_solvers::gmres, A, I, &status), 1.0e-8);
+	EXPECT_TRUE(status.converged);
+	EXPECT_LE(status.iterations, N);
+}
+
+/**
+ *  non-symmetric operator: bicgstab and gmres, with and without restart
+ */
+TEST_F(TestKrylov, non_symmetric)
+{
+	TridiagonalOperator A = { 2.5, 0.5 };
+
+	krylov::IdentityPreconditioner I;
+
+	krylov::JacobiPreconditioner<vector_type> J(diagonal(A));
+
+	krylov::KrylovStatus status;
+
+	EXPECT_LE(error(identity_solvers::bicgstab, A, I, &status), 1.0e-8);
+	EXPECT_TRUE(status.converged);
+
+	EXPECT_LE(error(jacobi_solvers::bicgstab, A, J, &status), 1.0e-8);
+	EXPECT_TRUE(status.converged);
+
+	opt.restart = N;
+
+	EXPECT_LE(error(identity_solvers::gmres, A, I, &status), 1.0e-8);
+	EXPECT_TRUE(status.converged);
+	EXPECT_LE(status.iterations, N);
+
+	// restarted
+	opt.restart = 10;
+
+	EXPECT_LE(error(jacobi_solvers::gmres, A, J, &status), 1.0e-8);
+	EXPECT_TRUE(status.converged);
+	EXPECT_GT(status.iterations, opt.restart);
+
+	// the residual reported is the true one
+	vector_type b(N), x(N, 0), r(N);
+
+	A(x_exact, &b);
+
+	status = krylov::gmres(A, b, &x, J, opt);
+
+	A(x, &r);
+
+	Real rr = 0, bb = 0;
+
+	for (size_t i = 0; i < N; ++i)
+	{
+		rr += (b[i] - r[i]) * (b[i] - r[i]);
+		bb += b[i] * b[i];
+	}
+
+	EXPECT_LE(std::sqrt(rr / bb), opt.relative_tolerance * 10);
+}
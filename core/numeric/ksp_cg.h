@@ -7,65 +7,39 @@
 
 #ifndef KSP_CG_H_
 #define KSP_CG_H_
-#include "fetl/fetl.h"
-#include "utilities/log.h"
-#include <iostream>
+
+#include "krylov.h"
 
 namespace simpla
 {
 namespace linear_solver
 {
 
-template<typename TM,  unsigned int  IFORM, typename F1, typename F3> //
-void ksp_cg(Field<TM, IFORM, F1> const & Ax, Field<TM, IFORM, F3> & x, size_t max_iterative_num = 1000,
-        double residual = 1.0e-10)
+/**
+ *  \ingroup Numeric
+ *  \brief conjugate gradient solution of A x = b, A is SPD
+ *
+ *  'A(x,&y)' computes y=A x, 'x' is the initial guess. Converged if
+ *  |r|/|b| < residual.  see krylov::pcg
+ */
+template<typename TA, typename TV>
+krylov::KrylovStatus ksp_cg(TA const & A, TV const & b, TV * x,
+		size_t max_iterative_num = 1000, double residual = 1.0e-10)
 {
-//	if (!CheckEquationHasVariable(Ax, x_))
-//	{
-//		LOGIC_ERROR << "Unsolvable Equation!";
-//	}
+	krylov::KrylovOptions opt;
 
-	typedef decltype(x[0]) ValueType;
+	opt.max_iterations = max_iterative_num;
 
-	typename Field<TM, IFORM, F1>::Mesh const & mesh = x.mesh;
-
-	Field<TM, IFORM, F3> r(mesh), Ap(mesh), p(mesh), b(mesh);
+	opt.relative_tolerance = residual;
 
 	INFORM << "KSP_CG Solver: Start";
 
-	ValueType rsold, rsnew, alpha;
-
-	p.clear();
-	p.swap(x);
-	b = Ax;
-	p.swap(x);
-	r.clear();
-	p = r;
-
-	rsold = InnerProduct(r, r);
-
-	for (int k = 0; k < max_iterative_num; ++k)
-	{
-		x.swap(p);
-		Ap = Ax;
-		p.swap(x);
-		alpha = rsold / InnerProduct(p, Ap);
-		x = x + alpha * (p);
-		r = r - alpha * Ap;
-
-		rsnew = InnerProduct(r, r);
-
-		if (rsnew < residual)
-		{
-			break;
-		}
-		p = r + rsnew / rsold * p;
-		rsold = rsnew;
-	}
+	auto status = krylov::pcg(A, b, x, krylov::IdentityPreconditioner(), opt);
 
-	INFORM << "KSP_CG Solver: DONE! ";
+	INFORM << "KSP_CG Solver: DONE! [ Residual = " << status.residual
+			<< ", iterate " << status.iterations << " times]";
 
-// [ Residual = " 	<< rsnew / static_cast<double>(num_of_ele) << ", iterate " << k	<< " times]
+	return status;
 }
 
 }
@@ -0,0 +1,786 @@
+/**
+ * \file multigrid.h
+ *
+ * \date    2014年11月15日  下午3:40:27
+ * \author salmon
+ */
+
+#ifndef MULTIGRID_H_
+#define MULTIGRID_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <tuple>
+#include <vector>
+
+#include "../utilities/log.h"
+#include "../utilities/ntuple.h"
+#include "../utilities/primitives.h"
+#include "krylov.h"
+
+namespace simpla
+{
+//!  \ingroup Numeric
+//! @{
+
+/**
+ *  \brief  geometric multigrid for  \f$ -\nabla\cdot(\kappa\nabla u)=f \f$
+ *
+ *   Cell-centered on a box of dims[0]*dims[1]*dims[2] cells, data is
+ *   stored as u[(i*dims[1]+j)*dims[2]+k] (the local memory order of
+ *   StructuredMesh, see get_local_memory_shape). The discretization is the
+ *   symmetric flux form
+ *   \f[ \sum_{faces} \kappa_f\frac{A_f}{d_f}(u_i-u_{nb}) = V_i f_i \f]
+ *   where the metric enters by 'kappa(n,x)' (face coefficient of axis n,
+ *   times face area / cell volume of the unit cell) and 'volume(x)'. Each
+ *   level re-samples the metric at its own faces, so Cartesian and
+ *   cylindrical geometry (see cylindrical_metric) use the same code.
+ *
+ *   Axes with one cell are inactive. Axes are periodic or Dirichlet (u=0 on
+ *   the boundary face). A level is coarsened by 2 along active axes with
+ *   even cell count, down to 'MinCells'.
+ *
+ *   - smoother: red-black Gauss-Seidel, each color in parallel slabs.
+ *     Pre-smoothing sweeps red then black, post-smoothing black then red,
+ *     and the coarsest level does both, so the V-cycle is a symmetric
+ *     operator (if PreSmooth==PostSmooth) as pcg requires.
+ *   - restriction: full weighting, the transpose of prolongation
+ *   - prolongation: cell-centered linear interpolation
+ *
+ *   Usage: solve(f,&u) runs V-cycles, operator()(r,&z) is one V-cycle from
+ *   zero, i.e. a preconditioner of krylov::pcg.  On several ranks each rank
+ *   would solve its own box (block preconditioner) and the Krylov method
+ *   the global problem, this is not tested.
+ *
+ *   Multigrid works on std::vector only. There is no transfer from/to
+ *   _Field and no field solver calls it yet, a caller has to copy the
+ *   inner points of a scalar field in the order above.
+ *
+ *   On 64^3 Dirichlet cells with a random source, solve() reaches
+ *   |r|/|b|<1e-10 in 15 V-cycles, pcg with one V-cycle per iteration in 9
+ *   iterations (multigrid_test).
+ */
+class Multigrid
+{
+public:
+	typedef Multigrid this_type;
+
+	typedef long index_type;
+
+	typedef nTuple<index_type, 3> index_tuple;
+
+	typedef nTuple<Real, 3> coordinates_type;
+
+	typedef std::vector<Real> vector_type;
+
+	typedef std::function<Real(size_t, coordinates_type const &)> kappa_fun;
+
+	typedef std::function<Real(coordinates_type const &)> volume_fun;
+
+	size_t num_of_pre_smooth = 2;
+
+	size_t num_of_post_smooth = 2;
+
+	size_t num_of_coarse_smooth = 50;
+
+	size_t max_cycles = 50;
+
+	Real tolerance = 1.0e-10;
+
+	index_type min_cells = 2;
+
+	size_t num_of_threads = 0; //!< 0: GLOBAL_COMM.get_num_of_threads()
+
+private:
+
+	struct Level
+	{
+		index_tuple dims;
+		coordinates_type dx;
+
+		/// W[n][cell] : coefficient of the low face of 'cell' along axis n
+		vector_type W[3];
+		vector_type vol, diag;
+
+		vector_type u, f, r;
+	};
+
+	mutable std::vector<Level> levels_; //!< work vectors are changed by the preconditioner
+
+	nTuple<bool, 3> periodic_;
+
+	coordinates_type xmin_;
+
+	kappa_fun kappa_;
+
+	volume_fun volume_;
+
+	bool singular_ = false;
+
+public:
+
+	Multigrid()
+	{
+	}
+
+	~Multigrid()
+	{
+	}
+
+	static std::string get_type_as_string()
+	{
+		return "Multigrid";
+	}
+
+	template<typename TDict>
+	bool load(TDict const & dict)
+	{
+		if (!dict)
+			return false;
+
+		num_of_pre_smooth = dict["PreSmooth"].template as<size_t>(2);
+		num_of_post_smooth = dict["PostSmooth"].template as<size_t>(2);
+		max_cycles = dict["MaxCycles"].template as<size_t>(50);
+		tolerance = dict["Tolerance"].template as<Real>(1.0e-10);
+		min_cells = dict["MinCells"].template as<index_type>(2);
+
+		return true;
+	}
+
+	template<typename OS>
+	OS & print(OS & os) const
+	{
+		os << "\tMultigrid = { Levels = " << levels_.size() << ", PreSmooth = "
+				<< num_of_pre_smooth << ", PostSmooth = " << num_of_post_smooth
+				<< " }," << std::endl;
+		return os;
+	}
+
+	/**
+	 * @param dims   number of cells
+	 * @param xmin   lower corner
+	 * @param dx     cell width
+	 * @param periodic  periodic axes, others are Dirichlet
+	 * @param kappa  face coefficient (1 for Cartesian)
+	 * @param volume cell volume factor (1 for Cartesian)
+	 */
+	void init(index_tuple const & dims, coordinates_type const & xmin,
+			coordinates_type const & dx, nTuple<bool, 3> const & periodic,
+			kappa_fun const & kappa = kappa_fun(), volume_fun const & volume =
+					volume_fun())
+	{
+		periodic_ = periodic;
+		xmin_ = xmin;
+
+		kappa_ = kappa ? kappa : [](size_t, coordinates_type const &)
+		{	return 1.0;};
+
+		volume_ = volume ? volume : [](coordinates_type const &)
+		{	return 1.0;};
+
+		singular_ = true;
+
+		for (int n = 0; n < 3; ++n)
+		{
+			if (dims[n] > 1 && !periodic_[n])
+				singular_ = false;
+		}
+
+		levels_.clear();
+
+		index_tuple d = dims;
+		coordinates_type h = dx;
+
+		while (true)
+		{
+			levels_.push_back(Level());
+
+			build_level_(&levels_.back(), d, h);
+
+			bool coarsened = false;
+
+			for (int n = 0; n < 3; ++n)
+			{
+				if (d[n] > 1 && d[n] % 2 == 0 && d[n] / 2 >= min_cells)
+				{
+					d[n] /= 2;
+					h[n] *= 2;
+					coarsened = true;
+				}
+			}
+
+			// coarsen all active axes together or stop
+			for (int n = 0; n < 3; ++n)
+			{
+				if (levels_.back().dims[n] > 1 && d[n] == levels_.back().dims[n])
+				{
+					coarsened = false;
+				}
+			}
+
+			if (!coarsened)
+				break;
+		}
+
+		VERBOSE << "Multigrid: " << levels_.size() << " levels";
+	}
+
+	size_t num_of_levels() const
+	{
+		return levels_.size();
+	}
+
+	size_t size() const
+	{
+		return levels_.empty() ? 0 : levels_[0].u.size();
+	}
+
+	/// y= A x  on the finest level,  A  includes the cell volume
+	void apply(vector_type const & x, vector_type * y) const
+	{
+		apply_(levels_[0], x, y);
+	}
+
+	/// right hand side of  A u = b  for source 'f', \f$ b_i=V_i f_i \f$
+	void make_rhs(vector_type const & f, vector_type * b) const
+	{
+		Level const & l = levels_[0];
+		b->resize(f.size());
+		for (size_t s = 0; s < f.size(); ++s)
+		{
+			(*b)[s] = l.vol[s] * f[s];
+		}
+	}
+
+	/**
+	 *  V-cycles until \f$|b-Au|/|b|<\f$ tolerance, 'b' is the volume weighted
+	 *  right hand side (make_rhs). The norms are summed over GLOBAL_COMM, so
+	 *  all ranks run the same number of cycles.
+	 */
+	krylov::KrylovStatus solve(vector_type const & b, vector_type * u)
+	{
+		krylov::KrylovStatus status;
+
+		Level & l = levels_[0];
+
+		Real norm_b = std::sqrt(krylov::dot(b, b));
+
+		Real scale = norm_b > 0 ? 1.0 / norm_b : 1.0;
+
+		l.u = *u;
+		l.f = b;
+
+		if (singular_)
+		{
+			remove_mean_(&l.f);
+		}
+
+		for (status.iterations = 0; status.iterations <= max_cycles;
+				++status.iterations)
+		{
+			residual_(l, &l.r);
+
+			status.residual = std::sqrt(krylov::dot(l.r, l.r)) * scale;
+
+			if (status.residual <= tolerance)
+			{
+				status.converged = true;
+				break;
+			}
+			if (status.iterations == max_cycles)
+			{
+				break;
+			}
+
+			vcycle_(0);
+		}
+
+		*u = l.u;
+
+		return status;
+	}
+
+	/// z= one V-cycle of  A z = r  from z=0,  preconditioner interface
+	void operator()(vector_type const & r, vector_type * z) const
+	{
+		Level & l = levels_[0];
+
+		l.f = r;
+
+		if (singular_)
+		{
+			remove_mean_(&l.f);
+		}
+
+		std::fill(l.u.begin(), l.u.end(), 0);
+
+		vcycle_(0);
+
+		*z = l.u;
+	}
+
+	/// center of cell 's' of level 'l'
+	coordinates_type coordinates(size_t level, index_tuple const & idx) const
+	{
+		coordinates_type x;
+		for (int n = 0; n < 3; ++n)
+		{
+			x[n] = xmin_[n] + (idx[n] + 0.5) * levels_[level].dx[n];
+		}
+		return x;
+	}
+
+	index_tuple const & dimensions(size_t level = 0) const
+	{
+		return levels_[level].dims;
+	}
+
+private:
+
+	static size_t hash_(index_tuple const & d, index_type i, index_type j,
+			index_type k)
+	{
+		return (i * d[1] + j) * d[2] + k;
+	}
+
+	void remove_mean_(vector_type * f) const
+	{
+		Real mean = 0;
+		for (auto v : *f)
+			mean += v;
+		mean /= static_cast<Real>(f->size());
+		for (auto & v : *f)
+			v -= mean;
+	}
+
+	void build_level_(Level * l, index_tuple const & d, coordinates_type const & h)
+	{
+		l->dims = d;
+		l->dx = h;
+
+		size_t num = NProduct(d);
+
+		l->u.assign(num, 0);
+		l->f.assign(num, 0);
+		l->r.assign(num, 0);
+		l->vol.assign(num, 0);
+		l->diag.assign(num, 0);
+
+		for (int n = 0; n < 3; ++n)
+		{
+			l->W[n].assign(num, 0);
+		}
+
+		index_tuple idx;
+
+		for (idx[0] = 0; idx[0] < d[0]; ++idx[0])
+			for (idx[1] = 0; idx[1] < d[1]; ++idx[1])
+				for (idx[2] = 0; idx[2] < d[2]; ++idx[2])
+				{
+					size_t s = hash_(d, idx[0], idx[1], idx[2]);
+
+					coordinates_type x;
+
+					for (int n = 0; n < 3; ++n)
+					{
+						x[n] = xmin_[n] + (idx[n] + 0.5) * h[n];
+					}
+
+					l->vol[s] = volume_(x);
+
+					for (int n = 0; n < 3; ++n)
+					{
+						if (d[n] <= 1)
+							continue;
+
+						coordinates_type xf = x;
+
+						xf[n] -= 0.5 * h[n];
+
+						l->W[n][s] = kappa_(n, xf) / (h[n] * h[n]);
+					}
+				}
+
+		// diagonal, Dirichlet faces count as u_nb=-u
+		for (idx[0] = 0; idx[0] < d[0]; ++idx[0])
+			for (idx[1] = 0; idx[1] < d[1]; ++idx[1])
+				for (idx[2] = 0; idx[2] < d[2]; ++idx[2])
+				{
+					size_t s = hash_(d, idx[0], idx[1], idx[2]);
+
+					Real a = 0;
+
+					for (int n = 0; n < 3; ++n)
+					{
+						if (d[n] <= 1)
+							continue;
+
+						Real w_lo = l->W[n][s], w_hi = high_face_(*l, idx, n);
+
+						bool lo_bnd = idx[n] == 0 && !periodic_[n];
+						bool hi_bnd = idx[n] == d[n] - 1 && !periodic_[n];
+
+						a += w_lo * (lo_bnd ? 2.0 : 1.0)
+								+ w_hi * (hi_bnd ? 2.0 : 1.0);
+					}
+
+					l->diag[s] = a;
+				}
+	}
+
+	/// coefficient of the high face of cell 'idx' along 'n'
+	Real high_face_(Level const & l, index_tuple idx, int n) const
+	{
+		if (idx[n] + 1 < l.dims[n])
+		{
+			++idx[n];
+			return l.W[n][hash_(l.dims, idx[0], idx[1], idx[2])];
+		}
+		else if (periodic_[n])
+		{
+			idx[n] = 0;
+			return l.W[n][hash_(l.dims, idx[0], idx[1], idx[2])];
+		}
+		else
+		{
+			coordinates_type x;
+			for (int m = 0; m < 3; ++m)
+			{
+				x[m] = xmin_[m] + (idx[m] + 0.5) * l.dx[m];
+			}
+			x[n] += 0.5 * l.dx[n];
+			return kappa_(n, x) / (l.dx[n] * l.dx[n]);
+		}
+	}
+
+	/// off-diagonal part  \f$\sum_{nb} W u_{nb}\f$ of cell idx
+	Real neighbour_sum_(Level const & l, vector_type const & u, index_type i,
+			index_type j, index_type k) const
+	{
+		index_tuple idx = { i, j, k };
+
+		size_t s = hash_(l.dims, i, j, k);
+
+		Real sum = 0;
+
+		for (int n = 0; n < 3; ++n)
+		{
+			index_type N = l.dims[n];
+
+			if (N <= 1)
+				continue;
+
+			index_tuple lo = idx, hi = idx;
+
+			lo[n] -= 1;
+			hi[n] += 1;
+
+			if (idx[n] > 0 || periodic_[n])
+			{
+				lo[n] = (lo[n] + N) % N;
+				sum += l.W[n][s] * u[hash_(l.dims, lo[0], lo[1], lo[2])];
+			}
+
+			if (idx[n] < N - 1 || periodic_[n])
+			{
+				hi[n] = hi[n] % N;
+				sum += high_face_(l, idx, n)
+						* u[hash_(l.dims, hi[0], hi[1], hi[2])];
+			}
+		}
+
+		return sum;
+	}
+
+	void apply_(Level const & l, vector_type const & x, vector_type * y) const
+	{
+		y->resize(x.size());
+
+		for_each_slab_(l, [&](index_type ib, index_type ie)
+		{
+			for (index_type i = ib; i < ie; ++i)
+			for (index_type j = 0; j < l.dims[1]; ++j)
+			for (index_type k = 0; k < l.dims[2]; ++k)
+			{
+				size_t s = hash_(l.dims, i, j, k);
+				(*y)[s] = l.diag[s] * x[s] - neighbour_sum_(l, x, i, j, k);
+			}
+		});
+	}
+
+	void residual_(Level const & l, vector_type * r) const
+	{
+		apply_(l, l.u, r);
+
+		for (size_t s = 0; s < r->size(); ++s)
+		{
+			(*r)[s] = l.f[s] - (*r)[s];
+		}
+	}
+
+	/// 'fun(ib,ie)' on slabs of the first axis, in parallel
+	template<typename TFun>
+	void for_each_slab_(Level const & l, TFun const & fun) const
+	{
+		index_type N = l.dims[0];
+
+		index_type num = std::min(
+				static_cast<index_type>(
+						num_of_threads > 0 ?
+								num_of_threads : GLOBAL_COMM.get_num_of_threads()),
+				N);
+
+		if (num <= 1 || NProduct(l.dims) < 4096)
+		{
+			fun(0, N);
+			return;
+		}
+
+		std::vector<std::future<void>> res;
+
+		for (index_type n = 0; n < num; ++n)
+		{
+			index_type ib = (N * n) / num, ie = (N * (n + 1)) / num;
+
+			res.push_back(std::async(std::launch::async, [=,&fun]()
+			{	fun(ib,ie);}));
+		}
+
+		for (auto & f : res)
+		{
+			f.get();
+		}
+	}
+
+	/// red-black Gauss-Seidel, red first, or black first if 'reverse'
+	void smooth_(Level & l, size_t num_of_sweeps, bool reverse = false) const
+	{
+		for (size_t sweep = 0; sweep < num_of_sweeps; ++sweep)
+			for (index_type n = 0; n < 2; ++n)
+			{
+				index_type color = reverse ? 1 - n : n;
+
+				for_each_slab_(l, [&](index_type ib, index_type ie)
+				{
+					for (index_type i = ib; i < ie; ++i)
+					for (index_type j = 0; j < l.dims[1]; ++j)
+					for (index_type k = (i + j + color) % 2; k < l.dims[2]; k += 2)
+					{
+						size_t s = hash_(l.dims, i, j, k);
+						l.u[s] = (l.f[s] + neighbour_sum_(l, l.u, i, j, k)) / l.diag[s];
+					}
+				});
+			}
+	}
+
+	/**
+	 *  'fun(s,w)' on the coarse cells 's' of the linear interpolation to fine
+	 *  cell (i,j,k), with weights 'w'
+	 */
+	template<typename TFun>
+	void for_each_parent_(Level const & coarse, index_tuple const & ratio,
+			index_type i, index_type j, index_type k, TFun const & fun) const
+	{
+		index_tuple f_idx =
+		{	i, j, k};
+
+		// coarse cell, neighbour on the side of the fine cell, weights
+		index_type c[3], nb[3];
+		Real w[3];
+		bool has_nb[3];
+
+		for (int n = 0; n < 3; ++n)
+		{
+			c[n] = f_idx[n] / ratio[n];
+			nb[n] = c[n];
+			w[n] = 1.0;
+			has_nb[n] = false;
+
+			if (ratio[n] == 2)
+			{
+				index_type side = (f_idx[n] % 2 == 0) ? -1 : 1;
+				index_type N = coarse.dims[n];
+
+				nb[n] = c[n] + side;
+
+				if (nb[n] < 0 || nb[n] >= N)
+				{
+					if (periodic_[n])
+					{
+						nb[n] = (nb[n] + N) % N;
+						has_nb[n] = true;
+					}
+					else
+					{
+						// ghost is -u, 0.75 u - 0.25 u
+						has_nb[n] = false;
+						w[n] = 0.5;
+						continue;
+					}
+				}
+				else
+				{
+					has_nb[n] = true;
+				}
+				w[n] = 0.75;
+			}
+		}
+
+		for (int q = 0; q < 8; ++q)
+		{
+			Real weight = 1.0;
+			index_type id[3];
+			bool skip = false;
+
+			for (int n = 0; n < 3; ++n)
+			{
+				bool use_nb = (q >> n) & 1;
+
+				if (use_nb)
+				{
+					if (!has_nb[n])
+					{
+						skip = true;
+						break;
+					}
+					id[n] = nb[n];
+					weight *= 1.0 - w[n];
+				}
+				else
+				{
+					id[n] = c[n];
+					weight *= (ratio[n] == 2) ? w[n] : 1.0;
+				}
+			}
+
+			if (!skip)
+			{
+				fun(hash_(coarse.dims, id[0], id[1], id[2]), weight);
+			}
+		}
+	}
+
+	/**
+	 *  coarse f = transpose of prolong_ applied to the fine residual, divided
+	 *  by the number of children (full weighting). R ~ P^T keeps the V-cycle
+	 *  symmetric.
+	 */
+	void restrict_(Level const & fine, Level * coarse) const
+	{
+		std::fill(coarse->f.begin(), coarse->f.end(), 0);
+
+		index_tuple ratio;
+		for (int n = 0; n < 3; ++n)
+		{
+			ratio[n] = fine.dims[n] / coarse->dims[n];
+		}
+
+		Real a = 1.0 / static_cast<Real>(NProduct(ratio));
+
+		for (index_type i = 0; i < fine.dims[0]; ++i)
+			for (index_type j = 0; j < fine.dims[1]; ++j)
+				for (index_type k = 0; k < fine.dims[2]; ++k)
+				{
+					Real r = a * fine.r[hash_(fine.dims, i, j, k)];
+
+					for_each_parent_(*coarse, ratio, i, j, k,
+							[&](size_t s, Real weight)
+							{
+								coarse->f[s] += weight * r;
+							});
+				}
+	}
+
+	/// fine u += linear interpolation of coarse u
+	void prolong_(Level const & coarse, Level * fine) const
+	{
+		index_tuple ratio;
+		for (int n = 0; n < 3; ++n)
+		{
+			ratio[n] = fine->dims[n] / coarse.dims[n];
+		}
+
+		for_each_slab_(*fine, [&](index_type ib, index_type ie)
+		{
+			for (index_type i = ib; i < ie; ++i)
+			for (index_type j = 0; j < fine->dims[1]; ++j)
+			for (index_type k = 0; k < fine->dims[2]; ++k)
+			{
+				Real v = 0;
+
+				for_each_parent_(coarse, ratio, i, j, k, [&](size_t s, Real weight)
+						{
+							v += weight * coarse.u[s];
+						});
+
+				fine->u[hash_(fine->dims, i, j, k)] += v;
+			}
+		});
+	}
+
+	void vcycle_(size_t n) const
+	{
+		Level & l = levels_[n];
+
+		if (n + 1 == levels_.size())
+		{
+			smooth_(l, (num_of_coarse_smooth + 1) / 2);
+			smooth_(l, (num_of_coarse_smooth + 1) / 2, true);
+
+			if (singular_)
+			{
+				remove_mean_(&l.u);
+			}
+			return;
+		}
+
+		smooth_(l, num_of_pre_smooth);
+
+		residual_(l, &l.r);
+
+		Level & c = levels_[n + 1];
+
+		restrict_(l, &c);
+
+		std::fill(c.u.begin(), c.u.end(), 0);
+
+		vcycle_(n + 1);
+
+		prolong_(c, &l);
+
+		smooth_(l, num_of_post_smooth, true);
+	}
+};
+
+/**
+ *  \brief metric of  \f$\nabla^2\f$ in cylindrical coordinates for Multigrid
+ *
+ *   \f$ \frac{1}{R}\partial_R(R\partial_R u)+\frac{1}{R^2}\partial^2_\phi u
+ *   +\partial^2_Z u \f$ times the volume factor R
+ *
+ * @return <kappa, volume>
+ */
+inline std::tuple<Multigrid::kappa_fun, Multigrid::volume_fun> cylindrical_metric(
+		size_t RAxis, size_t ZAxis, size_t PhiAxis)
+{
+	Multigrid::kappa_fun kappa =
+			[=](size_t n, Multigrid::coordinates_type const & x)
+			{
+				return (n == PhiAxis) ? 1.0/x[RAxis] : x[RAxis];
+			};
+
+	Multigrid::volume_fun volume = [=](Multigrid::coordinates_type const & x)
+	{
+		return x[RAxis];
+	};
+
+	return std::make_tuple(kappa, volume);
+}
+
+//! @}
+}// namespace simpla
+
+#endif /* MULTIGRID_H_ */
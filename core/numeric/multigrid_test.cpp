@@ -0,0 +1,125 @@
+/**
+ * \file multigrid_test.cpp
+ *
+ * \date    2014年11月16日  上午9:20:41
+ * \author salmon
+ */
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <random>
+
+#include "multigrid.h"
+
+using namespace simpla;
+
+class TestMultigrid: public testing::Test
+{
+protected:
+	void SetUp()
+	{
+		Multigrid::index_tuple dims = { N, N, N };
+		Multigrid::coordinates_type xmin = { 0, 0, 0 };
+		Multigrid::coordinates_type dx = { 1.0 / N, 1.0 / N, 1.0 / N };
+		nTuple<bool, 3> periodic = { false, false, false };
+
+		mg.init(dims, xmin, dx, periodic);
+
+		std::mt19937 gen;
+		std::uniform_real_distribution<Real> dist(-1, 1);
+
+		Multigrid::vector_type f(mg.size());
+
+		for (auto & v : f)
+		{
+			v = dist(gen);
+		}
+
+		mg.make_rhs(f, &b);
+	}
+public:
+	static constexpr Multigrid::index_type N = 64;
+
+	Multigrid mg;
+
+	Multigrid::vector_type b;
+
+	Real residual(Multigrid::vector_type const & u) const
+	{
+		Multigrid::vector_type Au;
+
+		mg.apply(u, &Au);
+
+		Real rr = 0, bb = 0;
+
+		for (size_t s = 0; s < b.size(); ++s)
+		{
+			rr += (b[s] - Au[s]) * (b[s] - Au[s]);
+			bb += b[s] * b[s];
+		}
+
+		return std::sqrt(rr / bb);
+	}
+};
+
+constexpr Multigrid::index_type TestMultigrid::N;
+
+TEST_F(TestMultigrid, vcycle)
+{
+	Multigrid::vector_type u(mg.size(), 0);
+
+	auto status = mg.solve(b, &u);
+
+	EXPECT_TRUE(status.converged);
+	EXPECT_LE(status.iterations, 15);
+	EXPECT_LE(residual(u), mg.tolerance);
+}
+
+TEST_F(TestMultigrid, pcg)
+{
+	Multigrid::vector_type u(mg.size(), 0);
+
+	krylov::KrylovOptions opt;
+
+	opt.relative_tolerance = 1.0e-10;
+
+	auto status = krylov::pcg([&](Multigrid::vector_type const & x,
+			Multigrid::vector_type * y)
+	{	mg.apply(x,y);}, b, &u, mg, opt);
+
+	EXPECT_TRUE(status.converged);
+	EXPECT_LE(status.iterations, 9);
+	EXPECT_LE(residual(u), 1.0e-10);
+}
+
+/**
+ *  one V-cycle is a symmetric operator, <M x,y> = <x,M y>
+ */
+TEST_F(TestMultigrid, symmetric)
+{
+	std::mt19937 gen(1);
+	std::uniform_real_distribution<Real> dist(-1, 1);
+
+	Multigrid::vector_type x(mg.size()), y(mg.size()), Mx, My;
+
+	for (size_t s = 0; s < x.size(); ++s)
+	{
+		x[s] = dist(gen);
+		y[s] = dist(gen);
+	}
+
+	mg(x, &Mx);
+	mg(y, &My);
+
+	Real xMy = 0, yMx = 0, xMx = 0;
+
+	for (size_t s = 0; s < x.size(); ++s)
+	{
+		xMy += x[s] * My[s];
+		yMx += y[s] * Mx[s];
+		xMx += x[s] * Mx[s];
+	}
+
+	EXPECT_GT(xMx, 0);
+	EXPECT_NEAR(0, (xMy - yMx) / xMx, 1.0e-12);
+}
@@ -8,6 +8,8 @@
 #ifndef POINTINPOLYGEN_H_
 #define POINTINPOLYGEN_H_
 
+#include <algorithm>
+#include <cmath>
 #include <vector>
 
 #include "../utilities/ntuple.h"
@@ -19,14 +21,80 @@ namespace simpla
 /**
  *  \ingroup Numeric  GeometryAlgorithm
  *  \brief check a point in 2D polygon
+ *
+ *   Edges are bucketed into  horizontal strips of equal height, a query only
+ *   tests the edges in the strip of 'y', so the cost is O(1) for regular
+ *   contours instead of O(num_of_vertex).
  */
 class PointInPolygon
 {
 
 	std::vector<nTuple<double, 2> > polygen_;
 	size_t num_of_vertex_;
-	std::vector<double> constant_;
-	std::vector<double> multiple_;
+	std::vector<double> multiple_; //!< dx/dy of edge (i-1,i)
+
+	nTuple<double, 2> xmin_, xmax_;
+
+	double inv_strip_height_ = 0;
+
+	size_t num_of_strips_ = 1;
+
+	/// strip n owns edges strip_edges_[strip_begin_[n],strip_begin_[n+1])
+	std::vector<size_t> strip_begin_;
+	std::vector<size_t> strip_edges_;
+
+	size_t strip_(double y) const
+	{
+		double d = (y - xmin_[1]) * inv_strip_height_;
+
+		return (d <= 0) ? 0 : std::min(static_cast<size_t>(d), num_of_strips_ - 1);
+	}
+
+	void build_strips_()
+	{
+		xmin_ = polygen_[0];
+		xmax_ = polygen_[0];
+
+		for (auto const & v : polygen_)
+		{
+			xmin_[0] = std::min(xmin_[0], v[0]);
+			xmin_[1] = std::min(xmin_[1], v[1]);
+			xmax_[0] = std::max(xmax_[0], v[0]);
+			xmax_[1] = std::max(xmax_[1], v[1]);
+		}
+
+		num_of_strips_ = std::max(num_of_vertex_, static_cast<size_t>(1));
+
+		inv_strip_height_ =
+				(xmax_[1] > xmin_[1]) ?
+						num_of_strips_ / (xmax_[1] - xmin_[1]) : 0;
+
+		std::vector<std::vector<size_t>> strips(num_of_strips_);
+
+		for (size_t i = 0, j = num_of_vertex_ - 1; i < num_of_vertex_; i++)
+		{
+			size_t b = strip_(std::min(polygen_[i][1], polygen_[j][1]));
+			size_t e = strip_(std::max(polygen_[i][1], polygen_[j][1]));
+
+			for (size_t n = b; n <= e; ++n)
+			{
+				strips[n].push_back(i);
+			}
+			j = i;
+		}
+
+		strip_begin_.resize(num_of_strips_ + 1);
+		strip_edges_.clear();
+
+		for (size_t n = 0; n < num_of_strips_; ++n)
+		{
+			strip_begin_[n] = strip_edges_.size();
+			strip_edges_.insert(strip_edges_.end(), strips[n].begin(),
+					strips[n].end());
+		}
+		strip_begin_[num_of_strips_] = strip_edges_.size();
+	}
+
 public:
 	template<size_t N>
 	PointInPolygon(std::vector<nTuple<double, N> > const &polygen, size_t Z = 2) :
@@ -39,42 +107,24 @@ public:
 			{ v[(Z + 1) % 3], v[(Z + 2) % 3] }));
 		}
 		num_of_vertex_ = polygen_.size();
-		constant_.resize(num_of_vertex_);
 		multiple_.resize(num_of_vertex_);
 
 		for (size_t i = 0, j = num_of_vertex_ - 1; i < num_of_vertex_; i++)
 		{
-			if (polygen_[j][1] == polygen_[i][1])
-			{
-				constant_[i] = polygen_[i][0];
-				multiple_[i] = 0;
-			}
-			else
-			{
-				constant_[i] = polygen_[i][0]
-						- (polygen_[i][1] * polygen_[j][0])
-								/ (polygen_[j][1] - polygen_[i][1])
-						+ (polygen_[i][1] * polygen_[i][0])
-								/ (polygen_[j][1] - polygen_[i][1]);
-				multiple_[i] = (polygen_[j][0] - polygen_[i][0])
-						/ (polygen_[j][1] - polygen_[i][1]);
-			}
+			multiple_[i] =
+					(polygen_[j][1] == polygen_[i][1]) ?
+							0 :
+							(polygen_[j][0] - polygen_[i][0])
+									/ (polygen_[j][1] - polygen_[i][1]);
 			j = i;
 		}
-	}
-
-	PointInPolygon(PointInPolygon const& rhs) :
-			polygen_(rhs.polygen_), num_of_vertex_(rhs.num_of_vertex_), constant_(
-					rhs.constant_), multiple_(rhs.multiple_)
-	{
 
+		build_strips_();
 	}
-	PointInPolygon(PointInPolygon && rhs) :
-			polygen_(rhs.polygen_), num_of_vertex_(rhs.num_of_vertex_), constant_(
-					rhs.constant_), multiple_(rhs.multiple_)
-	{
 
-	}
+	PointInPolygon(PointInPolygon const& rhs) = default;
+
+	PointInPolygon(PointInPolygon && rhs) = default;
 
 	template<typename ...Args>
 	inline bool operator()(Args &&... args) const
@@ -90,23 +140,48 @@ public:
 
 	inline bool IsInside(double x, double y) const
 	{
+		if (!(y > xmin_[1] && y <= xmax_[1] && x > xmin_[0]))
+		{
+			return false;
+		}
 
 		bool oddNodes = false;
 
-		for (size_t i = 0, j = num_of_vertex_ - 1; i < num_of_vertex_; i++)
+		size_t n = strip_(y);
+
+		for (size_t k = strip_begin_[n], ke = strip_begin_[n + 1]; k < ke; ++k)
 		{
+			size_t i = strip_edges_[k];
+			size_t j = (i == 0) ? num_of_vertex_ - 1 : i - 1;
+
 			if (((polygen_[i][1] < y) && (polygen_[j][1] >= y))
 					|| ((polygen_[j][1] < y) && (polygen_[i][1] >= y)))
 			{
-				oddNodes ^= (y * multiple_[i] + constant_[i] < x);
+				// relative to vertex i, exact for vertical edges
+				oddNodes ^= (polygen_[i][0] + (y - polygen_[i][1]) * multiple_[i]
+						< x);
 			}
-
-			j = i;
 		}
 
 		return oddNodes;
 	}
 
+	/**
+	 *  batched query, res[n]=IsInside(x[n]), 'res' has x.size() elements
+	 */
+	template<size_t N>
+	void IsInside(std::vector<nTuple<double, N> > const & x, bool *res,
+			size_t ZAxis = 2) const
+	{
+		long num = static_cast<long>(x.size());
+
+#pragma omp parallel for
+		for (long n = 0; n < num; ++n)
+		{
+			res[n] = IsInside(x[n][(ZAxis + 1) % 3], x[n][(ZAxis + 2) % 3]);
+		}
+	}
+
 	template<size_t N>
 	std::tuple<bool, nTuple<double, N>> Intersection(
 			nTuple<double, N> const & x0, nTuple<double, N> const &x1,
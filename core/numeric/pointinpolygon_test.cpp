@@ -0,0 +1,160 @@
+/**
+ * \file pointinpolygon_test.cpp
+ *
+ * \date    2014年11月18日  上午10:45:16
+ * \author salmon
+ */
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "pointinpolygon.h"
+
+using namespace simpla;
+
+typedef nTuple<double, 3> point_type;
+
+/**
+ *  crossing test over all edges, as PointInPolygon without strips. Points
+ *  on an edge are decided by the rounding of the crossing, so it is
+ *  computed by the same expression.
+ */
+bool brute_force_inside(std::vector<point_type> const & polygon, double x,
+		double y)
+{
+	bool odd = false;
+
+	for (size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++)
+	{
+		double xi = polygon[i][0], yi = polygon[i][1];
+		double xj = polygon[j][0], yj = polygon[j][1];
+
+		if ((yi < y && yj >= y) || (yj < y && yi >= y))
+		{
+			odd ^= (xi + (y - yi) * ((xj - xi) / (yj - yi)) < x);
+		}
+	}
+
+	return odd;
+}
+
+class TestPointInPolygon: public testing::TestWithParam<
+		std::vector<point_type> >
+{
+protected:
+	void SetUp()
+	{
+		polygon = GetParam();
+
+		// Z=2, the polygon is in the xy plane
+		for (auto const & v : polygon)
+		{
+			vertices.push_back(point_type( { v[0], v[1], 0 }));
+		}
+	}
+public:
+	std::vector<point_type> polygon, vertices;
+
+	/// vertices, points on the edges, and points around them
+	std::vector<point_type> special_points() const
+	{
+		std::vector<point_type> res;
+
+		for (size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++)
+		{
+			for (double a : { 0.0, 0.25, 0.5, 0.75 })
+			{
+				point_type x = polygon[j] + (polygon[i] - polygon[j]) * a;
+
+				for (double dx : { -0.5, 0.0, 0.5 })
+					for (double dy : { -0.5, 0.0, 0.5 })
+					{
+						res.push_back(point_type( { x[0] + dx, x[1] + dy, 0 }));
+					}
+			}
+		}
+
+		return res;
+	}
+};
+
+TEST_P(TestPointInPolygon, special_points)
+{
+	PointInPolygon poly(vertices);
+
+	for (auto const & x : special_points())
+	{
+		EXPECT_EQ(brute_force_inside(polygon, x[0], x[1]), poly(x[0], x[1]))
+				<< "x= " << x[0] << " y= " << x[1];
+	}
+}
+
+TEST_P(TestPointInPolygon, random_points)
+{
+	PointInPolygon poly(vertices);
+
+	std::mt19937 gen;
+	std::uniform_real_distribution<double> dist(-1, 9);
+
+	std::vector<point_type> points(10000);
+
+	for (auto & x : points)
+	{
+		x = point_type( { dist(gen), dist(gen), 0 });
+	}
+
+	std::unique_ptr<bool[]> res(new bool[points.size()]);
+
+	poly.IsInside(points, res.get());
+
+	size_t count = 0;
+
+	for (size_t n = 0; n < points.size(); ++n)
+	{
+		bool expect = brute_force_inside(polygon, points[n][0], points[n][1]);
+
+		EXPECT_EQ(expect, poly(points[n][0], points[n][1]));
+
+		// batched query, nTuple query along Z
+		EXPECT_EQ(expect, res[n]);
+		EXPECT_EQ(expect, poly.IsInside(points[n]));
+
+		count += expect ? 1 : 0;
+	}
+
+	EXPECT_GT(count, 0);
+	EXPECT_LT(count, points.size());
+}
+
+/// smooth contour of many vertices, r=3+sin(5 theta)/2
+std::vector<point_type> flower(size_t num)
+{
+	std::vector<point_type> res;
+
+	for (size_t n = 0; n < num; ++n)
+	{
+		double theta = 2.0 * M_PI * n / num;
+		double r = 3.0 + 0.5 * std::sin(5 * theta);
+
+		res.push_back(
+				point_type( { 4 + r * std::cos(theta), 4 + r * std::sin(theta), 0 }));
+	}
+
+	return res;
+}
+
+INSTANTIATE_TEST_CASE_P(PointInPolygon, TestPointInPolygon, testing::Values(
+// convex: square, diamond, triangle
+		std::vector<point_type>( { { 0, 0, 0 }, { 8, 0, 0 }, { 8, 8, 0 }, { 0, 8, 0 } }),
+		std::vector<point_type>( { { 4, 0, 0 }, { 8, 4, 0 }, { 4, 8, 0 }, { 0, 4, 0 } }),
+		std::vector<point_type>( { { 0, 0, 0 }, { 8, 2, 0 }, { 2, 8, 0 } }),
+// concave: comb, arrow, star
+		std::vector<point_type>( { { 0, 0, 0 }, { 8, 0, 0 }, { 8, 8, 0 }, { 6, 8, 0 }, { 6, 2, 0 },
+				{ 4, 2, 0 }, { 4, 8, 0 }, { 2, 8, 0 }, { 2, 2, 0 }, { 0, 2, 0 } }),
+		std::vector<point_type>( { { 0, 0, 0 }, { 8, 4, 0 }, { 0, 8, 0 }, { 4, 4, 0 } }),
+		std::vector<point_type>( { { 4, 0, 0 }, { 5, 3, 0 }, { 8, 4, 0 }, { 5, 5, 0 }, { 4, 8, 0 },
+				{ 3, 5, 0 }, { 0, 4, 0 }, { 3, 3, 0 } }),
+		flower(200)));
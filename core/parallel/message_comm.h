@@ -26,6 +26,7 @@ class MessageComm
 	int num_process_;
 	int process_num_;
 	MPI_Comm comm_;
+	int thread_support_ = MPI_THREAD_SINGLE;
 public:
 	MessageComm() :
 			num_process_(1), process_num_(0), comm_(MPI_COMM_NULL), num_threads_(
@@ -44,16 +45,17 @@ public:
 		close();
 	}
 
+	/**
+	 *  hybrid MPI+threads: --number_of_threads <N> threads per rank, MPI is
+	 *  initialized with MPI_THREAD_FUNNELED (only the master thread calls MPI),
+	 *  or MPI_THREAD_MULTIPLE with --mpi_thread_multiple. If the MPI library
+	 *  does not provide the required level, threads are disabled.
+	 */
 	void init(int argc = 0, char** argv = nullptr)
 	{
 		if (comm_ == MPI_COMM_NULL)
 		{
-			MPI_Init(&argc, &argv);
-			if (comm_ == MPI_COMM_NULL)
-				comm_ = MPI_COMM_WORLD;
-
-			MPI_Comm_size(comm_, &num_process_);
-			MPI_Comm_rank(comm_, &process_num_);
+			int required = MPI_THREAD_FUNNELED;
 
 			ParseCmdLine(argc, argv,
 
@@ -63,6 +65,10 @@ public:
 				{
 					num_threads_ =ToValue<size_t>(value);
 				}
+				else if( opt=="mpi_thread_multiple")
+				{
+					required = MPI_THREAD_MULTIPLE;
+				}
 
 				return CONTINUE;
 
@@ -70,9 +76,39 @@ public:
 
 			);
 
+			int is_initialized = 0;
+
+			MPI_Initialized(&is_initialized);
+
+			if (!is_initialized)
+			{
+				MPI_Init_thread(&argc, &argv, required, &thread_support_);
+			}
+			else
+			{
+				MPI_Query_thread(&thread_support_);
+			}
+
+			if (thread_support_ < MPI_THREAD_FUNNELED)
+			{
+				num_threads_ = 1;
+			}
+
+			if (comm_ == MPI_COMM_NULL)
+				comm_ = MPI_COMM_WORLD;
+
+			MPI_Comm_size(comm_, &num_process_);
+			MPI_Comm_rank(comm_, &process_num_);
+
 		}
 
 	}
+
+	/// thread level provided by MPI, MPI_THREAD_SINGLE ... MPI_THREAD_MULTIPLE
+	int get_thread_support() const
+	{
+		return thread_support_;
+	}
 	void close()
 	{
 		if (comm_ != MPI_COMM_NULL)
@@ -7,6 +7,8 @@
 
 #include "mpi_aux_functions.h"
 
+#include <numeric>
+
 extern "C"
 {
 #include <mpi.h>
@@ -22,52 +24,44 @@ namespace simpla
 {
 
 /**
- * @param pos in {0,count} out {begin,shape}
+ * @param count number of local elements
+ * @return {begin,total}, begin is the sum of count on ranks before this one,
+ *         total is the sum over all ranks
+ *
+ *  exclusive scan and reduction are issued as non-blocking collectives and
+ *  completed together, there is no barrier or serial prefix on rank 0.
  */
-std::tuple<int, int> sync_global_location(int count)
+std::tuple<size_t, size_t> sync_global_location(size_t count)
 {
-	int begin = 0;
+	unsigned long long local = count;
 
-	if ( GLOBAL_COMM.is_ready() && GLOBAL_COMM.get_size() > 1)
-	{
+	unsigned long long begin = 0;
 
-		auto communicator = GLOBAL_COMM.comm();
+	unsigned long long total = local;
 
-		int num_of_process = GLOBAL_COMM.get_size();
-		int porcess_number = GLOBAL_COMM.get_rank();
-
-		MPIDataType m_type =MPIDataType::create<int>();
+	if (GLOBAL_COMM.is_ready() && GLOBAL_COMM.get_size() > 1)
+	{
+		auto communicator = GLOBAL_COMM.comm();
 
-		std::vector<int> buffer;
+		MPI_Request requests[2];
 
-		if (porcess_number == 0)
-		buffer.resize(num_of_process);
+		MPI_Iexscan(&local, &begin, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM,
+				communicator, &requests[0]);
 
-		MPI_Gather(&count, 1, m_type.type(), &buffer[0], 1, m_type.type(), 0, communicator);
+		MPI_Iallreduce(&local, &total, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM,
+				communicator, &requests[1]);
 
-		MPI_Barrier(communicator);
+		MPI_Waitall(2, requests, MPI_STATUSES_IGNORE);
 
-		if (porcess_number == 0)
+		// result of exscan is undefined on rank 0
+		if (GLOBAL_COMM.get_rank() == 0)
 		{
-			for (int i = 1; i < num_of_process; ++i)
-			{
-				buffer[i] += buffer[i - 1];
-			}
-			buffer[0] = count;
-			count = buffer[num_of_process - 1];
-
-			for (int i = num_of_process - 1; i > 0; --i)
-			{
-				buffer[i] = buffer[i - 1];
-			}
-			buffer[0] = 0;
+			begin = 0;
 		}
-		MPI_Barrier(communicator);
-		MPI_Scatter(&buffer[0], 1, m_type.type(), &begin, 1, m_type.type(), 0, communicator);
-		MPI_Bcast(&count, 1, m_type.type(), 0, communicator);
 	}
 
-	return std::make_tuple(begin, count);
+	return std::make_tuple(static_cast<size_t>(begin),
+			static_cast<size_t>(total));
 
 }
 inline MPI_Op get_MPI_Op(std::string const & op_c)
@@ -12,21 +12,19 @@ namespace simpla
 {
 
 /**
- * @param   in count out {begin,total}
+ * @param   in count out {begin,total}, 64 bit
  */
-
-std::tuple<int, int> sync_global_location(int count);
+std::tuple<size_t, size_t> sync_global_location(size_t count);
 
 template<typename Integral>
 std::tuple<Integral, Integral> sync_global_location(Integral count)
 {
-	int n = count;
-	int begin, total;
-	std::tie(begin, total) = sync_global_location(n);
-	Integral rbegin = begin;
-	Integral rtotal = static_cast<Integral>(total);
+	size_t begin, total;
+
+	std::tie(begin, total) = sync_global_location(static_cast<size_t>(count));
 
-	return std::make_tuple(rbegin, rtotal);
+	return std::make_tuple(static_cast<Integral>(begin),
+			static_cast<Integral>(total));
 
 }
 void reduce(void const* send_data, void * recv_data, size_t count,
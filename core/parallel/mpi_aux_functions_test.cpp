@@ -0,0 +1,59 @@
+/**
+ * \file mpi_aux_functions_test.cpp
+ *
+ * \date    2014年11月20日  下午3:12:40
+ * \author salmon
+ */
+
+#include <gtest/gtest.h>
+#include <tuple>
+#include <vector>
+
+extern "C"
+{
+#include <mpi.h>
+}
+
+#include "message_comm.h"
+#include "mpi_aux_functions.h"
+
+using namespace simpla;
+
+/**
+ *  begin and total of sync_global_location agree with a blocking
+ *  MPI_Exscan/MPI_Allreduce, for every rank count (run it by mpirun -np N)
+ */
+TEST(MPIAuxFunctions, sync_global_location)
+{
+	GLOBAL_COMM.init();
+
+	int rank = GLOBAL_COMM.get_rank();
+
+	// zero, small, and beyond 32 bit
+	std::vector<unsigned long long> counts = { 0, 1ULL + 3 * rank, (1ULL << 33)
+			+ rank, rank % 2 == 0 ? 0ULL : 7ULL };
+
+	for (auto count : counts)
+	{
+		unsigned long long begin = 0, total = 0;
+
+		MPI_Exscan(&count, &begin, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM,
+				GLOBAL_COMM.comm());
+
+		MPI_Allreduce(&count, &total, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM,
+				GLOBAL_COMM.comm());
+
+		// result of exscan is undefined on rank 0
+		if (rank == 0)
+		{
+			begin = 0;
+		}
+
+		size_t b, t;
+
+		std::tie(b, t) = sync_global_location(count);
+
+		EXPECT_EQ(begin, b) << "rank = " << rank << " count = " << count;
+		EXPECT_EQ(total, t) << "rank = " << rank << " count = " << count;
+	}
+}
@@ -8,6 +8,7 @@
 #ifndef MULTI_THREAD_STD_THREAD_H_
 #define MULTI_THREAD_STD_THREAD_H_
 
+#include <algorithm>
 #include <vector>
 #include <iostream>
 
@@ -0,0 +1,184 @@
+/**
+ * \file numa_placement.h
+ *
+ * \date    2014年10月22日  上午10:05:12
+ * \author salmon
+ */
+
+#ifndef NUMA_PLACEMENT_H_
+#define NUMA_PLACEMENT_H_
+
+#include <stdint.h>
+#include <unistd.h>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef USE_NUMA
+#include <numaif.h>
+#endif
+
+#include "message_comm.h"
+#include "parallel.h"
+#include "thread_pool.h"
+
+namespace simpla
+{
+/**
+ *  \ingroup MULTICORE
+ *  \brief parallel zero initialization of 'data[0,num)'
+ *
+ *   The range is cut into 'num_of_threads' equal slabs, slab 'n' is written
+ *   by worker 'n' of THREAD_POOL. Pages that are touched for the first time
+ *   here are placed on the node of that worker, which is not the node of the
+ *   thread that sweeps them unless the data is laid out like the sweep.  Use
+ *   first_touch_tiles() for mesh data, pages already touched keep their node.
+ */
+template<typename TV>
+void first_touch(TV * data, size_t num,
+		size_t num_of_threads = GLOBAL_COMM.get_num_of_threads())
+{
+	if (num_of_threads <= 1 || num < num_of_threads)
+	{
+		std::memset(data, 0, num * sizeof(TV));
+
+		return;
+	}
+
+	THREAD_POOL.run(num_of_threads, [=](size_t n)
+	{
+		size_t b = (num * n) / num_of_threads;
+		size_t e = (num * (n + 1)) / num_of_threads;
+
+		std::memset(data + b, 0, (e - b) * sizeof(TV));
+	});
+}
+
+namespace _impl
+{
+template<typename TV, typename TDomain>
+struct zero_element
+{
+	TV * data;
+	TDomain const & domain;
+
+	template<typename TI>
+	void operator()(TI const & s) const
+	{
+		std::memset(data + domain.hash(s), 0, sizeof(TV));
+	}
+};
+}  // namespace _impl
+
+/**
+ *  \ingroup MULTICORE
+ *  \brief zero the elements data[domain.hash(s)] of 'domain' with
+ *   parallel_for(domain,...)
+ *
+ *   The sweep uses the tiles and pinned workers of every other
+ *   parallel_for(domain,...), so each page is first touched, and placed, on
+ *   the NUMA node of the worker that later computes on it, for any memory
+ *   layout of the domain.  Elements outside the domain (ghosts) are not
+ *   touched.
+ */
+template<typename TV, typename TDomain>
+void first_touch_tiles(TV * data, TDomain const & domain)
+{
+	parallel_for(domain, _impl::zero_element<TV, TDomain> { data, domain });
+}
+
+/**
+ *  \ingroup MULTICORE
+ *  \brief  count pages of [p,p+size) on each NUMA node
+ *
+ *  \return  res[i] is the number of pages on node i, res.back() is the number
+ *           of pages which are not touched yet. Return empty vector when NUMA
+ *           is not supported.
+ */
+inline std::vector<size_t> page_placement(void const * p, size_t size)
+{
+	std::vector<size_t> res;
+
+#ifdef USE_NUMA
+	if (p == nullptr || size == 0 || numa_available() == -1)
+	{
+		return res;
+	}
+
+	uintptr_t page_size = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+
+	uintptr_t b = reinterpret_cast<uintptr_t>(p) & ~(page_size - 1);
+
+	uintptr_t e = reinterpret_cast<uintptr_t>(p) + size;
+
+	std::vector<void *> pages;
+
+	for (; b < e; b += page_size)
+	{
+		pages.push_back(reinterpret_cast<void*>(b));
+	}
+
+	std::vector<int> status(pages.size(), -1);
+
+	// nodes==nullptr : only query the node of pages
+	if (move_pages(0, pages.size(), &pages[0], nullptr, &status[0], 0) != 0)
+	{
+		return res;
+	}
+
+	int num_of_nodes = numa_num_configured_nodes();
+
+	res.resize(num_of_nodes + 1, 0);
+
+	for (auto s : status)
+	{
+		if (s >= 0 && s < num_of_nodes)
+		{
+			++res[s];
+		}
+		else
+		{
+			++res[num_of_nodes];
+		}
+	}
+#endif
+
+	return res;
+}
+
+/**
+ *  \ingroup MULTICORE
+ *  \brief page placement in human readable form, i.e. "node0=50% node1=50% untouched=0%"
+ */
+inline std::string page_placement_to_string(void const * p, size_t size)
+{
+	auto count = page_placement(p, size);
+
+	if (count.empty())
+	{
+		return "unknown";
+	}
+
+	size_t total = 0;
+
+	for (auto n : count)
+	{
+		total += n;
+	}
+
+	std::ostringstream os;
+
+	for (size_t i = 0; i + 1 < count.size(); ++i)
+	{
+		os << "node" << i << "=" << (count[i] * 100 / total) << "% ";
+	}
+
+	os << "untouched=" << (count.back() * 100 / total) << "%";
+
+	return os.str();
+}
+
+}  // namespace simpla
+
+#endif /* NUMA_PLACEMENT_H_ */
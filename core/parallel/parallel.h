@@ -8,6 +8,14 @@
 #ifndef PARALLEL_H_
 #define PARALLEL_H_
 
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "message_comm.h"
+#include "thread_pool.h"
 //#include "multi_thread.h"
 
 /**
@@ -21,8 +29,22 @@
 namespace simpla
 {
 
+namespace _impl
+{
+template<typename Range>
+auto has_split_(Range const* r)
+->decltype(split(*r,std::size_t(1),std::size_t(0)),std::true_type());
+
+std::false_type has_split_(...);
+
+template<typename Range>
+struct has_split: public decltype(has_split_(static_cast<Range const*>(nullptr)))
+{
+};
+
 template<typename Range, typename OP>
-void parallel_for(Range const & range, OP const & op)
+void parallel_for_tiled(Range const & range, OP const & op,
+		std::integral_constant<bool, false>)
 {
 	for (auto const& s : range)
 	{
@@ -30,6 +52,88 @@ void parallel_for(Range const & range, OP const & op)
 	}
 }
 
+/**
+ *  hybrid MPI+threads, the block of this rank is cut into
+ *  GLOBAL_COMM.get_num_of_threads() tiles, tile 'n' is processed by worker
+ *  'n' of THREAD_POOL
+ */
+template<typename Range, typename OP>
+void parallel_for_tiled(Range const & range, OP const & op,
+		std::integral_constant<bool, true>)
+{
+	size_t num_of_threads = GLOBAL_COMM.get_num_of_threads();
+
+	if (num_of_threads <= 1 || ThreadPool::is_worker())
+	{
+		parallel_for_tiled(range, op, std::integral_constant<bool, false>());
+		return;
+	}
+
+	THREAD_POOL.run(num_of_threads, [&](size_t n)
+	{
+		for (auto const& s : split(range, num_of_threads, n))
+		{
+			op(s);
+		}
+	});
+}
+}  // namespace _impl
+
+/**
+ *  \ingroup MULTICORE
+ *
+ *  apply 'op' to each element of 'range', ranges that can be split by
+ *  split(range,num,n) are processed by GLOBAL_COMM.get_num_of_threads()
+ *  persistent workers of THREAD_POOL, others are processed serially. 'op' on different elements must
+ *  be independent. No MPI call is made inside, ghost exchange is done by the
+ *  calling (master) thread after all tiles are done.
+ */
+template<typename Range, typename OP>
+void parallel_for(Range const & range, OP const & op)
+{
+	_impl::parallel_for_tiled(range, op,
+			std::integral_constant<bool, _impl::has_split<Range>::value>());
+}
+
+/**
+ *  \ingroup MULTICORE
+ *
+ *  \brief parallel for  scatter kernels
+ *
+ *   'range' is cut into at most 2*num_of_threads slabs by split(range,num,n),
+ *   even slabs run in parallel on THREAD_POOL, then odd slabs, fun(slab,n) is
+ *   called for slab 'n'. The number of slabs is reduced until every slab is
+ *   at least 'stencil_width' cells thick along the axis split() cuts,
+ *   split_extent(range) cells long, so two concurrent slabs never write the
+ *   same point of a scatter stencil ( 4 cells for charge conserving
+ *   deposition). Below 4*stencil_width cells there are two slabs, one per
+ *   colour, and no slabs run concurrently.
+ */
+template<typename TRange, typename Func>
+void parallel_for_colored(TRange const & range, Func const & fun,
+		size_t num_of_threads = GLOBAL_COMM.get_num_of_threads(),
+		size_t stencil_width = 4)
+{
+	size_t num_of_slabs = 2 * std::max(num_of_threads, static_cast<size_t>(1));
+
+	size_t extent = split_extent(range);
+
+	while (num_of_slabs > 2 && extent < num_of_slabs * stencil_width)
+	{
+		num_of_slabs -= 2;
+	}
+
+	for (size_t color = 0; color < 2; ++color)
+	{
+		THREAD_POOL.run(num_of_slabs / 2, [&](size_t i)
+		{
+			size_t n = 2 * i + color;
+
+			fun(split(range, num_of_slabs, n), n);
+		});
+	}
+}
+
 template<typename Value, typename Range, typename OP, typename Reduction,
 		typename ... Args>
 Value parallel_reduce(const Range& range, const OP& op, const Reduction& reduce,
@@ -0,0 +1,202 @@
+/**
+ * \file parallel_test.cpp
+ *
+ * \date    2014年11月7日  上午9:40:12
+ * \author salmon
+ */
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "message_comm.h"
+#include "parallel.h"
+#include "thread_pool.h"
+#include "tile_range_test.h"
+
+using namespace simpla;
+
+TEST(Parallel, parallel_for_tiles)
+{
+	GLOBAL_COMM.set_num_of_threads(4);
+
+	size_t num = 10000;
+
+	std::vector<int> v(num, 0);
+
+	std::mutex m;
+
+	std::set<std::thread::id> ids;
+
+	parallel_for(TileRange(0, num), [&](size_t s)
+	{
+		v[s] += 1;
+
+		std::lock_guard<std::mutex> lock(m);
+		ids.insert(std::this_thread::get_id());
+	});
+
+	for (auto i : v)
+	{
+		EXPECT_EQ(1, i);
+	}
+
+	if (std::thread::hardware_concurrency() > 1)
+	{
+		EXPECT_GT(ids.size(), 1);
+	}
+
+	// ranges can not be split are processed serially
+	std::vector<size_t> r(100, 1);
+
+	size_t count = 0;
+
+	parallel_for(r, [&](size_t s)
+	{	count+=s;});
+
+	EXPECT_EQ(100, count);
+
+	GLOBAL_COMM.set_num_of_threads(1);
+}
+
+TEST(Parallel, thread_pool)
+{
+	GLOBAL_COMM.set_num_of_threads(4);
+
+	// set_num_of_threads is limited by the number of cpus
+	size_t num_of_threads = GLOBAL_COMM.get_num_of_threads();
+
+	if (num_of_threads <= 1)
+	{
+		return;
+	}
+
+	std::mutex m;
+
+	std::vector<std::set<std::thread::id>> ids(2);
+
+	for (int i = 0; i < 2; ++i)
+	{
+		parallel_for(TileRange(0, 1000), [&](size_t)
+		{
+			std::lock_guard<std::mutex> lock(m);
+			ids[i].insert(std::this_thread::get_id());
+		});
+	}
+
+	// workers are persistent, not created per call
+	EXPECT_EQ(num_of_threads, THREAD_POOL.size());
+
+	EXPECT_TRUE(ids[0] == ids[1]);
+
+	EXPECT_EQ(0, ids[0].count(std::this_thread::get_id()));
+
+	// tile 'n' is always processed by worker 'n'
+	std::vector<std::thread::id> owner[2];
+
+	for (int i = 0; i < 2; ++i)
+	{
+		owner[i].resize(num_of_threads);
+
+		THREAD_POOL.run(num_of_threads, [&](size_t n)
+		{	owner[i][n]=std::this_thread::get_id();});
+	}
+
+	EXPECT_TRUE(owner[0] == owner[1]);
+
+	// nested parallel_for runs serially on the worker
+	std::atomic<size_t> count(0);
+
+	parallel_for(TileRange(0, 8), [&](size_t)
+	{
+		parallel_for(TileRange(0, 10), [&](size_t)
+				{	++count;});
+	});
+
+	EXPECT_EQ(80, count);
+
+	// exceptions of tasks are re-thrown by the caller
+	EXPECT_THROW(THREAD_POOL.run(8, [](size_t n)
+	{
+		if(n==5) throw std::runtime_error("task 5");
+	}), std::runtime_error);
+
+	// pool is resized when the number of threads changes
+	GLOBAL_COMM.set_num_of_threads(2);
+
+	std::vector<int> v(100, 0);
+
+	parallel_for(TileRange(0, 100), [&](size_t s)
+	{	v[s]+=1;});
+
+	EXPECT_EQ(GLOBAL_COMM.get_num_of_threads(), THREAD_POOL.size());
+
+	for (auto i : v)
+	{
+		EXPECT_EQ(1, i);
+	}
+
+	GLOBAL_COMM.set_num_of_threads(1);
+}
+
+TEST(Parallel, parallel_for_colored)
+{
+	GLOBAL_COMM.set_num_of_threads(8);
+
+	size_t stencil_width = 4;
+
+	for (size_t num_of_cells : { 4, 16, 37, 64, 1000 })
+	{
+		std::mutex m;
+
+		std::vector<TileRange> slabs[2];
+
+		std::vector<int> count(num_of_cells, 0);
+
+		// more threads than num_of_cells/stencil_width
+		parallel_for_colored(TileRange(0, num_of_cells),
+				[&](TileRange const & r, size_t n)
+				{
+					for(auto s:r)
+					{
+						++count[s];
+					}
+
+					std::lock_guard<std::mutex> lock(m);
+					slabs[n%2].push_back(r);
+				}, 8, stencil_width);
+
+		for (auto c : count)
+		{
+			EXPECT_EQ(1, c);
+		}
+
+		EXPECT_LE(slabs[0].size() + slabs[1].size(), 16);
+
+		for (int color = 0; color < 2; ++color)
+		{
+			for (auto const & r : slabs[color])
+			{
+				if (slabs[0].size() + slabs[1].size() > 2)
+				{
+					EXPECT_GE(r.e - r.b, stencil_width);
+				}
+
+				// slabs that run concurrently are one slab apart
+				for (auto const & q : slabs[color])
+				{
+					if (q.b > r.b)
+					{
+						EXPECT_GE(q.b - r.e, stencil_width);
+					}
+				}
+			}
+		}
+	}
+
+	GLOBAL_COMM.set_num_of_threads(1);
+}
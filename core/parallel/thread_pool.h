@@ -0,0 +1,274 @@
+/**
+ * \file thread_pool.h
+ *
+ * \date    2014年11月19日  上午9:32:10
+ * \author salmon
+ */
+
+#ifndef THREAD_POOL_H_
+#define THREAD_POOL_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef USE_NUMA
+#include <numa.h>
+#endif
+
+#include "message_comm.h"
+#include "../utilities/perf_counter.h"
+#include "../utilities/singleton_holder.h"
+
+namespace simpla
+{
+/**
+ *  \ingroup MULTICORE
+ *  \brief NUMA node that owns  slab 'n' of 'num_of_slabs', slabs are spread
+ *         evenly over the configured nodes
+ */
+inline int numa_node_of_slab(size_t n, size_t num_of_slabs)
+{
+#ifdef USE_NUMA
+	if (numa_available() != -1 && num_of_slabs > 0)
+	{
+		return static_cast<int>((n * numa_num_configured_nodes()) / num_of_slabs);
+	}
+#endif
+	return 0;
+}
+
+/**
+ *  \ingroup MULTICORE
+ *  \brief bind current thread to the cpus of NUMA node 'node'
+ *  \return true if thread is bound
+ */
+inline bool bind_to_numa_node(int node)
+{
+#ifdef USE_NUMA
+	if (numa_available() != -1)
+	{
+		return numa_run_on_node(node) == 0;
+	}
+#endif
+	return false;
+}
+
+/**
+ *  \ingroup MULTICORE
+ *  \brief persistent worker threads of one rank
+ *
+ *   The pool has GLOBAL_COMM.get_num_of_threads() workers, started by the
+ *   first run() and restarted when that number changes. Worker 'n' of 'num'
+ *   is bound to NUMA node numa_node_of_slab(n,num) and runs the tasks
+ *   n, n+num, ... of every run(), so tile 'n' of every parallel_for over the
+ *   same range is processed by the same thread on the same node.
+ *
+ *   run() from a worker (nested parallel_for) runs its tasks serially.
+ *   Workers attach to the hardware performance counters when they are open,
+ *   see PerfCounter.
+ */
+class ThreadPool
+{
+public:
+
+	ThreadPool() :
+			task_(nullptr), num_of_tasks_(0), num_of_pending_(0), generation_(
+					0), stop_(false)
+	{
+	}
+
+	~ThreadPool()
+	{
+		resize(0);
+	}
+
+	ThreadPool(ThreadPool const &) = delete;
+
+	ThreadPool & operator=(ThreadPool const &) = delete;
+
+	size_t size() const
+	{
+		return workers_.size();
+	}
+
+	/// current thread is a worker of a pool
+	static bool is_worker()
+	{
+		return worker_flag_();
+	}
+
+	/**
+	 *  task(n) for n in [0,num_of_tasks), returns when all tasks are done.
+	 *  The first exception thrown by a task is re-thrown.
+	 */
+	void run(size_t num_of_tasks, std::function<void(size_t)> const & task)
+	{
+		size_t num_of_threads = GLOBAL_COMM.get_num_of_threads();
+
+		if (num_of_threads <= 1 || num_of_tasks <= 1 || is_worker())
+		{
+			for (size_t n = 0; n < num_of_tasks; ++n)
+			{
+				task(n);
+			}
+			return;
+		}
+
+		std::lock_guard<std::mutex> guard(run_lock_);
+
+		resize(num_of_threads);
+
+		std::exception_ptr error;
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+
+			task_ = &task;
+			num_of_tasks_ = num_of_tasks;
+			num_of_pending_ = workers_.size();
+			error_ = nullptr;
+			++generation_;
+
+			start_.notify_all();
+
+			done_.wait(lock, [this]()
+			{	return num_of_pending_==0;});
+
+			task_ = nullptr;
+
+			error = error_;
+		}
+
+		if (error)
+		{
+			std::rethrow_exception(error);
+		}
+	}
+
+private:
+
+	std::mutex run_lock_;
+
+	std::mutex mutex_;
+
+	std::condition_variable start_;
+
+	std::condition_variable done_;
+
+	std::vector<std::thread> workers_;
+
+	std::function<void(size_t)> const * task_;
+
+	size_t num_of_tasks_;
+
+	size_t num_of_pending_;
+
+	size_t generation_;
+
+	bool stop_;
+
+	std::exception_ptr error_;
+
+	static bool & worker_flag_()
+	{
+		static thread_local bool flag = false;
+		return flag;
+	}
+
+	void resize(size_t num)
+	{
+		if (num == workers_.size())
+		{
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			stop_ = true;
+		}
+
+		start_.notify_all();
+
+		for (auto & t : workers_)
+		{
+			t.join();
+		}
+
+		workers_.clear();
+
+		stop_ = false;
+
+		// create the singleton here, SingletonHolder::instance is not thread safe
+		PERF_COUNTER;
+
+		for (size_t n = 0; n < num; ++n)
+		{
+			workers_.emplace_back(&ThreadPool::work_, this, n, num, generation_);
+		}
+	}
+
+	void work_(size_t n, size_t num, size_t generation)
+	{
+		worker_flag_() = true;
+
+		bind_to_numa_node(numa_node_of_slab(n, num));
+
+		while (true)
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+
+			start_.wait(lock, [&]()
+			{	return stop_ || generation_ != generation;});
+
+			if (stop_)
+			{
+				return;
+			}
+
+			generation = generation_;
+
+			auto const & task = *task_;
+
+			size_t num_of_tasks = num_of_tasks_;
+
+			lock.unlock();
+
+			PERF_COUNTER.attach_thread();
+
+			std::exception_ptr error;
+
+			try
+			{
+				for (size_t i = n; i < num_of_tasks; i += num)
+				{
+					task(i);
+				}
+			} catch (...)
+			{
+				error = std::current_exception();
+			}
+
+			lock.lock();
+
+			if (error && !error_)
+			{
+				error_ = error;
+			}
+
+			if (--num_of_pending_ == 0)
+			{
+				done_.notify_one();
+			}
+		}
+	}
+};
+
+#define THREAD_POOL SingletonHolder<ThreadPool>::instance()
+
+}  // namespace simpla
+
+#endif /* THREAD_POOL_H_ */
@@ -0,0 +1,53 @@
+/**
+ * \file tile_range_test.h
+ *
+ * \date    2014年11月20日  下午2:10:36
+ * \author salmon
+ *
+ *  one dimensional range of cells [b,e), splittable as the mesh ranges, for
+ *  tests of parallel_for, parallel_for_colored and ContainerPool
+ */
+
+#ifndef TILE_RANGE_TEST_H_
+#define TILE_RANGE_TEST_H_
+
+#include <cstddef>
+#include <vector>
+
+namespace simpla
+{
+struct TileRange
+{
+	size_t b, e;
+
+	std::vector<size_t> cells;
+
+	TileRange(size_t pb, size_t pe) :
+			b(pb), e(pe)
+	{
+		for (size_t s = b; s < e; ++s)
+			cells.push_back(s);
+	}
+	std::vector<size_t>::const_iterator begin() const
+	{
+		return cells.begin();
+	}
+	std::vector<size_t>::const_iterator end() const
+	{
+		return cells.end();
+	}
+};
+
+inline TileRange split(TileRange const & r, size_t num, size_t n)
+{
+	return TileRange(r.b + ((r.e - r.b) * n) / num,
+			r.b + ((r.e - r.b) * (n + 1)) / num);
+}
+
+inline size_t split_extent(TileRange const & r)
+{
+	return r.e - r.b;
+}
+}  // namespace simpla
+
+#endif /* TILE_RANGE_TEST_H_ */
@@ -0,0 +1,282 @@
+/**
+ * \file boris_kernel.h
+ *
+ * \date    2014年11月10日  上午9:12:40
+ * \author salmon
+ */
+
+#ifndef BORIS_KERNEL_H_
+#define BORIS_KERNEL_H_
+
+#include <cstddef>
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+#include "../utilities/primitives.h"
+
+namespace simpla
+{
+
+/**
+ *  \ingroup ParticleEngine
+ *  \brief   W packed Reals, W=1 is the scalar fallback
+ */
+template<size_t W> struct simd_pack;
+
+template<> struct simd_pack<1>
+{
+	static constexpr size_t width = 1;
+
+	Real v;
+
+	static simd_pack load(Real const * p)
+	{
+		return simd_pack( { *p });
+	}
+	static simd_pack set1(Real a)
+	{
+		return simd_pack( { a });
+	}
+	void store(Real * p) const
+	{
+		*p = v;
+	}
+	friend simd_pack operator+(simd_pack l, simd_pack r)
+	{
+		return simd_pack( { l.v + r.v });
+	}
+	friend simd_pack operator-(simd_pack l, simd_pack r)
+	{
+		return simd_pack( { l.v - r.v });
+	}
+	friend simd_pack operator*(simd_pack l, simd_pack r)
+	{
+		return simd_pack( { l.v * r.v });
+	}
+	friend simd_pack operator/(simd_pack l, simd_pack r)
+	{
+		return simd_pack( { l.v / r.v });
+	}
+};
+
+#ifdef __AVX2__
+template<> struct simd_pack<4>
+{
+	static constexpr size_t width = 4;
+
+	__m256d v;
+
+	static simd_pack load(Real const * p)
+	{
+		return simd_pack( { _mm256_loadu_pd(p) });
+	}
+	static simd_pack set1(Real a)
+	{
+		return simd_pack( { _mm256_set1_pd(a) });
+	}
+	void store(Real * p) const
+	{
+		_mm256_storeu_pd(p, v);
+	}
+	friend simd_pack operator+(simd_pack l, simd_pack r)
+	{
+		return simd_pack( { _mm256_add_pd(l.v, r.v) });
+	}
+	friend simd_pack operator-(simd_pack l, simd_pack r)
+	{
+		return simd_pack( { _mm256_sub_pd(l.v, r.v) });
+	}
+	friend simd_pack operator*(simd_pack l, simd_pack r)
+	{
+		return simd_pack( { _mm256_mul_pd(l.v, r.v) });
+	}
+	friend simd_pack operator/(simd_pack l, simd_pack r)
+	{
+		return simd_pack( { _mm256_div_pd(l.v, r.v) });
+	}
+};
+#endif
+
+#ifdef __AVX512F__
+template<> struct simd_pack<8>
+{
+	static constexpr size_t width = 8;
+
+	__m512d v;
+
+	static simd_pack load(Real const * p)
+	{
+		return simd_pack( { _mm512_loadu_pd(p) });
+	}
+	static simd_pack set1(Real a)
+	{
+		return simd_pack( { _mm512_set1_pd(a) });
+	}
+	void store(Real * p) const
+	{
+		_mm512_storeu_pd(p, v);
+	}
+	friend simd_pack operator+(simd_pack l, simd_pack r)
+	{
+		return simd_pack( { _mm512_add_pd(l.v, r.v) });
+	}
+	friend simd_pack operator-(simd_pack l, simd_pack r)
+	{
+		return simd_pack( { _mm512_sub_pd(l.v, r.v) });
+	}
+	friend simd_pack operator*(simd_pack l, simd_pack r)
+	{
+		return simd_pack( { _mm512_mul_pd(l.v, r.v) });
+	}
+	friend simd_pack operator/(simd_pack l, simd_pack r)
+	{
+		return simd_pack( { _mm512_div_pd(l.v, r.v) });
+	}
+};
+#endif
+
+/// widest pack supported by the target instruction set
+#if defined(__AVX512F__)
+static constexpr size_t SIMD_WIDTH = 8;
+#elif defined(__AVX2__)
+static constexpr size_t SIMD_WIDTH = 4;
+#else
+static constexpr size_t SIMD_WIDTH = 1;
+#endif
+
+/**
+ *  \ingroup ParticleEngine
+ *  \brief  particles of a batch in SoA layout, input/output of boris_push
+ */
+template<size_t N>
+struct BorisBatch
+{
+	static constexpr size_t capacity = N;
+
+	Real Ex[N], Ey[N], Ez[N];
+	Real Bx[N], By[N], Bz[N];
+	Real vx[N], vy[N], vz[N];
+	Real w[N];
+};
+
+/**
+ *  \ingroup ParticleEngine
+ *  \brief  weight policy of full-f engine, weight is constant
+ */
+struct BorisWeightNone
+{
+	template<typename V>
+	static void update(Real, V const &, V const &, V const &, V const &,
+			V const &, V const &, Real *)
+	{
+	}
+};
+
+/**
+ *  \ingroup ParticleEngine
+ *  \brief  weight policy of \f$\delta f\f$ engine
+ *
+ *   \f$ a=-q\,E\cdot v\, dt/kT,\quad w=(-a+(1+a/2) w)/(1-a/2) \f$,
+ *   v is the velocity after the first half rotation
+ */
+struct BorisWeightDeltaF
+{
+	template<typename V>
+	static void update(Real q_kT_dt, V const & Ex, V const & Ey, V const & Ez,
+			V const & vx, V const & vy, V const & vz, Real * pw)
+	{
+		V a = (Ex * vx + Ey * vy + Ez * vz) * V::set1(-q_kT_dt);
+
+		V half = V::set1(0.5);
+
+		V one = V::set1(1.0);
+
+		V w = V::load(pw);
+
+		w = ((one + half * a) * w - a) / (one - half * a);
+
+		w.store(pw);
+	}
+};
+
+namespace _impl
+{
+template<typename V, typename TWeight, size_t N>
+inline void boris_push_pack(size_t i, Real cmr_dt, Real q_kT_dt,
+		BorisBatch<N> * b)
+{
+	V c = V::set1(cmr_dt);
+
+	V Ex = V::load(b->Ex + i), Ey = V::load(b->Ey + i), Ez = V::load(
+			b->Ez + i);
+
+	V tx = V::load(b->Bx + i) * c, ty = V::load(b->By + i) * c, tz = V::load(
+			b->Bz + i) * c;
+
+	// half acceleration
+	V vx = V::load(b->vx + i) + Ex * c;
+	V vy = V::load(b->vy + i) + Ey * c;
+	V vz = V::load(b->vz + i) + Ez * c;
+
+	// v_ = v + v x t
+	V ux = vx + (vy * tz - vz * ty);
+	V uy = vy + (vz * tx - vx * tz);
+	V uz = vz + (vx * ty - vy * tx);
+
+	// v_ = ( v_ x t ) /(t.t+1)
+	V inv = V::set1(1.0) / (tx * tx + ty * ty + tz * tz + V::set1(1.0));
+
+	V rx = (uy * tz - uz * ty) * inv;
+	V ry = (uz * tx - ux * tz) * inv;
+	V rz = (ux * ty - uy * tx) * inv;
+
+	vx = vx + rx;
+	vy = vy + ry;
+	vz = vz + rz;
+
+	TWeight::update(q_kT_dt, Ex, Ey, Ez, vx, vy, vz, b->w + i);
+
+	vx = vx + rx + Ex * c;
+	vy = vy + ry + Ey * c;
+	vz = vz + rz + Ez * c;
+
+	vx.store(b->vx + i);
+	vy.store(b->vy + i);
+	vz.store(b->vz + i);
+}
+}  // namespace _impl
+
+/**
+ *  \ingroup ParticleEngine
+ *  \brief  Boris velocity push of first 'num' particles in batch 'b'
+ *
+ *   Runs SIMD_WIDTH particles per iteration (AVX-512, AVX2 or scalar,
+ *   selected at compile time), the remainder uses the scalar pack.
+ *   TWeight is the weight policy of the engine (BorisWeightNone,
+ *   BorisWeightDeltaF), it is inlined into the kernel.
+ *
+ * @param cmr_dt  \f$ q/m\, dt/2\f$
+ * @param q_kT_dt \f$ q/kT\, dt\f$, used by TWeight
+ */
+template<typename TWeight, size_t N>
+void boris_push(size_t num, Real cmr_dt, Real q_kT_dt, BorisBatch<N> * b)
+{
+	size_t i = 0;
+
+	for (; i + SIMD_WIDTH <= num; i += SIMD_WIDTH)
+	{
+		_impl::boris_push_pack<simd_pack<SIMD_WIDTH>, TWeight>(i, cmr_dt,
+				q_kT_dt, b);
+	}
+
+	for (; i < num; ++i)
+	{
+		_impl::boris_push_pack<simd_pack<1>, TWeight>(i, cmr_dt, q_kT_dt, b);
+	}
+}
+
+}  // namespace simpla
+
+#endif /* BORIS_KERNEL_H_ */
@@ -0,0 +1,133 @@
+/**
+ * \file boris_kernel_test.cpp
+ *
+ * \date    2014年11月10日  上午10:02:31
+ * \author salmon
+ */
+
+#include <gtest/gtest.h>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+#include "boris_kernel.h"
+#include "../utilities/ntuple.h"
+#include "../utilities/primitives.h"
+
+using namespace simpla;
+
+static constexpr size_t NUM = 67; // not a multiple of SIMD_WIDTH
+
+template<typename TWeight>
+class TestBorisKernel: public testing::Test
+{
+protected:
+	virtual void SetUp()
+	{
+		std::mt19937 gen;
+		std::uniform_real_distribution<Real> uniform(-1.0, 1.0);
+
+		for (size_t i = 0; i < NUM; ++i)
+		{
+			b.Ex[i] = uniform(gen);
+			b.Ey[i] = uniform(gen);
+			b.Ez[i] = uniform(gen);
+			b.Bx[i] = uniform(gen);
+			b.By[i] = uniform(gen);
+			b.Bz[i] = uniform(gen);
+			b.vx[i] = uniform(gen);
+			b.vy[i] = uniform(gen);
+			b.vz[i] = uniform(gen);
+			b.w[i] = uniform(gen);
+		}
+	}
+public:
+	BorisBatch<NUM> b;
+
+	Real cmr_dt = 0.05, q_kT_dt = 0.2;
+
+	/// reference, same as per-particle next_timestep of the engines
+	void push_ref(size_t i, Vec3 * pv, Real * pw) const
+	{
+		Vec3 E = { b.Ex[i], b.Ey[i], b.Ez[i] };
+		Vec3 B = { b.Bx[i], b.By[i], b.Bz[i] };
+		Vec3 v = { b.vx[i], b.vy[i], b.vz[i] };
+		Real w = b.w[i];
+
+		Vec3 t = B * cmr_dt;
+
+		v += E * cmr_dt;
+
+		Vec3 v_ = v + cross(v, t);
+
+		v_ = cross(v_, t) / (dot(t, t) + 1.0);
+
+		v += v_;
+
+		if (std::is_same<TWeight, BorisWeightDeltaF>::value)
+		{
+			Real a = (-dot(E, v) * q_kT_dt);
+			w = (-a + (1 + 0.5 * a) * w) / (1 - 0.5 * a);
+		}
+
+		v += v_;
+
+		v += E * cmr_dt;
+
+		*pv = v;
+		*pw = w;
+	}
+};
+
+typedef testing::Types<BorisWeightNone, BorisWeightDeltaF> WeightTypes;
+
+TYPED_TEST_CASE(TestBorisKernel, WeightTypes);
+
+TYPED_TEST(TestBorisKernel, push){
+{
+	std::vector<Vec3> v(NUM);
+	std::vector<Real> w(NUM);
+
+	for (size_t i = 0; i < NUM; ++i)
+	{
+		this->push_ref(i, &v[i], &w[i]);
+	}
+
+	boris_push<TypeParam>(NUM, this->cmr_dt, this->q_kT_dt, &(this->b));
+
+	for (size_t i = 0; i < NUM; ++i)
+	{
+		EXPECT_NEAR(v[i][0], this->b.vx[i], 1.0e-14);
+		EXPECT_NEAR(v[i][1], this->b.vy[i], 1.0e-14);
+		EXPECT_NEAR(v[i][2], this->b.vz[i], 1.0e-14);
+		EXPECT_NEAR(w[i], this->b.w[i], 1.0e-14);
+	}
+}
+}
+
+TEST(BorisKernel, energy)
+{
+	// pure magnetic rotation conserves |v|
+	BorisBatch<NUM> b;
+
+	for (size_t i = 0; i < NUM; ++i)
+	{
+		b.Ex[i] = 0;
+		b.Ey[i] = 0;
+		b.Ez[i] = 0;
+		b.Bx[i] = 0.1 * i;
+		b.By[i] = 1.0;
+		b.Bz[i] = -0.5;
+		b.vx[i] = 1.0;
+		b.vy[i] = 2.0;
+		b.vz[i] = 3.0;
+		b.w[i] = 1.0;
+	}
+
+	boris_push<BorisWeightNone>(NUM, 0.1, 0, &b);
+
+	for (size_t i = 0; i < NUM; ++i)
+	{
+		EXPECT_NEAR(14.0, b.vx[i] * b.vx[i] + b.vy[i] * b.vy[i] + b.vz[i] * b.vz[i], 1.0e-12);
+	}
+}
@@ -9,17 +9,98 @@
 #define KINETIC_PARTICLE_H_
 
 #include <iostream>
+#include <list>
+#include <random>
 #include <string>
 #include <type_traits>
 #include "../utilities/ntuple.h"
 #include "../utilities/primitives.h"
 #include "../utilities/container_pool.h"
+#include "../parallel/message_comm.h"
+#include "../utilities/profiler.h"
+#include "../utilities/sp_type_traits.h"
+#include "../utilities/log.h"
+#include "../io/data_stream.h"
+#include "particle_constraint.h"
+#include "particle_engine.h"
 
 namespace simpla
 {
 
 template<typename ...> class Particle;
 
+namespace _impl
+{
+HAS_CONST_MEMBER_FUNCTION(next_timestep);
+
+/// Cartesian (x,v,f) of particle 'p'
+template<typename TEngine, typename TD, typename TP>
+auto pull_back(TD const & domain, TP const & p)
+DECL_RET_TYPE((engine_pull_back<TEngine>(domain.manifold(),p)))
+
+/// set position and velocity of particle 'p', other members  are kept
+template<typename TEngine, typename TD, typename TP, typename TX, typename TV>
+auto push_forward(TD const & domain, TX const & x, TV const & v, Real f, TP * p)
+->typename std::enable_if<has_member_s<TP>::value>::type
+{
+	auto q = engine_push_forward<TEngine>(domain.manifold(), x, v, f);
+
+	p->s = q.s;
+	p->x = q.x;
+	p->v = q.v;
+}
+
+template<typename TEngine, typename TD, typename TP, typename TX, typename TV>
+auto push_forward(TD const & domain, TX const & x, TV const & v, Real f, TP * p)
+->typename std::enable_if<!has_member_s<TP>::value>::type
+{
+	auto q = engine_push_forward<TEngine>(domain.manifold(), x, v, f);
+
+	p->x = q.x;
+	p->v = q.v;
+}
+
+/// particle stores its cell, i.e. PICDeltaFMixed
+template<typename TEngine, typename TD, typename TP>
+auto particle_cell_id(TD const &, TP const & p)
+->typename std::enable_if<has_member_s<TP>::value,typename TD::index_type>::type
+{
+	return p.s;
+}
+
+template<typename TEngine, typename TD, typename TP>
+auto particle_cell_id(TD const & domain, TP const & p)
+->typename std::enable_if<!has_member_s<TP>::value,typename TD::index_type>::type
+{
+	return std::get<0>(domain.manifold().coordinates_global_to_local(
+					std::get<0>(pull_back<TEngine>(domain,p)), 0UL));
+}
+
+HAS_MEMBER(mass);
+
+template<typename TEngine>
+auto particle_mass(TEngine const & engine)
+->typename std::enable_if<has_member_mass<TEngine>::value,Real>::type
+{
+	return engine.mass;
+}
+
+template<typename TEngine>
+auto particle_mass(TEngine const & engine)
+->typename std::enable_if<!has_member_mass<TEngine>::value,Real>::type
+{
+	return engine.get_mass();
+}
+
+/// engine has the per-cell push next_timestep(ib,ie,dt,args...)
+template<typename TEngine, typename TIterator, typename ...Args>
+struct has_cell_push
+{
+	static constexpr bool value = has_const_member_function_next_timestep<
+			TEngine, TIterator, TIterator, Real, Args...>::value;
+};
+}  // namespace _impl
+
 class PolicyKineticParticle;
 
 template<typename TDomain, typename Engine> using KineticParticle=Particle<TDomain, Engine, PolicyKineticParticle>;
@@ -32,20 +113,23 @@ struct Particle<TDomain, Engine, PolicyKineticParticle> : public Engine
 	typedef Engine engine_type;
 	typedef Particle<domain_type, engine_type, PolicyKineticParticle> this_type;
 
-	typedef typename domain_type::scalar_type scalar_type;
+	typedef typename domain_type::manifold_type::geometry_type::scalar_type scalar_type;
 
 	typedef typename engine_type::Point_s particle_type;
 
-	typedef typename domain_type::compact_index_type mid_type; // id of mesh point
+	typedef typename domain_type::index_type mid_type; // id of mesh point
 
 	typedef ContainerPool<mid_type, typename engine_type::Point_s> storage_type;
 
 	storage_type pic_;
 
-	std::function<compact_index_type(typename engine_type::Point_s const &)> hash_fun_;
+	std::function<mid_type(typename engine_type::Point_s const &)> hash_fun_;
 
 	domain_type const & domain_;
 
+	/// applied after every push, in order
+	std::list<std::function<void()>> constraints_;
+
 	template<typename ...Others>
 	Particle(domain_type const & pdomain, Others && ...); // Constructor
 
@@ -60,6 +144,11 @@ struct Particle<TDomain, Engine, PolicyKineticParticle> : public Engine
 	{
 		return domain_;
 	}
+
+	size_t get_num_of_particles() const
+	{
+		return pic_.size();
+	}
 	void load()
 	{
 	}
@@ -73,20 +162,47 @@ struct Particle<TDomain, Engine, PolicyKineticParticle> : public Engine
 
 	template<typename ...Args> void next_timestep(Real dt, Args && ...args);
 
+	template<typename ...Args> void push(Real dt, Args && ...args);
+
+	void add_constraint(std::function<void()> const & fun)
+	{
+		constraints_.push_back(fun);
+	}
+
+	void apply_constraints()
+	{
+		for (auto const & fun : constraints_)
+		{
+			fun();
+		}
+	}
+
+	template<typename TDict> void load_constraints(TDict const & dict);
+
+	template<typename TRange>
+	void constrain(TRange const & range, ParticleConstraint const & c);
+
+private:
+
+	template<typename ...Args>
+	void push_(std::integral_constant<bool, true>, Real dt, Args && ...args);
+
+	template<typename ...Args>
+	void push_(std::integral_constant<bool, false>, Real dt, Args && ...args);
 };
 
 template<typename TM, typename Engine>
 template<typename ... Others>
 Particle<TM, Engine, PolicyKineticParticle>::Particle(
 		domain_type const & pdomain, Others && ...others) :
-		domain_(pdomain)
+		pic_([this](particle_type const & p)->mid_type
+		{	return hash_fun_(p);}), domain_(pdomain)
 {
-	load(std::forward<Others>(others)...);
 	hash_fun_ = [& ](particle_type const & p)->mid_type
 	{
-		return std::get<0>(domain_.coordinates_global_to_local(
-						std::get<0>(engine_type::pull_back(p))));
+		return _impl::particle_cell_id<engine_type>(domain_,p);
 	};
+	load(std::forward<Others>(others)...);
 }
 
 template<typename TM, typename Engine>
@@ -100,8 +216,93 @@ void Particle<TM, Engine, PolicyKineticParticle>::load(TDict const & dict,
 {
 	engine_type::load(dict, std::forward<Others>(others)...);
 
-	pic_.load(dict, std::forward<Others>(others)...);
+	load_constraints(dict["Constraints"]);
+}
+
+/**
+ *  native constraints (ParticleConstraint) of 'dict', i.e.
+ *  \code
+ *   Constraints={ { Type="Reflect", Point={0,0,0}, Normal={0,0,1} },
+ *                 { Type="Absorb", Min={0,0,0}, Max={1,1,1} } }
+ *  \endcode
+ *  The region of a constraint is its box [Min,Max] in the domain, the Lua
+ *  callbacks ("Modify","Remove") of Particle are not supported.
+ */
+template<typename TM, typename Engine>
+template<typename TDict>
+void Particle<TM, Engine, PolicyKineticParticle>::load_constraints(
+		TDict const & dict)
+{
+	if (!dict)
+	{
+		return;
+	}
+
+	for (auto const & key_item : dict)
+	{
+		auto const & item = std::get<1>(key_item);
+
+		ParticleConstraint c;
+
+		if (c.load(item, _impl::particle_mass(*this)))
+		{
+			add_constraint([=]()
+			{	this->constrain(domain_, c);});
+		}
+		else
+		{
+			WARNING << "Constraint [" << item["Type"].template as<std::string>("")
+					<< "] is not supported by " << get_type_as_string();
+		}
+	}
+}
+
+/**
+ *  apply native constraint 'c' to particles in 'range', particles which
+ *  leave their cell are moved as in push. Cell 's' of sweep 'n' uses the
+ *  random stream (seed,n,s), the result does not depend on the number of
+ *  threads.
+ */
+template<typename TM, typename Engine>
+template<typename TRange>
+void Particle<TM, Engine, PolicyKineticParticle>::constrain(
+		TRange const & range, ParticleConstraint const & c)
+{
+	if (c.is_removal())
+	{
+		pic_.remove_if(range, [&](particle_type const & p)
+		{
+			auto z=_impl::pull_back<engine_type>(domain_,p);
+
+			return c.absorb(std::get<0>(z),std::get<1>(z));
+		});
+
+		return;
+	}
+
+	size_t sweep = c.num_of_sweeps++;
+
+	typedef typename storage_type::inner_container::iterator iterator;
 
+	pic_.modify_cells_and_migrate(range,
+			[&](mid_type const & s, iterator ib, iterator ie)
+	{
+		std::seed_seq seq(
+		{	c.seed, sweep, static_cast<size_t>(s)});
+
+		ParticleConstraint::random_engine_type gen(seq);
+
+		for (; ib != ie; ++ib)
+		{
+			auto z=_impl::pull_back<engine_type>(domain_,*ib);
+
+			if(c(&std::get<0>(z),&std::get<1>(z),&gen))
+			{
+				_impl::push_forward<engine_type>(domain_,
+						std::get<0>(z),std::get<1>(z),std::get<2>(z),&(*ib));
+			}
+		}
+	}, GLOBAL_COMM.get_num_of_threads(), 1);
 }
 template<typename TM, typename Engine>
 std::string Particle<TM, Engine, PolicyKineticParticle>::save(
@@ -137,16 +338,63 @@ void Particle<TM, Engine, PolicyKineticParticle>::next_timestep(Real dt,
 	LOGGER << "Push particles to  next step [ "
 			<< engine_type::get_type_as_string() << " ]";
 
-	pic_.sort(hash_fun_);
+	{
+		PROFILE_SCOPE("push");
 
-	pic_.modify(domain_, [&](particle_type & p)
+		push(dt, args...);
+	}
 	{
-		this->engine_type::next_timestep(&p,dt, std::forward<Args>(args)...);
-	});
+		PROFILE_SCOPE("constraints");
 
-	pic_.sort(hash_fun_);
+		apply_constraints();
+	}
+	{
+		PROFILE_SCOPE("ghosts");
+
+		update_ghost(std::forward<Args>(args)...);
+	}
+}
+
+/**
+ *  push and move particles that leave their cell in one sweep, particles
+ *  are kept binned by  insert/modify_and_migrate, no re-sort is needed.
+ *  Cells go to the per-cell push of the engine if it has one, else
+ *  particles are pushed one by one.
+ */
+template<typename TM, typename Engine>
+template<typename ...Args>
+void Particle<TM, Engine, PolicyKineticParticle>::push(Real dt,
+		Args && ...args)
+{
+	push_(std::integral_constant<bool,
+			_impl::has_cell_push<engine_type,
+					typename storage_type::inner_container::iterator, Args...>::value>(),
+			dt, std::forward<Args>(args)...);
+}
 
-	update_ghost(std::forward<Args>(args)...);
+template<typename TM, typename Engine>
+template<typename ...Args>
+void Particle<TM, Engine, PolicyKineticParticle>::push_(
+		std::integral_constant<bool, true>, Real dt, Args && ...args)
+{
+	typedef typename storage_type::inner_container::iterator iterator;
+
+	pic_.modify_cells_and_migrate(domain_,
+			[&](mid_type const &, iterator ib, iterator ie)
+	{
+		this->engine_type::next_timestep(ib,ie,dt, args...);
+	}, GLOBAL_COMM.get_num_of_threads());
+}
+
+template<typename TM, typename Engine>
+template<typename ...Args>
+void Particle<TM, Engine, PolicyKineticParticle>::push_(
+		std::integral_constant<bool, false>, Real dt, Args && ...args)
+{
+	pic_.modify_and_migrate(domain_, [&](particle_type * p)
+	{
+		this->engine_type::next_timestep(p,dt, args...);
+	}, GLOBAL_COMM.get_num_of_threads());
 }
 
 }  // namespace simpla
@@ -0,0 +1,761 @@
+/**
+ * \file kinetic_particle_test.cpp
+ *
+ * \date    2014年11月21日  上午9:30:12
+ * \author salmon
+ */
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../utilities/ntuple.h"
+#include "../utilities/primitives.h"
+#include "../field/field.h"
+#include "../manifold/manifold.h"
+#include "../manifold/domain.h"
+#include "../manifold/geometry/cartesian.h"
+#include "../manifold/topology/structured.h"
+#include "../manifold/diff_scheme/fdm.h"
+#include "../manifold/interpolator/interpolator.h"
+#include "../../applications/particle_solver/pic_engine_deltaf.h"
+#include "../../applications/particle_solver/pic_engine_fullf.h"
+#include "../../applications/particle_solver/pic_engine_deltaf_mixed.h"
+#include "kinetic_particle.h"
+#include "load_particle.h"
+
+using namespace simpla;
+
+typedef Manifold<CartesianCoordinates<StructuredMesh, CARTESIAN_ZAXIS>,
+		FiniteDiffMethod, InterpolatorLinear> mesh_type;
+
+typedef Domain<mesh_type, VERTEX> domain_type;
+
+typedef KineticParticle<domain_type, PICDeltaF> particle_type;
+
+typedef typename PICDeltaF::Point_s point_type;
+
+/**
+ *  stand-in of LuaObject: a table of named items, a list of items, a string
+ *  or numbers
+ */
+struct TestDict
+{
+	std::string str;
+
+	std::vector<Real> num;
+
+	std::map<std::string, TestDict> table;
+
+	std::vector<std::pair<size_t, TestDict>> list;
+
+	TestDict()
+	{
+	}
+	TestDict(std::string const & s) :
+			str(s)
+	{
+	}
+	TestDict(std::initializer_list<Real> const & v) :
+			num(v)
+	{
+	}
+
+	explicit operator bool() const
+	{
+		return !str.empty() || !num.empty() || !table.empty() || !list.empty();
+	}
+
+	TestDict const & operator[](std::string const & key) const
+	{
+		static const TestDict empty_;
+
+		auto it = table.find(key);
+
+		return it == table.end() ? empty_ : it->second;
+	}
+
+	std::vector<std::pair<size_t, TestDict>>::const_iterator begin() const
+	{
+		return list.begin();
+	}
+	std::vector<std::pair<size_t, TestDict>>::const_iterator end() const
+	{
+		return list.end();
+	}
+
+	template<typename T> T as() const
+	{
+		T res;
+		cast_(&res);
+		return res;
+	}
+	template<typename T> T as(T const & def) const
+	{
+		return (*this) ? as<T>() : def;
+	}
+
+private:
+	void cast_(std::string * v) const
+	{
+		*v = str;
+	}
+	void cast_(Real * v) const
+	{
+		*v = num[0];
+	}
+	void cast_(size_t * v) const
+	{
+		*v = static_cast<size_t>(num[0]);
+	}
+	void cast_(bool * v) const
+	{
+		*v = num[0] != 0;
+	}
+	void cast_(nTuple<Real, 3> * v) const
+	{
+		for (int i = 0; i < 3; ++i)
+			(*v)[i] = num[i];
+	}
+};
+
+/**
+ *  KineticParticle pushes cells by the per-cell push of PICDeltaF, it must
+ *  give the same particles and J as the per-particle push.
+ */
+TEST(KineticParticle, cell_push)
+{
+	mesh_type mesh;
+
+	nTuple<size_t, 3> dims = { 16, 16, 16 };
+	nTuple<Real, 3> xmin = { 0, 0, 0 };
+	nTuple<Real, 3> xmax = { 1, 1, 1 };
+	nTuple<Real, 3> k = { TWOPI, TWOPI, TWOPI };
+
+	mesh.dimensions(dims);
+	mesh.extents(xmin, xmax);
+	mesh.update();
+
+	auto E = make_field<Real>(make_domain<EDGE>(mesh));
+	auto B = make_field<Real>(make_domain<FACE>(mesh));
+	auto J0 = make_field<Real>(make_domain<EDGE>(mesh));
+	auto J1 = make_field<Real>(make_domain<EDGE>(mesh));
+
+	E.clear();
+	B.clear();
+	J0.clear();
+	J1.clear();
+
+	for (auto s : E.domain())
+	{
+		E[s] = std::sin(inner_product(k, mesh.coordinates(s)));
+	}
+	for (auto s : B.domain())
+	{
+		B[s] = 1.0 + 0.1 * std::cos(inner_product(k, mesh.coordinates(s)));
+	}
+
+	domain_type domain(mesh);
+
+	particle_type ion(domain);
+
+	ion.mass = 1.0;
+	ion.charge = 1.0;
+	ion.temperature = 1.0;
+	ion.update();
+
+	static_assert(_impl::has_cell_push<PICDeltaF,
+					typename particle_type::storage_type::inner_container::iterator,
+					decltype(&J1), decltype(E) &, decltype(B) &>::value,
+			"PICDeltaF has the per-cell push");
+
+	// particles in the inner half of the box, f is the id of the particle,
+	// one push moves a particle 0.3 cell on average, some leave their cell
+	Real dt = 0.3 / dims[0];
+
+	std::mt19937 gen;
+
+	std::uniform_real_distribution<Real> uniform(0.25, 0.75);
+
+	std::normal_distribution<Real> normal(0, 1);
+
+	std::vector<point_type> particles(2000);
+
+	for (size_t n = 0; n < particles.size(); ++n)
+	{
+		auto & p = particles[n];
+
+		p.x = nTuple<Real, 3>( { uniform(gen), uniform(gen), uniform(gen) });
+		p.v = nTuple<Real, 3>( { normal(gen), normal(gen), normal(gen) });
+		p.f = 1.0 + n;
+		p.w = 0.1 * normal(gen);
+
+		ion.pic_.insert(p);
+	}
+
+	for (auto & p : particles)
+	{
+		ion.engine_type::next_timestep(&p, dt, &J0, E, B);
+	}
+
+	ion.push(dt, &J1, E, B);
+
+	std::vector<point_type> pushed;
+
+	for (auto const & item : ion.pic_)
+	{
+		for (auto const & p : item.second)
+		{
+			// binned by cell
+			EXPECT_EQ(item.first,
+					std::get<0>(mesh.coordinates_global_to_local(p.x, 0UL)));
+
+			pushed.push_back(p);
+		}
+	}
+
+	ASSERT_EQ(particles.size(), pushed.size());
+
+	std::sort(pushed.begin(), pushed.end(),
+			[](point_type const & l, point_type const & r)
+			{	return l.f<r.f;});
+
+	for (size_t n = 0; n < particles.size(); ++n)
+	{
+		auto const & p0 = particles[n];
+		auto const & p1 = pushed[n];
+
+		ASSERT_EQ(p0.f, p1.f);
+
+		for (int i = 0; i < 3; ++i)
+		{
+			EXPECT_NEAR(p0.x[i], p1.x[i], 1.0e-12);
+			EXPECT_NEAR(p0.v[i], p1.v[i], 1.0e-12);
+		}
+		EXPECT_NEAR(p0.w, p1.w, 1.0e-12);
+	}
+
+	Real J_max = 0;
+
+	for (auto s : J0.domain())
+	{
+		J_max = std::max(J_max, std::abs(J0[s]));
+	}
+
+	EXPECT_GT(J_max, 0);
+
+	for (auto s : J0.domain())
+	{
+		EXPECT_NEAR(J0[s], J1[s], 1.0e-10 * J_max);
+	}
+}
+
+/**
+ *  PICEngineFullF has the per-cell boris_push too, without J
+ */
+TEST(KineticParticle, cell_push_full_f)
+{
+	typedef KineticParticle<domain_type, PICEngineFullF> full_f_type;
+
+	typedef typename PICEngineFullF::Point_s full_f_point;
+
+	mesh_type mesh;
+
+	nTuple<size_t, 3> dims = { 16, 16, 16 };
+	nTuple<Real, 3> xmin = { 0, 0, 0 };
+	nTuple<Real, 3> xmax = { 1, 1, 1 };
+	nTuple<Real, 3> k = { TWOPI, TWOPI, TWOPI };
+
+	mesh.dimensions(dims);
+	mesh.extents(xmin, xmax);
+	mesh.update();
+
+	auto E = make_field<Real>(make_domain<EDGE>(mesh));
+	auto B = make_field<Real>(make_domain<FACE>(mesh));
+
+	E.clear();
+	B.clear();
+
+	for (auto s : E.domain())
+	{
+		E[s] = std::sin(inner_product(k, mesh.coordinates(s)));
+	}
+	for (auto s : B.domain())
+	{
+		B[s] = 1.0 + 0.1 * std::cos(inner_product(k, mesh.coordinates(s)));
+	}
+
+	domain_type domain(mesh);
+
+	full_f_type electron(domain);
+
+	static_assert(_impl::has_cell_push<PICEngineFullF,
+					typename full_f_type::storage_type::inner_container::iterator,
+					decltype(E) &, decltype(B) &>::value,
+			"PICEngineFullF has the per-cell push");
+
+	Real dt = 0.3 / dims[0];
+
+	std::mt19937 gen;
+
+	std::uniform_real_distribution<Real> uniform(0.25, 0.75);
+
+	std::normal_distribution<Real> normal(0, 1);
+
+	std::vector<full_f_point> particles(2000);
+
+	for (size_t n = 0; n < particles.size(); ++n)
+	{
+		auto & p = particles[n];
+
+		p.x = nTuple<Real, 3>( { uniform(gen), uniform(gen), uniform(gen) });
+		p.v = nTuple<Real, 3>( { normal(gen), normal(gen), normal(gen) });
+		p.f = 1.0 + n;
+
+		electron.pic_.insert(p);
+	}
+
+	for (auto & p : particles)
+	{
+		electron.engine_type::next_timestep(&p, dt, E, B);
+	}
+
+	electron.push(dt, E, B);
+
+	std::vector<full_f_point> pushed;
+
+	for (auto const & item : electron.pic_)
+	{
+		pushed.insert(pushed.end(), item.second.begin(), item.second.end());
+	}
+
+	ASSERT_EQ(particles.size(), pushed.size());
+
+	std::sort(pushed.begin(), pushed.end(),
+			[](full_f_point const & l, full_f_point const & r)
+			{	return l.f<r.f;});
+
+	for (size_t n = 0; n < particles.size(); ++n)
+	{
+		ASSERT_EQ(particles[n].f, pushed[n].f);
+
+		for (int i = 0; i < 3; ++i)
+		{
+			EXPECT_NEAR(particles[n].x[i], pushed[n].x[i], 1.0e-12);
+			EXPECT_NEAR(particles[n].v[i], pushed[n].v[i], 1.0e-12);
+		}
+	}
+}
+
+/**
+ *  constraints of load() are applied by apply_constraints(), which
+ *  next_timestep() calls after the push
+ */
+TEST(KineticParticle, load_constraints)
+{
+	mesh_type mesh;
+
+	nTuple<size_t, 3> dims = { 16, 16, 16 };
+	nTuple<Real, 3> xmin = { 0, 0, 0 };
+	nTuple<Real, 3> xmax = { 1, 1, 1 };
+
+	mesh.dimensions(dims);
+	mesh.extents(xmin, xmax);
+	mesh.update();
+
+	TestDict reflect;
+	reflect.table["Type"] = TestDict("Reflect");
+	reflect.table["Point"] = TestDict( { 0, 0, 0.5 });
+	reflect.table["Normal"] = TestDict( { 0, 0, 1 });
+
+	TestDict absorb;
+	absorb.table["Type"] = TestDict("Absorb");
+	absorb.table["Min"] = TestDict( { 0, 0, 0 });
+	absorb.table["Max"] = TestDict( { 0.5, 1, 1 });
+
+	TestDict modify;
+	modify.table["Type"] = TestDict("Modify");
+
+	TestDict dict;
+	dict.table["mass"] = TestDict( { 2.0 });
+	dict.table["Constraints"].list.push_back(std::make_pair(1, reflect));
+	dict.table["Constraints"].list.push_back(std::make_pair(2, absorb));
+	dict.table["Constraints"].list.push_back(std::make_pair(3, modify));
+
+	domain_type domain(mesh);
+
+	particle_type ion(domain, dict);
+
+	EXPECT_DOUBLE_EQ(2.0, ion.mass);
+
+	// Lua callback "Modify" is not supported
+	EXPECT_EQ(2, ion.constraints_.size());
+
+	std::mt19937 gen;
+
+	std::uniform_real_distribution<Real> uniform(0.1, 0.9);
+
+	std::normal_distribution<Real> normal(0, 1);
+
+	size_t num = 2000;
+
+	for (size_t n = 0; n < num; ++n)
+	{
+		point_type p;
+
+		p.x = nTuple<Real, 3>( { uniform(gen), uniform(gen), uniform(gen) });
+		p.v = nTuple<Real, 3>( { normal(gen), normal(gen), normal(gen) });
+		p.f = 1.0 + n;
+		p.w = p.x[2];
+
+		ion.pic_.insert(p);
+	}
+
+	ion.apply_constraints();
+
+	size_t count = 0;
+
+	for (auto const & item : ion.pic_)
+	{
+		for (auto const & p : item.second)
+		{
+			// binned by cell
+			EXPECT_EQ(item.first,
+					std::get<0>(mesh.coordinates_global_to_local(p.x, 0UL)));
+
+			// reflected at z=0.5
+			EXPECT_GE(p.x[2], 0.5);
+
+			// absorbed outside x<0.5
+			EXPECT_LT(p.x[0], 0.5);
+
+			// w is kept, z is mirrored
+			EXPECT_NEAR(std::abs(p.w - 0.5), p.x[2] - 0.5, 1.0e-12);
+
+			++count;
+		}
+	}
+
+	EXPECT_GT(count, num / 3);
+	EXPECT_LT(count, num * 2 / 3);
+}
+
+/**
+ *  Thermalize/Reinject sweep cells that Absorb and migration left empty,
+ *  cell 's' draws from the stream (seed,sweep,s), so the particles do not
+ *  depend on the number of threads
+ */
+TEST(KineticParticle, constraints_after_absorb)
+{
+	mesh_type mesh;
+
+	nTuple<size_t, 3> dims = { 16, 16, 16 };
+	nTuple<Real, 3> xmin = { 0, 0, 0 };
+	nTuple<Real, 3> xmax = { 1, 1, 1 };
+
+	mesh.dimensions(dims);
+	mesh.extents(xmin, xmax);
+	mesh.update();
+
+	TestDict absorb;
+	absorb.table["Type"] = TestDict("Absorb");
+	absorb.table["Min"] = TestDict( { 0, 0, 0 });
+	absorb.table["Max"] = TestDict( { 0.5, 1, 1 });
+
+	TestDict thermalize;
+	thermalize.table["Type"] = TestDict("Thermalize");
+	thermalize.table["Temperature"] = TestDict( { 1.0 });
+
+	TestDict reinject;
+	reinject.table["Type"] = TestDict("Reinject");
+	reinject.table["Min"] = TestDict( { 0.25, 0, 0 });
+	reinject.table["Max"] = TestDict( { 0.75, 1, 1 });
+	reinject.table["Temperature"] = TestDict( { 1.0 });
+
+	TestDict dict;
+	dict.table["mass"] = TestDict( { 1.0 });
+	dict.table["Constraints"].list.push_back(std::make_pair(1, absorb));
+	dict.table["Constraints"].list.push_back(std::make_pair(2, thermalize));
+	dict.table["Constraints"].list.push_back(std::make_pair(3, reinject));
+
+	domain_type domain(mesh);
+
+	auto run = [&](size_t num_of_threads)
+	{
+		GLOBAL_COMM.set_num_of_threads(num_of_threads);
+
+		particle_type ion(domain, dict);
+
+		EXPECT_EQ(3, ion.constraints_.size());
+
+		std::mt19937 gen;
+
+		std::uniform_real_distribution<Real> uniform(0, 1);
+
+		for (size_t n = 0; n < 2000; ++n)
+		{
+			point_type p;
+
+			p.x = nTuple<Real, 3>(
+					{	uniform(gen), uniform(gen), uniform(gen)});
+			p.v = nTuple<Real, 3>(
+					{	0, 0, 0});
+			p.f = 1.0 + n;
+			p.w = 0;
+
+			ion.pic_.insert(p);
+		}
+
+		// the second round sweeps cells emptied by the first one
+		ion.apply_constraints();
+		ion.apply_constraints();
+
+		std::vector<point_type> res;
+
+		for (auto const & item : ion.pic_)
+		{
+			for (auto const & p : item.second)
+			{
+				EXPECT_EQ(item.first,
+						std::get<0>(mesh.coordinates_global_to_local(p.x, 0UL)));
+
+				res.push_back(p);
+			}
+		}
+
+		std::sort(res.begin(), res.end(),
+				[](point_type const & l, point_type const & r)
+				{	return l.f<r.f;});
+
+		return res;
+	};
+
+	auto res1 = run(1);
+	auto res4 = run(4);
+
+	GLOBAL_COMM.set_num_of_threads(1);
+
+	// absorbed x>=0.5 twice, reinjected x<0.25
+	EXPECT_GT(res1.size(), 500);
+	EXPECT_LT(res1.size(), 1500);
+
+	ASSERT_EQ(res1.size(), res4.size());
+
+	for (size_t n = 0; n < res1.size(); ++n)
+	{
+		EXPECT_GE(res1[n].x[0], 0.25);
+		EXPECT_LT(res1[n].x[0], 0.5);
+
+		// thermalized
+		EXPECT_NE(0, res1[n].v[0]);
+
+		ASSERT_EQ(res1[n].f, res4[n].f);
+
+		for (int i = 0; i < 3; ++i)
+		{
+			EXPECT_EQ(res1[n].x[i], res4[n].x[i]);
+			EXPECT_EQ(res1[n].v[i], res4[n].v[i]);
+		}
+	}
+}
+
+/**
+ *  stand-in of Particle<Engine,TDomain> for init_particle
+ */
+template<typename TEngine>
+struct TestParticleVector: public TEngine, public std::vector<
+		typename TEngine::Point_s>
+{
+	typedef TEngine engine_type;
+};
+
+/**
+ *  PICDeltaFMixed particles are created through the mesh-taking
+ *  push_forward, pull_back inverts it to float precision, and the push
+ *  agrees with PICDeltaF to float precision
+ */
+TEST(KineticParticle, delta_f_mixed)
+{
+	typedef KineticParticle<domain_type, PICDeltaFMixed> mixed_type;
+
+	typedef typename PICDeltaFMixed::Point_s mixed_point;
+
+	mesh_type mesh;
+
+	nTuple<size_t, 3> dims = { 16, 16, 16 };
+	nTuple<Real, 3> xmin = { 0, 0, 0 };
+	nTuple<Real, 3> xmax = { 1, 1, 1 };
+	nTuple<Real, 3> k = { TWOPI, TWOPI, TWOPI };
+
+	mesh.dimensions(dims);
+	mesh.extents(xmin, xmax);
+	mesh.update();
+
+	domain_type domain(mesh);
+
+	// loader
+	TestParticleVector<PICDeltaFMixed> loaded;
+
+	init_particle(domain, 2, [](nTuple<Real,3> const &)
+	{	return 2.0;}, [](nTuple<Real,3> const &)
+	{	return 1.0;}, &loaded);
+
+	size_t num_of_cells = 0;
+
+	for (auto s : domain)
+	{
+		++num_of_cells;
+	}
+
+	EXPECT_EQ(2 * num_of_cells, loaded.size());
+
+	for (auto const & p : loaded)
+	{
+		auto z = engine_pull_back<PICDeltaFMixed>(mesh, p);
+
+		EXPECT_EQ(p.s, std::get<0>(mesh.coordinates_global_to_local(std::get<0>(z), 0UL)));
+		EXPECT_FLOAT_EQ(1.0, std::get<2>(z));
+	}
+
+	// round trip
+	std::mt19937 gen;
+
+	std::uniform_real_distribution<Real> uniform(0.25, 0.75);
+
+	std::normal_distribution<Real> normal(0, 1);
+
+	for (int n = 0; n < 1000; ++n)
+	{
+		nTuple<Real, 3> x = { uniform(gen), uniform(gen), uniform(gen) };
+		nTuple<Real, 3> v = { normal(gen), normal(gen), normal(gen) };
+
+		auto p = engine_push_forward<PICDeltaFMixed>(mesh, x, v, 0.5);
+
+		EXPECT_EQ(std::get<0>(mesh.coordinates_global_to_local(x, 0UL)), p.s);
+
+		auto z = engine_pull_back<PICDeltaFMixed>(mesh, p);
+
+		for (int i = 0; i < 3; ++i)
+		{
+			EXPECT_NEAR(x[i], std::get<0>(z)[i], 1.0e-7);
+			EXPECT_NEAR(v[i], std::get<1>(z)[i], 1.0e-6 * std::abs(v[i]));
+		}
+		EXPECT_EQ(0.5, std::get<2>(z));
+	}
+
+	// push
+	auto E = make_field<Real>(make_domain<EDGE>(mesh));
+	auto B = make_field<Real>(make_domain<FACE>(mesh));
+	auto J0 = make_field<Real>(make_domain<EDGE>(mesh));
+	auto J1 = make_field<Real>(make_domain<EDGE>(mesh));
+
+	E.clear();
+	B.clear();
+	J0.clear();
+	J1.clear();
+
+	for (auto s : E.domain())
+	{
+		E[s] = std::sin(inner_product(k, mesh.coordinates(s)));
+	}
+	for (auto s : B.domain())
+	{
+		B[s] = 1.0 + 0.1 * std::cos(inner_product(k, mesh.coordinates(s)));
+	}
+
+	particle_type ion(domain);
+
+	mixed_type mixed(domain);
+
+	Real dt = 0.3 / dims[0];
+
+	size_t num = 2000;
+
+	for (size_t n = 0; n < num; ++n)
+	{
+		nTuple<Real, 3> x = { uniform(gen), uniform(gen), uniform(gen) };
+		nTuple<Real, 3> v = { normal(gen), normal(gen), normal(gen) };
+
+		auto q = engine_push_forward<PICDeltaFMixed>(mesh, x, v, 1.0 + n);
+
+		q.w = static_cast<float>(0.1 * normal(gen));
+
+		mixed.pic_.insert(q);
+
+		// the same particle in double
+		auto z = engine_pull_back<PICDeltaFMixed>(mesh, q);
+
+		auto p = engine_push_forward<PICDeltaF>(mesh, std::get<0>(z),
+				std::get<1>(z), std::get<2>(z));
+
+		p.w = q.w;
+
+		ion.pic_.insert(p);
+	}
+
+	ion.push(dt, &J0, E, B);
+
+	mixed.push(dt, &J1, E, B);
+
+	std::vector<point_type> p0;
+	std::vector<mixed_point> p1;
+
+	for (auto const & item : ion.pic_)
+	{
+		p0.insert(p0.end(), item.second.begin(), item.second.end());
+	}
+
+	for (auto const & item : mixed.pic_)
+	{
+		for (auto const & p : item.second)
+		{
+			// binned by the stored cell
+			EXPECT_EQ(item.first, p.s);
+
+			p1.push_back(p);
+		}
+	}
+
+	ASSERT_EQ(num, p0.size());
+	ASSERT_EQ(num, p1.size());
+
+	std::sort(p0.begin(), p0.end(), [](point_type const & l, point_type const & r)
+	{	return l.f<r.f;});
+
+	std::sort(p1.begin(), p1.end(), [](mixed_point const & l, mixed_point const & r)
+	{	return l.f<r.f;});
+
+	for (size_t n = 0; n < num; ++n)
+	{
+		auto z = engine_pull_back<PICDeltaFMixed>(mesh, p1[n]);
+
+		ASSERT_EQ(p0[n].f, std::get<2>(z));
+
+		for (int i = 0; i < 3; ++i)
+		{
+			EXPECT_NEAR(p0[n].x[i], std::get<0>(z)[i], 1.0e-6);
+			EXPECT_NEAR(p0[n].v[i], std::get<1>(z)[i],
+					1.0e-6 * (1.0 + std::abs(p0[n].v[i])));
+		}
+		EXPECT_NEAR(p0[n].w, p1[n].w, 1.0e-6);
+	}
+
+	Real J_max = 0;
+
+	for (auto s : J0.domain())
+	{
+		J_max = std::max(J_max, std::abs(J0[s]));
+	}
+
+	EXPECT_GT(J_max, 0);
+
+	for (auto s : J0.domain())
+	{
+		EXPECT_NEAR(J0[s], J1[s], 1.0e-5 * J_max);
+	}
+}
@@ -21,6 +21,8 @@
 #include "../physics/physical_constants.h"
 
 #include "../particle/particle_base.h"
+#include "../particle/particle_constraint.h"
+#include "../particle/particle_engine.h"
 
 #include "../utilities/log.h"
 #include "../utilities/utilities.h"
@@ -105,6 +107,10 @@ std::shared_ptr<TP> load_particle(TDict const &dict, TModel const & model,
 
 }
 
+/**
+ *  'p' has add_constraint(fun) and constrain(range,ParticleConstraint), i.e.
+ *  KineticParticle, which loads native constraints of its own dict in load()
+ */
 template<typename TP, typename TRange, typename TModel, typename TDict>
 void load_particle_constriant(TP *p, TRange const &range, TModel const & model,
 		TDict const & dict)
@@ -120,7 +126,14 @@ void load_particle_constriant(TP *p, TRange const &range, TModel const & model,
 
 		auto type = item["Type"].template as<std::string>("Modify");
 
-		if (type == "Modify")
+		ParticleConstraint c;
+
+		if (c.load(item, p->get_mass()))
+		{
+			p->add_constraint([=]()
+			{	p->constrain(r, c);});
+		}
+		else if (type == "Modify")
 		{
 			p->add_constraint([=]()
 			{	p->modify(r, item["Operations"]);});
@@ -184,11 +197,13 @@ void init_particle(TR const &domain, size_t pic, TN const & ns, TT const & Ts,
 
 			v_dist(rnd_gen, &v[0]);
 
-			x = domain.manifold_.coordinates_local_to_global(s, x);
+			x = domain.manifold().coordinates_local_to_global(s, x);
 
 			v *= std::sqrt(boltzmann_constant * Ts(x) / mass);
 
-			p->emplace_back(x, v, ns(x) * inv_sample_density);
+			p->push_back(
+					engine_push_forward<engine_type>(domain.manifold(), x, v,
+							ns(x) * inv_sample_density));
 		}
 //
 //		auto & d = p->get(s);
@@ -47,10 +47,17 @@ public:
 
 	virtual std::string get_type_as_string() const = 0;
 
-	virtual void next_timestep() =0;
+	/// push with time step 'dt', sub-cycled species get  k*dt/m (see SubCycle)
+	virtual void next_timestep(Real dt) =0;
 
 	virtual void update_fields() =0;
 
+	/// number of particles on this rank, 0 for fluid species
+	virtual size_t get_num_of_particles() const
+	{
+		return 0;
+	}
+
 };
 //template<typename TP>
 //struct ParticleWrap: public ParticleBase
@@ -1,75 +1,233 @@
 /**
  * \file particle_constraint.h
  *
- * \date    2014年9月2日  上午10:39:25 
+ * \date    2014年9月2日  上午10:39:25
  * \author salmon
  */
 
 #ifndef PARTICLE_CONSTRAINT_H_
 #define PARTICLE_CONSTRAINT_H_
 
+#include <cmath>
 #include <cstddef>
-#include <vector>
+#include <random>
+#include <string>
+
+#include "../utilities/ntuple.h"
+#include "../utilities/primitives.h"
+#include "../physics/physical_constants.h"
 
 namespace simpla
 {
-class PolicyProbeParticle;
-class PolicyKineticParticle;
-template<typename TM, typename Engine, typename Policy> class Particle;
-
-class PolicyReflectSurface;
 
-template<typename TM, typename Engine, typename Policy = PolicyReflectSurface>
+/**
+ * \ingroup Particle
+ *
+ * \brief  precompiled particle constraint
+ *
+ *   Common constraints are evaluated natively instead of calling a Lua
+ *   function per particle.
+ *
+ *  | Type         | Parameters                     | Action                                          |
+ *  |--------------|--------------------------------|-------------------------------------------------|
+ *  | "Absorb"     | [Min, Max]                     | remove particle  ( outside box [Min,Max] )      |
+ *  | "Reflect"    | Point, Normal                  | mirror x and v at plane, if (x-Point).Normal<0  |
+ *  | "Thermalize" | Temperature                    | resample v from Maxwellian                      |
+ *  | "Reinject"   | Min, Max, Temperature          | particle outside box: uniform x in box, thermal v|
+ *
+ *   Other types ("Modify","Remove") are not native, load() returns false and
+ *   the caller falls back to the Lua callback.
+ */
 class ParticleConstraint
 {
 public:
-	typedef TM mesh_type;
-	typedef Engine engine_type;
-	typedef Policy policy_type;
-	typedef typename engine_type::Poiont_s Poiont_s;
-	typedef ParticleConstraint<mesh_type, engine_type, policy_type> this_type;
 
-private:
-	typedef typename mesh_type::coordinates_type coordinates_type;
-	typedef typename mesh_type::scalar_type scalar_type;
+	typedef nTuple<Real, 3> coordinates_type;
+
+	typedef std::mt19937 random_engine_type;
 
-	typedef typename mesh_type::compact_index_type compact_index_type;
+	enum
+	{
+		NONE, ABSORB, REFLECT, THERMALIZE, REINJECT
+	};
 
-	static constexpr unsigned int NDIMS = mesh_type::NDIMS;
+	int type = NONE;
 
-	typedef Vec3 normal_polar_vec_type;
+	bool has_box = false;
 
-	std::map<compact_index_type, normal_polar_vec_type> surface_;
+	coordinates_type xmin =
+	{ 0, 0, 0 };
 
-	typedef std::tuple<coordinates_type, Vec3, scalar_type> c_particle_type;
+	coordinates_type xmax =
+	{ 0, 0, 0 };
 
-	std::function<void(c_particle_type, Vec3 const &)> op_;
+	coordinates_type point =
+	{ 0, 0, 0 };
 
-public:
-	mesh_type const & mesh;
-	std::vector<compact_index_type> range;
+	Vec3 normal =
+	{ 0, 0, 1 };
 
-	template<typename Func>
-	ParticleConstraint(mesh_type const & pm, engine_type const & pe, Func const & fun)
-			: mesh(pm), op_(fun)
-	{
+	/// thermal velocity  \f$ \sqrt{kT/m} \f$
+	Real vT = 0;
+
+	size_t seed = 5489u;
+
+	/// number of sweeps, used to decorrelate random streams of each sweep
+	mutable size_t num_of_sweeps = 0;
 
+	ParticleConstraint()
+	{
 	}
+
 	~ParticleConstraint()
 	{
 	}
+
 	/**
-	 *
-	 * @param p
-	 * @return true if particle is changed
+	 * @param dict  configure of constraint
+	 * @param mass  mass of particle
+	 * @return true if constraint is native
 	 */
-	bool operator()(Poiont_s *p) const
+	template<typename TDict>
+	bool load(TDict const & dict, Real mass)
 	{
-		c_particle_type tp = engine_type::pull_back(*p);
-		auto git = std::get<0>(mesh.coordiantes_global_to_local(std::get<0>(tp)));
-		op_(&tp, surface_[git]);
-		*p = engine_type::push_forward(tp);
-		return true;
+		DEFINE_PHYSICAL_CONST
+
+		auto str = dict["Type"].template as<std::string>("Modify");
+
+		if (dict["Min"] && dict["Max"])
+		{
+			has_box = true;
+			xmin = dict["Min"].template as<coordinates_type>();
+			xmax = dict["Max"].template as<coordinates_type>();
+		}
+
+		if (dict["Temperature"])
+		{
+			vT = std::sqrt(
+					boltzmann_constant
+							* dict["Temperature"].template as<Real>() / mass);
+		}
+
+		seed = dict["Seed"].template as<size_t>(seed);
+
+		if (str == "Absorb")
+		{
+			type = ABSORB;
+		}
+		else if (str == "Reflect")
+		{
+			type = REFLECT;
+
+			point = dict["Point"].template as<coordinates_type>(point);
+
+			normal = dict["Normal"].template as<Vec3>(normal);
+
+			normal /= std::sqrt(dot(normal, normal));
+		}
+		else if (str == "Thermalize")
+		{
+			type = THERMALIZE;
+		}
+		else if (str == "Reinject" && has_box)
+		{
+			type = REINJECT;
+		}
+		else
+		{
+			type = NONE;
+		}
+
+		return type != NONE;
+	}
+
+	bool is_removal() const
+	{
+		return type == ABSORB;
+	}
+
+	bool is_inside(coordinates_type const & x) const
+	{
+		return !has_box
+				|| (x[0] >= xmin[0] && x[0] < xmax[0] && x[1] >= xmin[1]
+						&& x[1] < xmax[1] && x[2] >= xmin[2] && x[2] < xmax[2]);
+	}
+
+	/**
+	 *  \return true if particle is absorbed
+	 */
+	bool absorb(coordinates_type const & x, Vec3 const &) const
+	{
+		return has_box ? !is_inside(x) : true;
+	}
+
+	/**
+	 * apply constraint to particle
+	 * @return true if (x,v) is changed
+	 */
+	bool operator()(coordinates_type * x, Vec3 * v,
+			random_engine_type * gen) const
+	{
+		switch (type)
+		{
+		case REFLECT:
+		{
+			Real d = dot(*x - point, normal);
+
+			if (d >= 0)
+			{
+				return false;
+			}
+
+			*x -= normal * (2.0 * d);
+
+			*v -= normal * (2.0 * dot(*v, normal));
+
+			return true;
+		}
+		case THERMALIZE:
+		{
+			if (!is_inside(*x))
+			{
+				return false;
+			}
+
+			thermal_velocity_(v, gen);
+
+			return true;
+		}
+		case REINJECT:
+		{
+			if (is_inside(*x))
+			{
+				return false;
+			}
+
+			std::uniform_real_distribution<Real> uniform(0, 1);
+
+			for (int i = 0; i < 3; ++i)
+			{
+				(*x)[i] = xmin[i] + uniform(*gen) * (xmax[i] - xmin[i]);
+			}
+
+			thermal_velocity_(v, gen);
+
+			return true;
+		}
+		default:
+			return false;
+		}
+	}
+
+private:
+	void thermal_velocity_(Vec3 * v, random_engine_type * gen) const
+	{
+		std::normal_distribution<Real> normal_dist(0, vT);
+
+		for (int i = 0; i < 3; ++i)
+		{
+			(*v)[i] = normal_dist(*gen);
+		}
 	}
 
 }
@@ -0,0 +1,111 @@
+/**
+ * \file particle_constraint_test.cpp
+ *
+ * \date    2014年11月3日  上午9:20:17
+ * \author salmon
+ */
+
+#include <gtest/gtest.h>
+#include <cmath>
+
+#include "particle_constraint.h"
+
+using namespace simpla;
+
+TEST(ParticleConstraint, reflect)
+{
+	ParticleConstraint c;
+
+	c.type = ParticleConstraint::REFLECT;
+	c.point = nTuple<Real, 3>( { 0, 0, 1 });
+	c.normal = Vec3( { 0, 0, 1 });
+
+	ParticleConstraint::random_engine_type gen;
+
+	nTuple<Real, 3> x = { 0.5, 0.5, 0.75 };
+	Vec3 v = { 1, 2, -3 };
+
+	EXPECT_TRUE(c(&x, &v, &gen));
+
+	EXPECT_DOUBLE_EQ(0.5, x[0]);
+	EXPECT_DOUBLE_EQ(1.25, x[2]);
+	EXPECT_DOUBLE_EQ(1, v[0]);
+	EXPECT_DOUBLE_EQ(2, v[1]);
+	EXPECT_DOUBLE_EQ(3, v[2]);
+
+	// already on the right side
+	EXPECT_FALSE(c(&x, &v, &gen));
+	EXPECT_DOUBLE_EQ(1.25, x[2]);
+}
+
+TEST(ParticleConstraint, absorb)
+{
+	ParticleConstraint c;
+
+	c.type = ParticleConstraint::ABSORB;
+
+	Vec3 v = { 0, 0, 0 };
+
+	EXPECT_TRUE(c.is_removal());
+	EXPECT_TRUE(c.absorb(nTuple<Real, 3>( { 5, 5, 5 }), v));
+
+	c.has_box = true;
+	c.xmin = nTuple<Real, 3>( { 0, 0, 0 });
+	c.xmax = nTuple<Real, 3>( { 1, 1, 1 });
+
+	EXPECT_FALSE(c.absorb(nTuple<Real, 3>( { 0.5, 0.5, 0.5 }), v));
+	EXPECT_TRUE(c.absorb(nTuple<Real, 3>( { 1.5, 0.5, 0.5 }), v));
+}
+
+TEST(ParticleConstraint, thermalize)
+{
+	ParticleConstraint c;
+
+	c.type = ParticleConstraint::THERMALIZE;
+	c.vT = 2.0;
+
+	ParticleConstraint::random_engine_type gen;
+
+	size_t num = 100000;
+
+	Real v2 = 0;
+
+	nTuple<Real, 3> x = { 0, 0, 0 };
+
+	for (size_t i = 0; i < num; ++i)
+	{
+		Vec3 v = { 100, 100, 100 };
+
+		EXPECT_TRUE(c(&x, &v, &gen));
+
+		v2 += dot(v, v);
+	}
+
+	EXPECT_NEAR(3 * c.vT * c.vT, v2 / num, 0.05 * 3 * c.vT * c.vT);
+}
+
+TEST(ParticleConstraint, reinject)
+{
+	ParticleConstraint c;
+
+	c.type = ParticleConstraint::REINJECT;
+	c.has_box = true;
+	c.xmin = nTuple<Real, 3>( { 0, 0, 0 });
+	c.xmax = nTuple<Real, 3>( { 1, 2, 3 });
+	c.vT = 1.0;
+
+	ParticleConstraint::random_engine_type gen;
+
+	nTuple<Real, 3> x = { 0.5, 0.5, 0.5 };
+	Vec3 v = { 1, 1, 1 };
+
+	EXPECT_FALSE(c(&x, &v, &gen));
+
+	for (int i = 0; i < 100; ++i)
+	{
+		x = nTuple<Real, 3>( { -1, 5, 7 });
+
+		EXPECT_TRUE(c(&x, &v, &gen));
+		EXPECT_TRUE(c.is_inside(x));
+	}
+}
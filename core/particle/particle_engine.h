@@ -8,6 +8,7 @@
 #ifndef PARTICLE_ENGINE_H_
 #define PARTICLE_ENGINE_H_
 #include <stddef.h>
+#include <type_traits>
 #include "../physics/physical_constants.h"
 #include "../utilities/properties.h"
 #include "../utilities/sp_type_traits.h"
@@ -32,11 +33,13 @@ namespace simpla
  * \code E::properties \endcode | properties
  * \code std::tuple<...> E::get_properties()\endcode | return (mass,charge,...)
  * \code void E::update();\endcode | update charge/mass and properties cache
- * \code void E::next_timestep(Point_s * p, Real dt, TE const & E, TB const &  B) const; \endcode | Using field E,B push particle p, a  time step dt
+ * \code void E::next_timestep(Point_s * p, Real dt, Args const & ... args) const; \endcode | push particle p a time step dt, i.e. args= J,E,B, scatter J by J->scatter(x,v,w)
+ * \code void E::next_timestep(TIterator ib, TIterator ie, Real dt, Args const & ... args) const; \endcode | (optional) push particles [ib,ie) of one cell, gather E,B and scatter J once per cell. KineticParticle uses it instead of the per-particle push if it exists
  * \code void E::ScatterJ(Point_s const & p, TJ * J) const; \endcode | Scatter current density (v*f) to field J
  * \code void E::ScatterRho(Point_s const & p, TJ * rho) const; \endcode | Scatter density ( f) to field rho
  * \code static Point_s E::push_forward(Vec3 const & x, Vec3 const &v, Real f);\endcode| push forward Cartesian Coordinates x , velocity vector v  and sample weight f to paritlce's coordinates
  * \code static std::tuple<Vec3,Vec3,Real>  E::pull_back(Point_s const & p); \endcode| pull back particle coordinates to Cartesian coordinates;
+ * \code E::Point_s::s \endcode | (optional) compact index of the cell, if present x is relative to cell 's' (mixed precision storage, i.e. PICDeltaFMixed), push_forward/pull_back take the mesh as first argument, engine_push_forward/engine_pull_back pass it when needed
  *
  *
  * example:
@@ -257,7 +260,7 @@ struct _S_NAME_                                                  \
 #define SP_PARTICLE_ADD_PROP_CHOOSE_HELPER(count) SP_PARTICLE_ADD_PROP_CHOOSE_HELPER1(count)
 #define SP_PARTICLE_ADD_PROP(_S_NAME_,...) SP_PARTICLE_ADD_PROP_CHOOSE_HELPER(COUNT_MACRO_ARGS(__VA_ARGS__)) (_S_NAME_,__VA_ARGS__)
 
-#define SP_PARTICLE_LOAD_DICT_HELPER2(_S1_,_S2_,_T0_,_N0_) _N0_=_S2_[#_N0_].template as<_T0_>();_S1_.template set<_T0_>(#_N0_,_N0_);
+#define SP_PARTICLE_LOAD_DICT_HELPER2(_S1_,_S2_,_T0_,_N0_) _N0_=_S2_[#_N0_].template as<_T0_>(_N0_);_S1_.template set<_T0_>(#_N0_,_N0_);
 #define SP_PARTICLE_LOAD_DICT_HELPER4(_S1_,_S2_,_T0_,_N0_,_T1_,_N1_) SP_PARTICLE_LOAD_DICT_HELPER2(_S1_,_S2_,_T0_,_N0_) \
 	  SP_PARTICLE_LOAD_DICT_HELPER2(_S1_,_S2_,_T1_,_N1_)
 #define SP_PARTICLE_LOAD_DICT_HELPER6(_S1_,_S2_,_T0_,_N0_,_T1_,_N1_,_T2_,_N2_)  SP_PARTICLE_LOAD_DICT_HELPER2(_S1_,_S2_,_T0_,_N0_) \
@@ -305,7 +308,8 @@ struct _S_NAME_                                                  \
  * \ingroup Particle
  *
  *  \brief Define Property variables:
- *     MAX number of variable is 9
+ *     MAX number of variable is 9, variables missing in the dictionary keep
+ *     their value
  * * Usage:
  *  \code SP_DEFINE_PROPERTIES(Real, mass,	Real, charge,Real, temperature)  \endcode
  *
@@ -327,9 +331,9 @@ struct _S_NAME_                                                  \
  *  template<typename TDict,typename ...Others>
  *  void load(TDict const & dict,Others && ...)
  *  {
- *  	mass=dict["mass"].template as<Real>();properties.template set<Real>("mass",mass);
- *  	charge=dict["charge"].template as<Real>();properties.template set<Real>("charge",charge);
- *  	temperature=dict["temperature"].template as<Real>();properties.template set<Real>("temperature",temperature);
+ *  	mass=dict["mass"].template as<Real>(mass);properties.template set<Real>("mass",mass);
+ *  	charge=dict["charge"].template as<Real>(charge);properties.template set<Real>("charge",charge);
+ *  	temperature=dict["temperature"].template as<Real>(temperature);properties.template set<Real>("temperature",temperature);
  *  	update();
  *}
  * \endcode
@@ -401,7 +405,7 @@ public:
 	}
 
 	template<typename TJ, typename TE, typename TB>
-	void next_timestep(Point_s * p, TJ* J, Real dt, TE const &fE,
+	void next_timestep(Point_s * p, Real dt, TJ* J, TE const &fE,
 			TB const & fB) const
 	{
 		p->x += p->v * dt * 0.5;
@@ -415,12 +419,12 @@ public:
 
 		p->v += E * (cmr_ * dt * 0.5);
 
-		v_ = p->v + Cross(p->v, t);
+		v_ = p->v + cross(p->v, t);
 
-		v_ = Cross(v_, t) / (Dot(t, t) + 1.0);
+		v_ = cross(v_, t) / (dot(t, t) + 1.0);
 
 		p->v += v_;
-		auto a = (-Dot(E, p->v) * q_kT_ * dt);
+		auto a = (-dot(E, p->v) * q_kT_ * dt);
 		p->w = (-a + (1 + 0.5 * a) * p->w) / (1 - 0.5 * a);
 
 		p->v += v_;
@@ -428,8 +432,7 @@ public:
 
 		p->x += p->v * dt * 0.5;
 
-		J->scatter_cartesian(
-				std::forward_as_tuple(p->x, p->v, p->f * charge * p->w));
+		J->scatter(p->x, p->v, p->f * charge * p->w);
 
 	}
 
@@ -442,6 +445,51 @@ public:
 	static inline auto pull_back(Point_s const & p)
 			DECL_RET_TYPE((std::make_tuple(p.x,p.v,p.f)))
 };
+
+namespace _impl
+{
+HAS_MEMBER(s);
+}  // namespace _impl
+
+/**
+ *  \ingroup ParticleEngine
+ *  \brief  E::push_forward, with 'mesh' if Point_s stores its cell 's'.
+ *
+ *  Loaders and sources create particles by it, so they work for every
+ *  engine.
+ */
+template<typename TEngine, typename TM, typename TX, typename TV>
+auto engine_push_forward(TM const & mesh, TX const & x, TV const & v, Real f)
+->typename std::enable_if<_impl::has_member_s<typename TEngine::Point_s>::value,
+typename TEngine::Point_s>::type
+{
+	return TEngine::push_forward(mesh, x, v, f);
+}
+
+template<typename TEngine, typename TM, typename TX, typename TV>
+auto engine_push_forward(TM const &, TX const & x, TV const & v, Real f)
+->typename std::enable_if<!_impl::has_member_s<typename TEngine::Point_s>::value,
+typename TEngine::Point_s>::type
+{
+	return TEngine::push_forward(x, v, f);
+}
+
+/// E::pull_back, Cartesian (x,v,f) of 'p'
+template<typename TEngine, typename TM, typename TP>
+auto engine_pull_back(TM const & mesh, TP const & p)
+->typename std::enable_if<_impl::has_member_s<TP>::value,
+decltype(TEngine::pull_back(mesh,p))>::type
+{
+	return TEngine::pull_back(mesh, p);
+}
+
+template<typename TEngine, typename TM, typename TP>
+auto engine_pull_back(TM const &, TP const & p)
+->typename std::enable_if<!_impl::has_member_s<TP>::value,
+decltype(TEngine::pull_back(p))>::type
+{
+	return TEngine::pull_back(p);
+}
 }
 // namespace simpla
 
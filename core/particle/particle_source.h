@@ -16,6 +16,7 @@
 #include "../utilities/log.h"
 #include "../utilities/utilities.h"
 #include "../parallel/mpi_aux_functions.h"
+#include "particle_engine.h"
 
 namespace simpla
 {
@@ -26,7 +27,7 @@ class ParticleSource
 public:
 	typedef TM mesh_type;
 	typedef Engine engine_type;
-	typedef typename engine_type::Poiont_s value_type;
+	typedef typename engine_type::Point_s value_type;
 	typedef ParticleSource<mesh_type, engine_type> this_type;
 	mesh_type const & mesh;
 	engine_type const & engine;
@@ -114,7 +115,7 @@ public:
 
 		v *= vs_(x);
 
-		return engine_type::push_forward(std::forward_as_tuple(x, v, f_(x)));
+		return engine_push_forward<engine_type>(mesh, x, v, f_(x));
 	}
 
 };
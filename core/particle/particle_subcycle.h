@@ -0,0 +1,176 @@
+/**
+ * \file particle_subcycle.h
+ *
+ * \date    2014年11月14日  下午2:31:45
+ * \author salmon
+ */
+
+#ifndef PARTICLE_SUBCYCLE_H_
+#define PARTICLE_SUBCYCLE_H_
+
+#include <cstddef>
+#include <memory>
+
+#include "../utilities/primitives.h"
+#include "../utilities/log.h"
+
+namespace simpla
+{
+
+/**
+ *  \ingroup Particle
+ *  \brief  multi-rate time stepping of one species
+ *
+ *   A species is pushed 'sub_steps' times, with
+ *   \f$ dt_p=every\cdot dt/sub\_steps \f$, on the last field step of every
+ *   cycle of 'every' field steps.
+ *
+ *   - heavy species: every=k>1, pushed once per k steps with the fields
+ *     averaged over the cycle,
+ *   - light species: sub_steps=m>1, pushed m times in one field step.
+ *
+ *   Configure: Particles = { H = { ..., SubCycle = 4 }, ele = { ..., SubSteps = 2 } }
+ */
+struct SubCycle
+{
+	size_t every = 1;
+
+	size_t sub_steps = 1;
+
+	SubCycle(size_t k = 1, size_t m = 1) :
+			every(k), sub_steps(m)
+	{
+		if (every == 0 || sub_steps == 0)
+		{
+			RUNTIME_ERROR("SubCycle: ratio must be positive!");
+		}
+	}
+
+	template<typename TDict>
+	bool load(TDict const & dict)
+	{
+		if (!dict)
+			return false;
+
+		*this = SubCycle(dict["SubCycle"].template as<size_t>(1),
+				dict["SubSteps"].template as<size_t>(1));
+
+		return true;
+	}
+
+	/// species with its own time step, it needs averaged fields / held current
+	bool is_multi_rate() const
+	{
+		return every > 1 || sub_steps > 1;
+	}
+
+	/// push at field step 'clock'
+	bool is_due(size_t clock) const
+	{
+		return (clock + 1) % every == 0;
+	}
+
+	/// first field step of a cycle
+	bool is_first(size_t clock) const
+	{
+		return clock % every == 0;
+	}
+
+	/// time step of one push
+	Real dt(Real field_dt) const
+	{
+		return field_dt * static_cast<Real>(every)
+				/ static_cast<Real>(sub_steps);
+	}
+
+	/// pushes per field step,  averaged over a cycle
+	Real pushes_per_step() const
+	{
+		return static_cast<Real>(sub_steps) / static_cast<Real>(every);
+	}
+};
+
+/**
+ *  \ingroup Particle
+ *  \brief  fields of a sub-cycled species
+ *
+ *   E,B are summed over the cycle and averaged before the push, J is the
+ *   current of the last push, averaged over its sub-steps.  J is added to
+ *   the total current on every field step of the following cycle, i.e. the
+ *   current of a sub-cycled species lags by one cycle.
+ */
+template<typename TE, typename TB, typename TJ>
+struct SubCycleFields
+{
+	SubCycle cycle;
+
+	std::shared_ptr<TE> E;
+	std::shared_ptr<TB> B;
+	std::shared_ptr<TJ> J;
+
+	size_t count = 0;
+
+	template<typename TM>
+	SubCycleFields(SubCycle const & c, TM const & mesh) :
+			cycle(c), E(new TE(mesh)), B(new TB(mesh)), J(new TJ(mesh))
+	{
+		E->clear();
+		B->clear();
+		J->clear();
+	}
+
+	void accumulate(TE const & E1, TB const & B1)
+	{
+		*E += E1;
+		*B += B1;
+		++count;
+	}
+
+	/**
+	 *  push species 'p' with the averaged fields, the context fields are
+	 *  swapped with the averages so particles see them in place
+	 */
+	template<typename TP>
+	void push(TP & p, Real field_dt, TE * E1, TB * B1, TJ * J1)
+	{
+		bool average = cycle.every > 1 && count > 0;
+
+		if (average)
+		{
+			*E *= 1.0 / static_cast<Real>(count);
+			*B *= 1.0 / static_cast<Real>(count);
+
+			E1->swap(*E);
+			B1->swap(*B);
+		}
+
+		J->clear();
+
+		J1->swap(*J);
+
+		Real dt = cycle.dt(field_dt);
+
+		for (size_t n = 0; n < cycle.sub_steps; ++n)
+		{
+			p.next_timestep(dt);
+		}
+
+		J1->swap(*J);
+
+		*J *= 1.0 / static_cast<Real>(cycle.sub_steps);
+
+		if (average)
+		{
+			E1->swap(*E);
+			B1->swap(*B);
+		}
+
+		E->clear();
+		B->clear();
+		count = 0;
+	}
+};
+
+}  // namespace simpla
+
+#endif /* PARTICLE_SUBCYCLE_H_ */
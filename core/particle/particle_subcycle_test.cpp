@@ -0,0 +1,154 @@
+/*
+ * @file particle_subcycle_test.cpp
+ *
+ * @date created on: 2014-11-14
+ *      @Author: salmon
+ */
+
+#include <gtest/gtest.h>
+
+#include "../utilities/log.h"
+#include "particle_subcycle.h"
+
+using namespace simpla;
+
+/// scalar stand-in of a field
+struct SubCycleTestField
+{
+	Real v = 0;
+
+	template<typename TM>
+	SubCycleTestField(TM const &)
+	{
+	}
+
+	void clear()
+	{
+		v = 0;
+	}
+	void swap(SubCycleTestField & r)
+	{
+		std::swap(v, r.v);
+	}
+	SubCycleTestField & operator+=(SubCycleTestField const & r)
+	{
+		v += r.v;
+		return *this;
+	}
+	SubCycleTestField & operator*=(Real a)
+	{
+		v *= a;
+		return *this;
+	}
+};
+
+/// deposits the field it sees as current,  counts pushes
+struct SubCycleTestParticle
+{
+	SubCycleTestField const & E;
+	SubCycleTestField & J;
+
+	size_t num_of_pushes = 0;
+	Real time = 0;
+
+	SubCycleTestParticle(SubCycleTestField const & pE, SubCycleTestField & pJ) :
+			E(pE), J(pJ)
+	{
+	}
+
+	void next_timestep(Real dt)
+	{
+		++num_of_pushes;
+		time += dt;
+		J.v += E.v;
+	}
+};
+
+TEST(particle_subcycle, schedule)
+{
+	SubCycle heavy(4, 1), light(1, 3);
+
+	EXPECT_TRUE(heavy.is_multi_rate());
+	EXPECT_TRUE(light.is_multi_rate());
+	EXPECT_FALSE(SubCycle().is_multi_rate());
+
+	size_t count = 0;
+	for (size_t clock = 0; clock < 12; ++clock)
+	{
+		if (heavy.is_due(clock))
+			++count;
+		EXPECT_TRUE(light.is_due(clock));
+	}
+	EXPECT_EQ(3, count);
+	EXPECT_TRUE(heavy.is_first(4));
+	EXPECT_TRUE(heavy.is_due(3));
+
+	EXPECT_DOUBLE_EQ(0.4, heavy.dt(0.1));
+	EXPECT_DOUBLE_EQ(0.1 / 3.0, light.dt(0.1));
+	EXPECT_DOUBLE_EQ(0.25, heavy.pushes_per_step());
+
+	EXPECT_THROW(SubCycle(0, 1), std::runtime_error);
+}
+
+TEST(particle_subcycle, average_fields)
+{
+	LOGGER.set_stdout_visable_level(10);
+
+	typedef SubCycleTestField F;
+
+	int mesh = 0;
+
+	F E1(mesh), B1(mesh), J1(mesh);
+
+	SubCycleFields<F, F, F> sub(SubCycle(4, 1), mesh);
+
+	SubCycleTestParticle p(E1, J1);
+
+	Real dt = 0.1;
+
+	for (size_t clock = 0; clock < 8; ++clock)
+	{
+		E1.v = static_cast<Real>(clock);
+		J1.clear();
+
+		sub.accumulate(E1, B1);
+
+		if (sub.cycle.is_due(clock))
+		{
+			sub.push(p, dt, &E1, &B1, &J1);
+
+			// particle saw the mean of E over the cycle
+			EXPECT_DOUBLE_EQ((clock - 1.5), sub.J->v);
+
+			// context fields are restored
+			EXPECT_DOUBLE_EQ(static_cast<Real>(clock), E1.v);
+			EXPECT_DOUBLE_EQ(0.0, J1.v);
+		}
+	}
+
+	EXPECT_EQ(2, p.num_of_pushes);
+	EXPECT_DOUBLE_EQ(0.8, p.time);
+}
+
+TEST(particle_subcycle, sub_steps)
+{
+	typedef SubCycleTestField F;
+
+	int mesh = 0;
+
+	F E1(mesh), B1(mesh), J1(mesh);
+
+	SubCycleFields<F, F, F> sub(SubCycle(1, 3), mesh);
+
+	SubCycleTestParticle p(E1, J1);
+
+	E1.v = 2.0;
+
+	sub.push(p, 0.3, &E1, &B1, &J1);
+
+	EXPECT_EQ(3, p.num_of_pushes);
+	EXPECT_DOUBLE_EQ(0.3, p.time);
+
+	// current is averaged over the sub-steps
+	EXPECT_DOUBLE_EQ(2.0, sub.J->v);
+}
@@ -13,6 +13,7 @@
 #include "../utilities/log.h"
 #include "../utilities/memory_pool.h"
 #include "../utilities/utilities.h"
+#include "../parallel/numa_placement.h"
 namespace simpla
 {
 /**
@@ -140,7 +141,7 @@ public:
 	{
 		allocate();
 
-		std::memset(data_.get(), 0, sizeof(value_type)*num_of_ele_);
+		first_touch(data_.get(), num_of_ele_);
 	}
 
 	void fill(value_type v)
@@ -1,19 +1,29 @@
 /**
  * \file container_pool.h
  *
- * \date    2014年8月26日  下午4:30:23 
+ * \date    2014年8月26日  下午4:30:23
  * \author salmon
  */
 
 #ifndef CONTAINER_POOL_H_
 #define CONTAINER_POOL_H_
-#include <map>
+#include <algorithm>
+#include <functional>
 #include <list>
+#include <map>
+#include <vector>
+
+#include "../parallel/parallel.h"
 
 namespace simpla
 {
 template<typename ...>struct ContainerPool;
 
+/**
+ *  \brief  values binned by key,  i.e. particles binned by cell id
+ *
+ *   hash_(v) is the key of  value 'v'
+ */
 template<typename KeyType, typename ValueType>
 class ContainerPool<KeyType, ValueType>
 {
@@ -23,17 +33,15 @@ public:
 	typedef ContainerPool<key_type, value_type> this_type;
 
 	typedef std::function<key_type(value_type const &)> hash_func;
-private:
+
 	typedef std::list<value_type> inner_container;
-	typedef typename inner_container::pointer inner_pointer;
-	typedef std::map<key_type, inner_pointer> map_container;
+private:
+	typedef std::map<key_type, inner_container> map_container;
 
 	typedef map_container storage_type;
 
 	hash_func hash_;
 
-	inner_container trash_;
-
 	map_container data_;
 
 public:
@@ -47,7 +55,7 @@ public:
 	}
 
 	ContainerPool(this_type const & other) :
-			trash_(other.trash_), hash_(other.hash_)
+			hash_(other.hash_), data_(other.data_)
 
 	{
 	}
@@ -59,7 +67,7 @@ public:
 
 	inner_container make_buffer() const
 	{
-		return std::move(inner_container(trash_));
+		return std::move(inner_container());
 	}
 
 	size_t size() const;
@@ -69,39 +77,131 @@ public:
 	}
 
 	void insert(value_type &&);
+	void insert(value_type const &);
 	void insert(inner_container &);
 	void insert(this_type &);
 
 	void sort();
-	template<typename THash>
-	void sort(THash const &);
-
-	template<typename PredFun>
-	void remove_if(PredFun);
 
 	void remove(key_type const& s);
 
+	template<typename TRange, typename Pred>
+	void remove_if(TRange const & range, Pred const & pred,
+			size_t num_of_threads = GLOBAL_COMM.get_num_of_threads());
+
 	template<typename Func>
 	void modify(key_type const & s, Func const & func, inner_container*buffer =
 			nullptr);
 
+	template<typename TRange, typename Func>
+	void modify_and_migrate(TRange const & range, Func const & func,
+			size_t num_of_threads = GLOBAL_COMM.get_num_of_threads(),
+			size_t stencil_width = 4);
+
+	template<typename TRange, typename Func>
+	void modify_cells_and_migrate(TRange const & range, Func const & func,
+			size_t num_of_threads = GLOBAL_COMM.get_num_of_threads(),
+			size_t stencil_width = 4);
+
 	void clear()
 	{
-		//TODO move every thing into the trash
 		data_.clear();
 	}
-	inner_container & find(key_type const& s)
+
+	typename map_container::iterator begin()
+	{
+		return data_.begin();
+	}
+	typename map_container::iterator end()
+	{
+		return data_.end();
+	}
+	typename map_container::const_iterator begin() const
+	{
+		return data_.begin();
+	}
+	typename map_container::const_iterator end() const
+	{
+		return data_.end();
+	}
+
+	inner_container & operator[](key_type const& s)
+	{
+		return data_[s];
+	}
+
+	inner_container const & find(key_type const& s) const
 	{
+		static const inner_container empty_;
+
 		auto it = data_.find(s);
-		if (it == data_.end())
+
+		return (it == data_.end()) ? empty_ : it->second;
+	}
+
+private:
+
+	/// move values of 'cell' whose key is not 'key' to 'buffer'
+	template<typename Func>
+	void sweep_(key_type const & key, inner_container & cell, Func const & fun,
+			map_container * buffer) const
+	{
+		auto pt = cell.begin();
+
+		while (pt != cell.end())
 		{
-			return trash_;
+			auto p = pt;
+			++pt;
+
+			fun(&(*p));
+
+			auto gid = hash_(*p);
+
+			if (gid != key)
+			{
+				auto & dest = (*buffer)[gid];
+				dest.splice(dest.end(), cell, p);
+			}
 		}
-		else
+	}
+
+	/// apply 'fun(key,cell,buffer)' to cells of 'range' by colored slabs
+	template<typename TRange, typename Func>
+	void sweep_cells_(TRange const & range, Func const & fun,
+			size_t num_of_threads, size_t stencil_width)
+	{
+		std::vector<map_container> outbound(
+				2 * std::max(num_of_threads, static_cast<size_t>(1)));
+
+		typedef decltype(split(range, size_t(1), size_t(0))) slab_type;
+
+		parallel_for_colored(range, [&](slab_type const & slab, size_t n)
 		{
-			return it->second;
+			for (auto s : slab)
+			{
+				auto cell = data_.find(s);
+
+				if (cell != data_.end())
+				{
+					fun(cell->first, cell->second, &outbound[n]);
+				}
+			}
+		}, num_of_threads, stencil_width);
+
+		for (auto & buffer : outbound)
+		{
+			merge_(&buffer);
 		}
+	}
 
+	void merge_(map_container * buffer)
+	{
+		for (auto & item : *buffer)
+		{
+			auto & dest = data_[item.first];
+			dest.splice(dest.end(), item.second);
+		}
+		buffer->clear();
 	}
 };
 
@@ -110,7 +210,7 @@ size_t ContainerPool<KeyType, ValueType>::size() const
 {
 	size_t count = 0;
 
-	for (auto const &item : trash_)
+	for (auto const &item : data_)
 	{
 		count += item.second.size();
 	}
@@ -121,84 +221,150 @@ size_t ContainerPool<KeyType, ValueType>::size() const
 template<typename KeyType, typename ValueType>
 void ContainerPool<KeyType, ValueType>::insert(value_type && p)
 {
-	trash_[hash_(p)].push_back(p);
+	data_[hash_(p)].push_back(p);
 }
 
 template<typename KeyType, typename ValueType>
-void ContainerPool<KeyType, ValueType>::insert(this_type & other)
+void ContainerPool<KeyType, ValueType>::insert(value_type const & p)
+{
+	data_[hash_(p)].push_back(p);
+}
+
+template<typename KeyType, typename ValueType>
+void ContainerPool<KeyType, ValueType>::insert(inner_container & other)
 {
-	for (auto & v : other.trash_)
+	auto pt = other.begin();
+	while (pt != other.end())
 	{
-		auto & c = trash_[v.first];
-		c.splice(c.begin(), v.second);
+		auto p = pt;
+		++pt;
+		auto & dest = data_[hash_(*p)];
+		dest.splice(dest.end(), other, p);
 	}
-
 }
+
 template<typename KeyType, typename ValueType>
-void ContainerPool<KeyType, ValueType>::sort()
+void ContainerPool<KeyType, ValueType>::insert(this_type & other)
 {
+	merge_(&other.data_);
+}
 
-	auto range = make_range(trash_.begin(), trash_.end());
+template<typename KeyType, typename ValueType>
+void ContainerPool<KeyType, ValueType>::remove(key_type const & s)
+{
+	data_.erase(s);
+}
 
-	parallel_reduce((range), *this, this,
+/**
+ *  re-bin every value, only needed when values are changed outside of
+ *  modify/modify_and_migrate
+ */
+template<typename KeyType, typename ValueType>
+void ContainerPool<KeyType, ValueType>::sort()
+{
+	map_container buffer;
 
-	[&](decltype(range) const & r,this_type * t_buffer)
+	for (auto & item : data_)
 	{
-		for(auto const & item:r)
-		{
-
-			auto pt=item.second.begin();
-			while(pt!=item.second.end())
-			{
-				auto p = pt;
-				++pt;
-
-				auto gid = hash_(*p);
-
-				if (gid != item.first)
-				{
-					auto & dest = (*t_buffer)[gid];
-					dest->splice(dest->begin(), item.second, p);
-				}
-			}
-
-		}
-	},
+		sweep_(item.first, item.second, [](value_type *)
+		{}, &buffer);
+	}
 
-	[&](this_type & l,this_type * r)
-	{
-		r->insert(l);
-	});
+	merge_(&buffer);
+}
 
+/**
+ *  remove values 'v' of cells in 'range' if pred(v) is true
+ */
+template<typename KeyType, typename ValueType>
+template<typename TRange, typename Pred>
+void ContainerPool<KeyType, ValueType>::remove_if(TRange const & range,
+		Pred const & pred, size_t num_of_threads)
+{
+	sweep_cells_(range,
+			[&](key_type const &, inner_container & cell, map_container *)
+			{
+				cell.remove_if(pred);
+			}, num_of_threads, 1);
 }
 
 template<typename KeyType, typename ValueType>
 template<typename Func>
 void ContainerPool<KeyType, ValueType>::modify(key_type const & s,
-		Func const & func, inner_container*buffer)
+		Func const & fun, inner_container*buffer)
 {
-
-	auto t_buffer = make_buffer();
+	map_container t_buffer;
 
 	auto cell = data_.find(s);
+
 	if (cell != data_.end())
 	{
-		auto pt = cell->second->begin();
-		while (pt != cell->second->end())
-		{
-			auto p = pt;
-			++pt;
+		sweep_(cell->first, cell->second, fun, &t_buffer);
+	}
 
-			if (fun(&(*p)))
-			{
-				t_buffer->splice(t_buffer->begin(), cell->second, p);
-			}
+	if (buffer != nullptr)
+	{
+		for (auto & item : t_buffer)
+		{
+			buffer->splice(buffer->end(), item.second);
 		}
 	}
+	else
+	{
+		merge_(&t_buffer);
+	}
+}
 
-	if (buffer != nullptr)
-		buffer->splice(buffer->begin(), t_buffer);
+/**
+ *  \brief  apply 'fun' to values in cells of 'range' and move values that
+ *          leave their cell, in one pass
+ *
+ *   Cells are swept by parallel_for_colored(range,...,num_of_threads,
+ *   stencil_width), so scatter in 'fun' within 'stencil_width' cells does not
+ *   race. Values that leave their cell go to the
+ *   outbound buffer of the slab, which are spliced into the destination
+ *   cells when all slabs are done. Values moved into ghost cells are left there for update_ghosts.
+ *   No global re-sort is needed.
+ */
+template<typename KeyType, typename ValueType>
+template<typename TRange, typename Func>
+void ContainerPool<KeyType, ValueType>::modify_and_migrate(
+		TRange const & range, Func const & fun, size_t num_of_threads,
+		size_t stencil_width)
+{
+	sweep_cells_(range,
+			[&](key_type const & s, inner_container & cell, map_container * buffer)
+			{
+				sweep_(s, cell, fun, buffer);
+			}, num_of_threads, stencil_width);
+}
+
+/**
+ *  \brief  as modify_and_migrate, but 'fun(s,ib,ie)' gets the key and all
+ *          values of one cell at once,  i.e. the per-cell batched push
+ *
+ *   Cells left empty by earlier sweeps stay in the pool, they are skipped,
+ *   so [ib,ie) is never empty.
+ */
+template<typename KeyType, typename ValueType>
+template<typename TRange, typename Func>
+void ContainerPool<KeyType, ValueType>::modify_cells_and_migrate(
+		TRange const & range, Func const & fun, size_t num_of_threads,
+		size_t stencil_width)
+{
+	sweep_cells_(range,
+			[&](key_type const & s, inner_container & cell, map_container * buffer)
+			{
+				if (cell.empty())
+				{
+					return;
+				}
+
+				fun(s, cell.begin(), cell.end());
 
+				sweep_(s, cell, [](value_type *)
+						{}, buffer);
+			}, num_of_threads, stencil_width);
 }
 
 }  // namespace simpla
@@ -0,0 +1,277 @@
+/**
+ * \file container_pool_test.cpp
+ *
+ * \date    2014年11月4日  上午10:12:31
+ * \author salmon
+ */
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cmath>
+#include <vector>
+#include "container_pool.h"
+#include "sp_range_indexed.h"
+#include "../parallel/tile_range_test.h"
+
+using namespace simpla;
+
+struct TestPoint
+{
+	double x;
+	int count;
+};
+
+TEST(ContainerPool, modify_and_migrate)
+{
+	ContainerPool<long, TestPoint> pool([](TestPoint const & p)->long
+	{	return static_cast<long>(std::floor(p.x));});
+
+	long num_of_cells = 64;
+	size_t pic = 10;
+
+	for (long s = 0; s < num_of_cells; ++s)
+		for (size_t i = 0; i < pic; ++i)
+		{
+			pool.insert(TestPoint( { s + (i + 0.5) / pic, 0 }));
+		}
+
+	EXPECT_EQ(num_of_cells * pic, pool.size());
+
+	for (int step = 0; step < 3; ++step)
+	{
+		pool.modify_and_migrate(TileRange(0, num_of_cells), [](TestPoint * p)
+		{
+			p->x += 0.25;
+			++p->count;
+		}, 4);
+	}
+
+	EXPECT_EQ(num_of_cells * pic, pool.size());
+
+	for (auto const & item : pool)
+	{
+		for (auto const & p : item.second)
+		{
+			// binned by key
+			EXPECT_EQ(item.first, static_cast<long>(std::floor(p.x)));
+		}
+	}
+
+	// values moved out of the range (ghost cells) are not pushed again
+	for (auto const & p : pool.find(num_of_cells))
+	{
+		EXPECT_LE(p.count, 3);
+	}
+	for (long s = 0; s < num_of_cells; ++s)
+	{
+		for (auto const & p : pool.find(s))
+		{
+			EXPECT_EQ(3, p.count);
+		}
+	}
+}
+
+TEST(ContainerPool, modify_cells_and_migrate)
+{
+	ContainerPool<long, TestPoint> pool([](TestPoint const & p)->long
+	{	return static_cast<long>(std::floor(p.x));});
+
+	long num_of_cells = 64;
+	size_t pic = 10;
+
+	for (long s = 0; s < num_of_cells; ++s)
+		for (size_t i = 0; i < pic; ++i)
+		{
+			pool.insert(TestPoint( { s + (i + 0.5) / pic, 0 }));
+		}
+
+	typedef typename ContainerPool<long, TestPoint>::inner_container::iterator iterator;
+
+	// empty the odd cells, they stay in the pool
+	pool.remove_if(TileRange(0, num_of_cells), [](TestPoint const & p)
+	{
+		return static_cast<long>(std::floor(p.x)) % 2 != 0;
+	});
+
+	EXPECT_EQ(num_of_cells * pic / 2, pool.size());
+
+	std::atomic<size_t> num_of_calls(0);
+
+	pool.modify_cells_and_migrate(TileRange(0, num_of_cells),
+			[&](long s, iterator ib, iterator ie)
+			{
+				// all values of one cell, empty cells are skipped
+				ASSERT_TRUE(ib != ie);
+
+				++num_of_calls;
+
+				for (; ib != ie; ++ib)
+				{
+					EXPECT_EQ(s, static_cast<long>(std::floor(ib->x)));
+
+					ib->x += 0.25;
+					++ib->count;
+				}
+			}, 4);
+
+	EXPECT_EQ(num_of_cells / 2, num_of_calls);
+
+	EXPECT_EQ(num_of_cells * pic / 2, pool.size());
+
+	for (auto const & item : pool)
+	{
+		for (auto const & p : item.second)
+		{
+			EXPECT_EQ(item.first, static_cast<long>(std::floor(p.x)));
+			EXPECT_EQ(1, p.count);
+		}
+	}
+}
+
+TEST(ContainerPool, stencil_width)
+{
+	GLOBAL_COMM.set_num_of_threads(8);
+
+	ContainerPool<long, TestPoint> pool([](TestPoint const & p)->long
+	{	return static_cast<long>(std::floor(p.x));});
+
+	// more threads (8) than cells / stencil width (24/4)
+	long num_of_cells = 24;
+	size_t pic = 100;
+
+	for (long s = 0; s < num_of_cells; ++s)
+		for (size_t i = 0; i < pic; ++i)
+		{
+			pool.insert(TestPoint( { s + (i + 0.5) / pic, 0 }));
+		}
+
+	// not atomic, scatter to cells -1..2 around the value, as the charge
+	// conserving deposition
+	std::vector<double> J(num_of_cells + 4, 0);
+
+	pool.modify_and_migrate(TileRange(0, num_of_cells), [&](TestPoint * p)
+	{
+		long s = static_cast<long>(std::floor(p->x)) + 1;
+
+		for (long i = -1; i <= 2; ++i)
+		{
+			J[s + i] += 1.0;
+		}
+
+		p->x += 0.5;
+	}, 8, 4);
+
+	double total = 0;
+
+	for (auto v : J)
+	{
+		total += v;
+	}
+
+	EXPECT_DOUBLE_EQ(4.0 * num_of_cells * pic, total);
+
+	// J[k] is written by cells k-3..k
+	for (long k = 3; k < num_of_cells; ++k)
+	{
+		EXPECT_DOUBLE_EQ(4.0 * pic, J[k]);
+	}
+
+	EXPECT_EQ(num_of_cells * pic, pool.size());
+
+	GLOBAL_COMM.set_num_of_threads(1);
+}
+
+/**
+ *  a materialized selection (select_by_config) is swept by colored slabs
+ *  as the mesh ranges
+ */
+TEST(ContainerPool, indexed_range)
+{
+	GLOBAL_COMM.set_num_of_threads(8);
+
+	ContainerPool<long, TestPoint> pool([](TestPoint const & p)->long
+	{	return static_cast<long>(std::floor(p.x));});
+
+	long num_of_cells = 96;
+	size_t pic = 50;
+
+	std::vector<long> selection;
+
+	for (long s = 0; s < num_of_cells; ++s)
+	{
+		for (size_t i = 0; i < pic; ++i)
+		{
+			pool.insert(TestPoint( { s + (i + 0.5) / pic, 0 }));
+		}
+
+		if (s % 3 != 2)
+		{
+			selection.push_back(s);
+		}
+	}
+
+	auto range = make_indexed_range(selection);
+
+	// not atomic, scatter to cells -1..2 as in stencil_width
+	std::vector<double> J(num_of_cells + 4, 0), expect(J.size(), 0);
+
+	for (auto s : selection)
+	{
+		for (long i = 0; i <= 3; ++i)
+		{
+			expect[s + i] += pic;
+		}
+	}
+
+	pool.modify_and_migrate(range, [&](TestPoint * p)
+	{
+		long s = static_cast<long>(std::floor(p->x)) + 1;
+
+		for (long i = -1; i <= 2; ++i)
+		{
+			J[s + i] += 1.0;
+		}
+
+		++p->count;
+	}, 8, 4);
+
+	for (size_t k = 0; k < J.size(); ++k)
+	{
+		EXPECT_DOUBLE_EQ(expect[k], J[k]) << "k = " << k;
+	}
+
+	for (auto const & item : pool)
+	{
+		for (auto const & p : item.second)
+		{
+			EXPECT_EQ(range.contains(item.first) ? 1 : 0, p.count);
+		}
+	}
+
+	GLOBAL_COMM.set_num_of_threads(1);
+}
+
+TEST(ContainerPool, sort)
+{
+	ContainerPool<long, TestPoint> pool([](TestPoint const & p)->long
+	{	return static_cast<long>(std::floor(p.x));});
+
+	for (long s = 0; s < 16; ++s)
+	{
+		pool.insert(TestPoint( { s + 0.5, 0 }));
+	}
+
+	for (auto & item : pool)
+	{
+		for (auto & p : item.second)
+		{
+			p.x += 2.0;
+		}
+	}
+
+	pool.sort();
+
+	EXPECT_EQ(16, pool.size());
+	EXPECT_TRUE(pool.find(0).empty());
+	EXPECT_EQ(1, pool.find(17).size());
+}
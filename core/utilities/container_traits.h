@@ -12,6 +12,7 @@
 #include <string.h>
 
 #include "memory_pool.h"
+#include "../parallel/numa_placement.h"
 
 namespace simpla
 {
@@ -30,6 +31,11 @@ template<typename TContainer> struct container_traits
 	{
 	}
 
+	template<typename ...T>
+	static void first_touch(T &&...)
+	{
+	}
+
 	static bool is_empty(container_type const& that)
 	{
 		return that.empty();
@@ -53,7 +59,14 @@ template<typename TV> struct container_traits<std::shared_ptr<TV>>
 
 	static void clear(std::shared_ptr<TV> d,size_t s)
 	{
-		memset(d.get(),0,s*sizeof(TV));
+		simpla::first_touch(d.get(),s);
+	}
+
+	/// place pages of a new block on the nodes of the workers of 'domain'
+	template<typename TDomain>
+	static void first_touch(std::shared_ptr<TV> d, TDomain const & domain)
+	{
+		first_touch_tiles(d.get(), domain);
 	}
 	static bool is_empty(container_type const& that)
 	{
@@ -9,6 +9,7 @@
 #define DATA_TYPE_H_
 #include <typeinfo>
 #include <typeindex>
+#include <vector>
 #include "../utilities/primitives.h"
 #include "../utilities/ntuple.h"
 #include "../utilities/log.h"
@@ -7,15 +7,109 @@
 
 #include "log.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <fstream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 #include "singleton_holder.h"
 #include "../parallel/message_comm.h"
 
 namespace simpla
 {
+
+/**
+ *  \ingroup Logging
+ *  \brief  single producer / single consumer ring buffer of log messages
+ *
+ *   Each thread owns one ring, producer is the owner thread, consumer is the
+ *   writer thread of LoggerStreams. The owner retires the ring when it exits,
+ *   the writer frees a retired ring once it is drained.
+ */
+class LoggerRing
+{
+public:
+	struct entry_type
+	{
+		int level;
+		std::chrono::system_clock::time_point time;
+		std::string msg;
+	};
+
+	static constexpr size_t CAPACITY = 1024;
+
+	LoggerRing() :
+			head_(0), tail_(0), retired_(false)
+	{
+	}
+
+	/// called by the owner thread, no push after it
+	void retire()
+	{
+		retired_.store(true, std::memory_order_release);
+	}
+
+	bool is_retired() const
+	{
+		return retired_.load(std::memory_order_acquire);
+	}
+
+	/// \return false if ring is full
+	bool push(int level, std::string && msg)
+	{
+		size_t h = head_.load(std::memory_order_relaxed);
+
+		if (h - tail_.load(std::memory_order_acquire) >= CAPACITY)
+		{
+			return false;
+		}
+
+		auto & e = buffer_[h % CAPACITY];
+
+		e.level = level;
+		e.time = std::chrono::system_clock::now();
+		e.msg = std::move(msg);
+
+		head_.store(h + 1, std::memory_order_release);
+
+		return true;
+	}
+
+	/// move all messages to 'out'
+	size_t pop_all(std::vector<entry_type> * out)
+	{
+		size_t t = tail_.load(std::memory_order_relaxed);
+		size_t h = head_.load(std::memory_order_acquire);
+
+		for (size_t i = t; i < h; ++i)
+		{
+			out->push_back(std::move(buffer_[i % CAPACITY]));
+		}
+
+		tail_.store(h, std::memory_order_release);
+
+		return h - t;
+	}
+
+private:
+	entry_type buffer_[CAPACITY];
+
+	std::atomic<size_t> head_;
+	std::atomic<size_t> tail_;
+	std::atomic<bool> retired_;
+};
+
 /**
  *  \ingroup Logging
  *  \brief Logging stream, shuold be used  as a singleton
+ *
+ *   put() only moves the message into the ring of current thread, a
+ *   background thread adds prefix (level, rank, time stamp) and writes
+ *   messages to file/stdout, files are flushed once per batch. Errors are
+ *   written synchronously, since they are followed by throw.
  */
 class LoggerStreams //: public SingletonHolder<LoggerStreams>
 {
@@ -27,11 +121,27 @@ public:
 	Properties properties;
 
 	LoggerStreams(int level = LOG_INFORM)
-			: std_out_visable_level_(level), line_width_(DEFAULT_LINE_WIDTH)
+			: line_width_(DEFAULT_LINE_WIDTH), std_out_visable_level_(level), is_stopped_(false)
 	{
+		writer_ = std::thread([this]()
+		{
+			while (!is_stopped_.load(std::memory_order_acquire))
+			{
+				if (drain_() == 0)
+				{
+					std::this_thread::sleep_for(std::chrono::milliseconds(2));
+				}
+			}
+		});
 	}
 	~LoggerStreams()
 	{
+		is_stopped_.store(true, std::memory_order_release);
+
+		writer_.join();
+
+		drain_();
+
 		if (std_out_visable_level_ >= LOG_INFORM)
 			std::cout << std::endl;
 
@@ -42,6 +152,8 @@ public:
 
 	inline void open_file(std::string const & name)
 	{
+		std::lock_guard<std::mutex> lock(io_mutex_);
+
 		if (fs.is_open())
 			fs.close();
 
@@ -65,13 +177,18 @@ public:
 		line_width_ = lineWidth;
 	}
 
-	static std::string time_stamp()
+	static std::string time_stamp(std::chrono::system_clock::time_point t =
+			std::chrono::system_clock::now())
 	{
 
-		auto now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+		auto now = std::chrono::system_clock::to_time_t(t);
+
+		struct tm tm_now;
+
+		localtime_r(&now, &tm_now);
 
 		char mtstr[100];
-		std::strftime(mtstr, 100, "%F %T", std::localtime(&now));
+		std::strftime(mtstr, 100, "%F %T", &tm_now);
 
 		return std::string(mtstr);
 	}
@@ -80,6 +197,51 @@ private:
 
 	std::ofstream fs;
 
+	std::mutex io_mutex_;
+
+	std::mutex rings_mutex_;
+
+	std::vector<std::unique_ptr<LoggerRing>> rings_;
+
+	std::atomic<bool> is_stopped_;
+
+	std::thread writer_;
+
+	/// retires the ring of a thread when the thread exits
+	struct RingOwner
+	{
+		LoggerRing * ring = nullptr;
+
+		~RingOwner()
+		{
+			if (ring != nullptr)
+			{
+				ring->retire();
+			}
+		}
+	};
+
+	LoggerRing * local_ring_()
+	{
+		static thread_local RingOwner owner;
+
+		if (owner.ring == nullptr)
+		{
+			std::lock_guard<std::mutex> lock(rings_mutex_);
+
+			rings_.emplace_back(new LoggerRing);
+
+			owner.ring = rings_.back().get();
+		}
+
+		return owner.ring;
+	}
+
+	size_t drain_();
+
+	void write_(int level, std::chrono::system_clock::time_point const & t,
+			std::string const & msg);
+
 };
 
 void LoggerStreams::init(int argc, char** argv)
@@ -124,6 +286,76 @@ void LoggerStreams::put(int level, std::string const & msg)
 
 	if (msg == "" || (level == LOG_INFORM && GLOBAL_COMM.get_rank()>0) ) return;
 
+	if (level < LOG_WARNING && level != LOG_DEBUG)
+	{
+		// error, write all pending messages, then this one
+		drain_();
+
+		std::lock_guard<std::mutex> lock(io_mutex_);
+
+		write_(level, std::chrono::system_clock::now(), msg);
+
+		fs.flush();
+
+		return;
+	}
+
+	auto ring = local_ring_();
+
+	std::string buffer(msg);
+
+	while (!ring->push(level, std::move(buffer)))
+	{
+		std::this_thread::yield();
+	}
+}
+
+size_t LoggerStreams::drain_()
+{
+	std::vector<LoggerRing::entry_type> entries;
+
+	std::lock_guard<std::mutex> lock(io_mutex_);
+
+	{
+		std::lock_guard<std::mutex> lock2(rings_mutex_);
+
+		auto it = rings_.begin();
+
+		while (it != rings_.end())
+		{
+			// retired before pop, so nothing is pushed after pop
+			bool retired = (*it)->is_retired();
+
+			(*it)->pop_all(&entries);
+
+			it = retired ? rings_.erase(it) : (it + 1);
+		}
+	}
+
+	if (entries.empty())
+	{
+		return 0;
+	}
+
+	std::stable_sort(entries.begin(), entries.end(),
+			[](LoggerRing::entry_type const & l,LoggerRing::entry_type const & r)
+			{	return l.time<r.time;});
+
+	for (auto const & e : entries)
+	{
+		write_(e.level, e.time, e.msg);
+	}
+
+	fs.flush();
+
+	std::cout.flush();
+
+	return entries.size();
+}
+
+void LoggerStreams::write_(int level,
+		std::chrono::system_clock::time_point const & t, std::string const & msg)
+{
 	std::string prefix(""), surfix("");
 
 	switch (level)
@@ -155,13 +387,11 @@ void LoggerStreams::put(int level, std::string const & msg)
 		prefix+="[" + ToString(GLOBAL_COMM.get_rank()) + "/" + ToString(GLOBAL_COMM.get_size())+ "]";
 	}
 
-	prefix+="[" + time_stamp() + "]";
-
-	if (!fs.good()) open_file("simpla.log");
+	prefix+="[" + time_stamp(t) + "]";
 
-	// @bug  can not write SimPla log to file
+	if (!fs.good() || !fs.is_open()) fs.open("simpla.log", std::ios_base::trunc);
 
-	fs <<std::endl<< prefix << msg << surfix;;
+	fs << '\n' << prefix << msg << surfix;
 
 	if (level <= std_out_visable_level_)
 	{
@@ -171,13 +401,13 @@ void LoggerStreams::put(int level, std::string const & msg)
 			case LOG_OUT_RANGE_ERROR:
 			case LOG_LOGIC_ERROR:
 			case LOG_ERROR:
-			std::cerr <<std::endl<<"\e[1;31m"<< prefix <<"\e[1;37m"<< msg <<"\e[0m"<< surfix;
+			std::cerr <<'\n'<<"\e[1;31m"<< prefix <<"\e[1;37m"<< msg <<"\e[0m"<< surfix;
 			break;
 			case LOG_WARNING:
-			std::cerr <<std::endl<<"\e[1;32m"<< prefix <<"\e[1;37m"<< msg <<"\e[0m"<< surfix;
+			std::cerr <<'\n'<<"\e[1;32m"<< prefix <<"\e[1;37m"<< msg <<"\e[0m"<< surfix;
 			break;
 			default:
-			std::cout <<std::endl<< prefix << msg << surfix;
+			std::cout <<'\n'<< prefix << msg << surfix;
 		}
 
 	}
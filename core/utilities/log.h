@@ -221,7 +221,15 @@ inline std::string ShowBit(unsigned long s)
 
 #define LOGGER Logger(LOG_LOG)
 
-#define VERBOSE Logger(LOG_VERBOSE)
+/**
+ *  messages of level > SIMPLA_MAX_LOG_LEVEL are removed at compile time,
+ *  i.e. -DSIMPLA_MAX_LOG_LEVEL=1 drops VERBOSE
+ */
+#ifndef SIMPLA_MAX_LOG_LEVEL
+#	define SIMPLA_MAX_LOG_LEVEL LOG_VERBOSE
+#endif
+
+#define VERBOSE if(LOG_VERBOSE > SIMPLA_MAX_LOG_LEVEL){}else Logger(LOG_VERBOSE)
 
 #define ERROR(_MSG_) { {Logger(LOG_ERROR) <<"["<<__FILE__<<":"<<__LINE__<<":"<<  (__PRETTY_FUNCTION__)<<"]:\n\t"<<(_MSG_);}throw(std::logic_error("error"));}
 
@@ -243,7 +251,14 @@ inline std::string ShowBit(unsigned long s)
 #endif
 
 //#ifndef NDEBUG
-#define CHECK(_MSG_)    Logger(LOG_DEBUG) <<" "<< (__FILE__) <<": line "<< (__LINE__)<<":"<<  (__PRETTY_FUNCTION__) \
+/// -DSIMPLA_DISABLE_DEBUG_LOG removes CHECK at compile time
+#ifdef SIMPLA_DISABLE_DEBUG_LOG
+#	define SIMPLA_DEBUG_LOG_ENABLED false
+#else
+#	define SIMPLA_DEBUG_LOG_ENABLED true
+#endif
+
+#define CHECK(_MSG_)   if(!SIMPLA_DEBUG_LOG_ENABLED){}else Logger(LOG_DEBUG) <<" "<< (__FILE__) <<": line "<< (__LINE__)<<":"<<  (__PRETTY_FUNCTION__) \
 	<<"\n\t"<< __STRING(_MSG_)<<"="<< ( _MSG_)<<" "
 
 #define REDUCE_CHECK(_MSG_)    {auto __a= (_MSG_); __a=reduce(__a); if(GLOBAL_COMM.get_rank()==0){ Logger(LOG_DEBUG) <<" "<< (__FILE__) <<": line "<< (__LINE__)<<":"<<  (__PRETTY_FUNCTION__) \
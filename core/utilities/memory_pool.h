@@ -7,79 +7,200 @@
  */
 #ifndef INCLUDE_MEMORY_POOL_H_
 #define INCLUDE_MEMORY_POOL_H_
-#include <map>
+#include <stdlib.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <atomic>
 #include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#ifdef USE_NUMA
+#include <numa.h>
+#endif
 #include "singleton_holder.h"
 #include "primitives.h"
 #include "log.h"
+#include "parse_command_line.h"
 namespace simpla
 {
 
-void deallocate_m(void *p);
-//! \ingroup Utilities
+/**
+ *  \ingroup Utilities
+ *
+ *  \brief size-class memory pool
+ *
+ *  - Every request is rounded up to a size class, four classes per power of
+ *    two, so the waste is less than 25%. The class of a block is computed from
+ *    its size with a bit scan, allocate/deallocate are O(1).
+ *  - Free blocks of small classes are cached in a per-thread free list, the
+ *    shared free lists are guarded by one mutex per class.
+ *  - Blocks are 64 byte aligned and registered in a table  pointer -> class,
+ *    split in shards with one mutex each. deallocate() looks the pointer up
+ *    before anything else, pointers not allocated by the pool are ignored.
+ *  - Large blocks (>= 2MB) are aligned to 2MB and advised to use transparent
+ *    huge pages. The pool never writes to them, so pages are placed by the
+ *    first thread that touches them (NUMA first touch).
+ *  - Placement policy of large blocks: PLACEMENT_FIRST_TOUCH (default) leaves
+ *    pages to the first writer, fields touch new blocks with the tiles of
+ *    their parallel_for (first_touch_tiles(), parallel/numa_placement.h). PLACEMENT_INTERLEAVE spreads
+ *    pages over all NUMA nodes, for data without an owner thread.
+ *  - get_memory_size reports live (used) and  cached (unused) bytes exactly.
+ *  - Freed blocks are cached up to the retention limit, default 1GB per pool,
+ *    set by set_pool_size() or command line option --mempool_size <MB>.
+ *    Beyond it cached blocks are released to the system, from the largest
+ *    class.
+ *
+ *  \note Pools must outlive the threads that allocate from them.
+ */
 class MemoryPool
 {
 private:
+	typedef unsigned char byte_type;
+
 	enum
 	{
-		MAX_POOL_DEPTH = 128
+		ALIGNMENT = 64,
+
+		MIN_CLASS_SIZE = 64,
+
+		NUM_OF_SHARDS = 64,
+
+		NUM_OF_CLASSES = 240,
+
+		THREAD_CACHE_DEPTH = 32
 	};
+	static constexpr size_t LARGE_BLOCK_SIZE = 2UL * 1024UL * 1024UL;
 
-	typedef unsigned char byte_type;
+	static constexpr size_t MAX_THREAD_CACHED_SIZE = 64UL * 1024UL;
 
-	std::map<size_t, std::shared_ptr<byte_type>> released_raw_ptr_;
+	static constexpr size_t ONE_MEGA = 1024UL * 1024UL;
 
-	std::multimap<size_t, std::shared_ptr<byte_type> > pool_;
+	static constexpr size_t ONE_GIGA = 1024UL * ONE_MEGA;
 
-	size_t MAX_POOL_SIZE;
+	static constexpr size_t DEFAULT_POOL_SIZE = ONE_GIGA;
 
-	const size_t ONE_GIGA = 1024l * 1024l * 1024l;
+	struct ThreadCache;
 
-	size_t ratio_; /// allocatro release free memory block when "demanded size"< block size < ratio_ * "demanded size"
+	struct Shard
+	{
+		std::mutex lock;
+
+		std::unordered_map<void*, size_t> blocks; // ptr -> class
+	};
+
+	Shard shards_[NUM_OF_SHARDS];
+
+	std::mutex class_lock_[NUM_OF_CLASSES];
+
+	std::vector<void*> free_[NUM_OF_CLASSES];
+
+	std::atomic<size_t> used_memory_;
+
+	std::atomic<size_t> unused_memory_;
+
+	size_t MAX_POOL_SIZE;
+
+	int placement_policy_;
 
 public:
 
+	enum
+	{
+		PLACEMENT_FIRST_TOUCH = 0, PLACEMENT_INTERLEAVE = 1
+	};
+
 	MemoryPool() :
-			MAX_POOL_SIZE(4), ratio_(2) //2G
+			used_memory_(0), unused_memory_(0), MAX_POOL_SIZE(DEFAULT_POOL_SIZE),
+			placement_policy_(PLACEMENT_FIRST_TOUCH)
 	{
 	}
 	~MemoryPool()
 	{
-		pool_.clear();
-		released_raw_ptr_.clear();
+		drain_thread_cache();
+
+		for (size_t cls = 0; cls < NUM_OF_CLASSES; ++cls)
+		{
+			for (auto p : free_[cls])
+			{
+				release_block(p, cls);
+			}
+			free_[cls].clear();
+		}
+	}
+
+	MemoryPool(MemoryPool const &) = delete;
+
+	MemoryPool & operator=(MemoryPool const &) = delete;
+
+	/// option --mempool_size <MB> : retention limit of cached free blocks
+	void init(int argc, char** argv)
+	{
+		ParseCmdLine(argc, argv,
+
+		[&,this](std::string const & opt,std::string const & value)->int
+		{
+			if( opt=="mempool_size")
+			{
+				this->set_pool_size(std::stoul(value)*ONE_MEGA);
+			}
+			return CONTINUE;
+		}
+
+		);
+	}
+
+	// unused memory will be freed when total cached memory size >= pool size
+	void set_pool_size(size_t s)
+	{
+		MAX_POOL_SIZE = s;
+
+		if (unused_memory_.load(std::memory_order_relaxed) > MAX_POOL_SIZE)
+		{
+			ReleaseMemory();
+		}
 	}
 
-	// unused memory will be freed when total memory size >= pool size
 	void set_pool_size_in_GB(size_t s)
 	{
-		MAX_POOL_SIZE = s * ONE_GIGA;
+		set_pool_size(s * ONE_GIGA);
+	}
+
+	size_t get_pool_size() const
+	{
+		return MAX_POOL_SIZE;
+	}
+
+	/**
+	 *  placement of  newly allocated large blocks, cached blocks keep the
+	 *  placement of their pages.
+	 */
+	void set_placement_policy(int policy)
+	{
+		placement_policy_ = policy;
+	}
+	int get_placement_policy() const
+	{
+		return placement_policy_;
 	}
 
 	/**
 	 *
-	 * @param p_unused
-	 * @param p_used
-	 * @return
+	 * @param p_unused  size of cached free blocks
+	 * @param p_used    size of blocks in use
+	 * @return  total size of memory held by pool
 	 */
 	size_t get_memory_size(size_t * p_unused = nullptr, size_t * p_used =
 			nullptr) const
 	{
-		size_t unused_memory = 0;
-		size_t used_memory = 0;
-		for (auto const & p : pool_)
-		{
-			if (p.second.unique())
-			{
-				unused_memory += p.first;
-			}
-			else
-			{
-				used_memory += p.first;
-			}
-		}
+		size_t unused_memory = unused_memory_.load(std::memory_order_relaxed);
+		size_t used_memory = used_memory_.load(std::memory_order_relaxed);
+
 		if (p_unused != nullptr)
 		{
-			*p_unused = used_memory;
+			*p_unused = unused_memory;
 		}
 		if (p_used != nullptr)
 		{
@@ -111,32 +232,49 @@ public:
 		return static_cast<double>(total) / static_cast<double>(ONE_GIGA);
 	}
 
-	inline byte_type * allocate(size_t size)
+	inline byte_type * allocate(size_t demand)
 	{
-		std::shared_ptr<byte_type> res = _allocate_shared_ptr(size);
+		size_t cls = size_class(demand);
+
+		void * p = pop_free_block(cls);
 
-		released_raw_ptr_[std::hash<std::shared_ptr<byte_type>>()(res)] = res;
+		if (p == nullptr)
+		{
+			p = acquire_block(cls);
+		}
+		else
+		{
+			unused_memory_ -= class_size(cls);
+		}
 
-		return res.get();
+		used_memory_ += class_size(cls);
 
+		return reinterpret_cast<byte_type*>(p);
 	}
 
-	inline void deallocate(void * p, size_t size = 0)
+	/// pointers not allocated by this pool are ignored
+	inline void deallocate(void * p, size_t = 0)
 	{
-		auto it = released_raw_ptr_.find(
-				std::hash<byte_type *>()(reinterpret_cast<byte_type*>(p)));
+		size_t cls = 0;
+
+		if (p == nullptr || !find_block(p, &cls))
+			return;
+
+		used_memory_ -= class_size(cls);
+		unused_memory_ += class_size(cls);
 
-		if (it != released_raw_ptr_.end())
+		push_free_block(p, cls);
+
+		if (unused_memory_.load(std::memory_order_relaxed) > MAX_POOL_SIZE)
 		{
-			it->second.reset();
+			ReleaseMemory();
 		}
-		ReleaseMemory();
 	}
 
-	inline void deallocate(std::shared_ptr<byte_type>& p, size_t size = 0)
+	template<typename TV>
+	inline void deallocate(std::shared_ptr<TV>& p, size_t = 0)
 	{
 		p.reset();
-		ReleaseMemory();
 	}
 
 	template<typename TV>
@@ -144,7 +282,8 @@ public:
 	{
 		return std::shared_ptr<TV>(
 				reinterpret_cast<TV*>(allocate(demand * sizeof(TV))),
-				deallocate_m);
+				[this](TV * p)
+				{	this->deallocate(p);});
 	}
 
 	inline std::shared_ptr<ByteType> allocate_byte_shared_ptr(size_t demand)
@@ -152,62 +291,270 @@ public:
 		return make_shared<ByteType>(demand);
 	}
 
+	/**
+	 *  the size which is actually reserved for a request of 'demand' bytes
+	 */
+	static size_t get_block_size(size_t demand)
+	{
+		return class_size(size_class(demand));
+	}
+
 private:
 
-	inline std::shared_ptr<byte_type> _allocate_shared_ptr(size_t demand)
+	//! \note size classes  : 64, then (5,6,7,8)*2^(k-2) for  2^k < n <= 2^(k+1)
+	static size_t size_class(size_t n)
 	{
-		std::shared_ptr<byte_type> res(nullptr);
+		if (n <= MIN_CLASS_SIZE)
+		{
+			return 0;
+		}
 
-		// find memory block which is not smaller than demand size
-		auto pt = pool_.lower_bound(demand);
+		size_t k = (sizeof(unsigned long) * 8 - 1)
+				- __builtin_clzl(static_cast<unsigned long>(n - 1));
 
-		for (auto & p : pool_)
+		size_t sub = ((n - 1) >> (k - 2)) & 3UL;
+
+		return 1 + (k - 6) * 4 + sub;
+	}
+
+	static size_t class_size(size_t cls)
+	{
+		if (cls == 0)
 		{
-			//release memory if block is free and size < ratio_ * demand
-			if (p.second.unique() && p.first < ratio_ * demand)
+			return MIN_CLASS_SIZE;
+		}
+		size_t k = 6 + (cls - 1) / 4;
+
+		size_t sub = (cls - 1) % 4;
+
+		return (sub + 5) << (k - 2);
+	}
+
+	static bool is_large_class(size_t cls)
+	{
+		return class_size(cls) >= LARGE_BLOCK_SIZE;
+	}
+
+	Shard & shard(void * p)
+	{
+		uintptr_t n = reinterpret_cast<uintptr_t>(p);
+
+		// blocks are 64 byte aligned, large blocks 2MB aligned
+		return shards_[((n >> 6) ^ (n >> 21)) % NUM_OF_SHARDS];
+	}
+
+	/**
+	 * @param cls  class of 'p', if 'p' is allocated by this pool
+	 * @return  'p' is allocated by this pool
+	 */
+	bool find_block(void * p, size_t * cls)
+	{
+		Shard & s = shard(p);
+
+		std::lock_guard<std::mutex> guard(s.lock);
+
+		auto it = s.blocks.find(p);
+
+		if (it == s.blocks.end())
+		{
+			return false;
+		}
+
+		*cls = it->second;
+
+		return true;
+	}
+
+	void * acquire_block(size_t cls)
+	{
+		size_t size = class_size(cls);
+
+		void * p = nullptr;
+
+		if (is_large_class(cls))
+		{
+			if (posix_memalign(&p, LARGE_BLOCK_SIZE, size) != 0)
+			{
+				ERROR_BAD_ALLOC_MEMORY(size, std::bad_alloc());
+			}
+#ifdef MADV_HUGEPAGE
+			madvise(p, size, MADV_HUGEPAGE);
+#endif
+#ifdef USE_NUMA
+			if (placement_policy_ == PLACEMENT_INTERLEAVE
+					&& numa_available() != -1)
 			{
-				res = p.second;
-				break;
+				numa_interleave_memory(p, size, numa_all_nodes_ptr);
 			}
+#endif
+		}
+		else if (posix_memalign(&p, ALIGNMENT, size) != 0)
+		{
+			ERROR_BAD_ALLOC_MEMORY(size, std::bad_alloc());
 		}
 
-		// if there is no proper memory block available , allocate new memory block
-		if (res == nullptr)
+		Shard & s = shard(p);
+
+		std::lock_guard<std::mutex> guard(s.lock);
+
+		s.blocks[p] = cls;
+
+		return p;
+	}
+
+	void release_block(void * p, size_t cls)
+	{
+		unused_memory_ -= class_size(cls);
+
 		{
-			try
-			{
-				res = std::shared_ptr<byte_type>(new byte_type[demand]);
+			Shard & s = shard(p);
+
+			std::lock_guard<std::mutex> guard(s.lock);
+
+			s.blocks.erase(p);
+		}
+
+		free(p);
+	}
+
+	struct ThreadCache
+	{
+		MemoryPool * owner = nullptr;
 
-			} catch (std::bad_alloc const &error)
+		std::vector<void*> free_[NUM_OF_CLASSES];
+
+		~ThreadCache()
+		{
+			if (owner != nullptr)
 			{
-				ERROR_BAD_ALLOC_MEMORY(demand, error);
+				owner->drain_thread_cache();
 			}
+		}
+	};
+
+	static ThreadCache & local_cache()
+	{
+		static thread_local ThreadCache cache;
+		return cache;
+	}
 
-			// put new memory into pool
-			pool_.insert(std::make_pair(demand, res));
+	/**
+	 * @return thread cache of current thread, or nullptr if the cache
+	 *         belongs to another pool
+	 */
+	ThreadCache * thread_cache(size_t cls)
+	{
+		if (class_size(cls) > MAX_THREAD_CACHED_SIZE)
+		{
+			return nullptr;
+		}
+
+		ThreadCache & cache = local_cache();
+
+		if (cache.owner == nullptr)
+		{
+			cache.owner = this;
 		}
-		return res;
+
+		return (cache.owner == this) ? &cache : nullptr;
 	}
-	inline void ReleaseMemory()
+
+	void drain_thread_cache()
 	{
-		// the size of allocated memory
-		size_t total_size = get_memory_size();
+		ThreadCache & cache = local_cache();
 
-		auto it = pool_.begin();
+		if (cache.owner != this)
+		{
+			return;
+		}
 
-		// release free memory until total_size < MAX_POOL_SIZE or no free memory is avaible
-		while (total_size > MAX_POOL_SIZE && it != pool_.end())
+		for (size_t cls = 0; cls < NUM_OF_CLASSES; ++cls)
 		{
-			if (it->second.unique())
+			if (!cache.free_[cls].empty())
 			{
-				total_size -= it->first;
-				it = pool_.erase(it);
+				std::lock_guard<std::mutex> guard(class_lock_[cls]);
+
+				free_[cls].insert(free_[cls].end(), cache.free_[cls].begin(),
+						cache.free_[cls].end());
 			}
-			else
+			cache.free_[cls].clear();
+		}
+		cache.owner = nullptr;
+	}
+
+	void * pop_free_block(size_t cls)
+	{
+		void * p = nullptr;
+
+		ThreadCache * cache = thread_cache(cls);
+
+		if (cache != nullptr && !cache->free_[cls].empty())
+		{
+			p = cache->free_[cls].back();
+			cache->free_[cls].pop_back();
+		}
+		else
+		{
+			std::lock_guard<std::mutex> guard(class_lock_[cls]);
+
+			if (!free_[cls].empty())
 			{
-				++it;
+				p = free_[cls].back();
+				free_[cls].pop_back();
 			}
+		}
+		return p;
+	}
 
+	void push_free_block(void * p, size_t cls)
+	{
+		ThreadCache * cache = thread_cache(cls);
+
+		if (cache != nullptr)
+		{
+			auto & c = cache->free_[cls];
+
+			if (c.size() >= THREAD_CACHE_DEPTH)
+			{
+				// move half of the thread cache to the shared free list
+				std::lock_guard<std::mutex> guard(class_lock_[cls]);
+
+				free_[cls].insert(free_[cls].end(), c.begin() + c.size() / 2,
+						c.end());
+
+				c.resize(c.size() / 2);
+			}
+
+			c.push_back(p);
+		}
+		else
+		{
+			std::lock_guard<std::mutex> guard(class_lock_[cls]);
+
+			free_[cls].push_back(p);
+		}
+	}
+
+	/**
+	 *  release cached free blocks to system, from the largest class, until
+	 *  cached size < MAX_POOL_SIZE
+	 */
+	void ReleaseMemory()
+	{
+		for (size_t cls = NUM_OF_CLASSES; cls > 0
+				&& unused_memory_.load(std::memory_order_relaxed)
+						> MAX_POOL_SIZE; --cls)
+		{
+			std::vector<void*> buffer;
+			{
+				std::lock_guard<std::mutex> guard(class_lock_[cls - 1]);
+				buffer.swap(free_[cls - 1]);
+			}
+
+			for (auto p : buffer)
+			{
+				release_block(p, cls - 1);
+			}
 		}
 	}
 };
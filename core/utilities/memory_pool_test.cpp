@@ -0,0 +1,315 @@
+/**
+ * \file memory_pool_test.cpp
+ *
+ * \date    2014年10月21日  上午9:12:05
+ * \author salmon
+ */
+
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include "memory_pool.h"
+#include "../parallel/numa_placement.h"
+
+using namespace simpla;
+
+class TestMemoryPool: public testing::TestWithParam<size_t>
+{
+protected:
+	void SetUp()
+	{
+		demand = GetParam();
+	}
+public:
+	size_t demand;
+	MemoryPool pool;
+};
+
+TEST_P(TestMemoryPool, alignment)
+{
+	auto p = pool.allocate(demand);
+
+	EXPECT_EQ(0, reinterpret_cast<uintptr_t>(p) % 64);
+
+	if (demand >= 2UL * 1024UL * 1024UL)
+	{
+		EXPECT_EQ(0, reinterpret_cast<uintptr_t>(p) % (2UL * 1024UL * 1024UL));
+	}
+
+	EXPECT_GE(MemoryPool::get_block_size(demand), demand);
+
+	EXPECT_LT(MemoryPool::get_block_size(demand), demand * 2 + 64);
+
+	pool.deallocate(p);
+}
+
+TEST_P(TestMemoryPool, accounting)
+{
+	size_t block_size = MemoryPool::get_block_size(demand);
+
+	size_t unused = 0, used = 0;
+
+	auto p = pool.allocate(demand);
+
+	EXPECT_EQ(block_size, pool.get_memory_size(&unused, &used));
+	EXPECT_EQ(block_size, used);
+	EXPECT_EQ(0, unused);
+
+	pool.deallocate(p);
+
+	EXPECT_EQ(block_size, pool.get_memory_size(&unused, &used));
+	EXPECT_EQ(0, used);
+	EXPECT_EQ(block_size, unused);
+
+	// free block is reused
+	auto q = pool.allocate(demand);
+
+	EXPECT_EQ(p, q);
+	EXPECT_EQ(block_size, pool.get_memory_size(&unused, &used));
+	EXPECT_EQ(block_size, used);
+
+	pool.deallocate(q);
+}
+
+TEST_P(TestMemoryPool, shared_ptr)
+{
+	size_t unused = 0, used = 0;
+	{
+		auto p = pool.make_shared<double>(demand);
+
+		p.get()[demand - 1] = 1.0;
+
+		pool.get_memory_size(&unused, &used);
+
+		EXPECT_GE(used, demand * sizeof(double));
+	}
+
+	pool.get_memory_size(&unused, &used);
+
+	EXPECT_EQ(0, used);
+}
+
+TEST_P(TestMemoryPool, multi_thread)
+{
+	size_t num_of_threads = 4;
+
+	std::vector<std::thread> threads;
+
+	for (int n = 0; n < num_of_threads; ++n)
+	{
+		threads.emplace_back([&]()
+		{
+			std::vector<void*> buffer;
+
+			for(int i=0;i<64;++i)
+			{
+				buffer.push_back(pool.allocate(demand));
+			}
+			for(auto p:buffer)
+			{
+				pool.deallocate(p);
+			}
+		});
+	}
+	for (auto & t : threads)
+	{
+		t.join();
+	}
+
+	size_t unused = 0, used = 0;
+
+	pool.get_memory_size(&unused, &used);
+
+	EXPECT_EQ(0, used);
+	EXPECT_LE(unused, num_of_threads * 64 * MemoryPool::get_block_size(demand));
+}
+
+INSTANTIATE_TEST_CASE_P(SimPla, TestMemoryPool,
+		testing::Values(1UL, 64UL, 65UL, 1000UL, 100UL * 1024UL,
+				2UL * 1024UL * 1024UL, 3UL * 1024UL * 1024UL + 17UL));
+
+TEST(MemoryPoolPlacement, first_touch)
+{
+	MemoryPool pool;
+
+	size_t num = 4UL * 1024UL * 1024UL;
+
+	auto p = pool.make_shared<double>(num);
+
+	p.get()[num - 1] = 1.0;
+
+	first_touch(p.get(), num, 4);
+
+	for (size_t i = 0; i < num; i += 4096)
+	{
+		EXPECT_EQ(0.0, p.get()[i]);
+	}
+	EXPECT_EQ(0.0, p.get()[num - 1]);
+
+	auto count = page_placement(p.get(), num * sizeof(double));
+
+	if (!count.empty())
+	{
+		// every page is touched
+		EXPECT_EQ(0, count.back());
+	}
+}
+
+namespace simpla
+{
+/// every other element of [b,e), stored in reverse order
+struct ReversedDomain
+{
+	size_t b, e, num;
+
+	std::vector<size_t> cells;
+
+	ReversedDomain(size_t pb, size_t pe, size_t pnum) :
+			b(pb), e(pe), num(pnum)
+	{
+		for (size_t s = b; s < e; ++s)
+			cells.push_back(s);
+	}
+	std::vector<size_t>::const_iterator begin() const
+	{
+		return cells.begin();
+	}
+	std::vector<size_t>::const_iterator end() const
+	{
+		return cells.end();
+	}
+	size_t hash(size_t s) const
+	{
+		return num - 1 - 2 * s;
+	}
+};
+
+ReversedDomain split(ReversedDomain const & r, size_t num, size_t n)
+{
+	return ReversedDomain(r.b + ((r.e - r.b) * n) / num,
+			r.b + ((r.e - r.b) * (n + 1)) / num, r.num);
+}
+}  // namespace simpla
+
+TEST(MemoryPoolPlacement, first_touch_tiles)
+{
+	GLOBAL_COMM.set_num_of_threads(4);
+
+	MemoryPool pool;
+
+	size_t num = 1024UL * 1024UL;
+
+	auto p = pool.make_shared<double>(num);
+
+	for (size_t i = 0; i < num; ++i)
+	{
+		p.get()[i] = 1.0;
+	}
+
+	ReversedDomain domain(0, num / 2, num);
+
+	first_touch_tiles(p.get(), domain);
+
+	// elements of the domain are zero, others (ghosts) are not touched
+	size_t count = 0;
+
+	for (size_t i = 0; i < num; ++i)
+	{
+		if (p.get()[i] != (i % 2 == 1 ? 0.0 : 1.0))
+		{
+			++count;
+		}
+	}
+
+	EXPECT_EQ(0, count);
+
+	GLOBAL_COMM.set_num_of_threads(1);
+}
+
+TEST(MemoryPoolOwnership, foreign_pointer)
+{
+	MemoryPool pool;
+
+	auto p = pool.allocate(100);
+
+	size_t unused = 0, used = 0;
+
+	size_t total = pool.get_memory_size(&unused, &used);
+
+	// pointers not allocated by the pool are ignored, memory in front of
+	// them is not read
+	std::vector<double> v(16);
+
+	double d = 0;
+
+	pool.deallocate(&v[0]);
+	pool.deallocate(&v[1]);
+	pool.deallocate(&d);
+
+	EXPECT_EQ(total, pool.get_memory_size(&unused, &used));
+	EXPECT_EQ(MemoryPool::get_block_size(100), used);
+
+	// a pointer of another pool
+	MemoryPool other;
+
+	auto q = other.allocate(100);
+
+	pool.deallocate(q);
+
+	EXPECT_EQ(total, pool.get_memory_size());
+
+	other.deallocate(q);
+
+	pool.deallocate(p);
+
+	pool.get_memory_size(&unused, &used);
+
+	EXPECT_EQ(0, used);
+}
+
+TEST(MemoryPoolOwnership, retention_limit)
+{
+	MemoryPool pool;
+
+	size_t demand = 3UL * 1024UL * 1024UL;
+
+	size_t block_size = MemoryPool::get_block_size(demand);
+
+	pool.set_pool_size(block_size * 2);
+
+	EXPECT_EQ(block_size * 2, pool.get_pool_size());
+
+	std::vector<void*> buffer;
+
+	for (int i = 0; i < 8; ++i)
+	{
+		buffer.push_back(pool.allocate(demand));
+	}
+
+	for (auto p : buffer)
+	{
+		pool.deallocate(p);
+	}
+
+	size_t unused = 0, used = 0;
+
+	pool.get_memory_size(&unused, &used);
+
+	EXPECT_EQ(0, used);
+	EXPECT_LE(unused, block_size * 2);
+
+	pool.set_pool_size(0);
+
+	pool.get_memory_size(&unused, &used);
+
+	EXPECT_EQ(0, unused);
+
+	char arg0[] = "test", arg1[] = "--mempool_size", arg2[] = "16";
+
+	char * argv[] = { arg0, arg1, arg2 };
+
+	pool.init(3, argv);
+
+	EXPECT_EQ(16UL * 1024UL * 1024UL, pool.get_pool_size());
+}
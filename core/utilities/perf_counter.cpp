@@ -0,0 +1,331 @@
+/**
+ * \file perf_counter.cpp
+ *
+ * \date    2014年11月18日  上午10:12:36
+ * \author salmon
+ */
+
+#include "perf_counter.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+
+#ifdef __linux__
+#	include <linux/perf_event.h>
+#	include <sys/syscall.h>
+#	include <unistd.h>
+#endif
+
+#include "log.h"
+#include "parse_command_line.h"
+
+namespace simpla
+{
+
+#ifdef __linux__
+
+namespace _impl
+{
+
+/// default raw FP_OPS event of this CPU, 0 if unknown
+unsigned long default_fp_event()
+{
+	std::ifstream is("/proc/cpuinfo");
+
+	std::string line;
+
+	while (std::getline(is, line))
+	{
+		if (line.compare(0, 9, "vendor_id") != 0)
+			continue;
+
+		if (line.find("GenuineIntel") != std::string::npos)
+		{
+			return 0xffc7; // FP_ARITH_INST_RETIRED.*
+		}
+		else if (line.find("AuthenticAMD") != std::string::npos)
+		{
+			return 0xff03; // RETIRED_SSE_AVX_FLOPS
+		}
+		break;
+	}
+
+	return 0;
+}
+
+int perf_event_open(unsigned int type, unsigned long config)
+{
+	perf_event_attr attr;
+
+	std::memset(&attr, 0, sizeof(attr));
+
+	attr.size = sizeof(attr);
+	attr.type = type;
+	attr.config = config;
+	attr.disabled = 0;
+	attr.inherit = 0;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED
+			| PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+	// pid=0, cpu=-1 :  calling thread on any cpu
+	return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1,
+			0));
+}
+
+/// open all events on the calling thread, -1 for events not available
+std::array<int, PerfCounter::NUM_OF_EVENTS> perf_events_open(
+		unsigned long fp_event)
+{
+	std::array<int, PerfCounter::NUM_OF_EVENTS> fd;
+
+	fd.fill(-1);
+
+	fd[PerfCounter::CYCLES] = perf_event_open(PERF_TYPE_HARDWARE,
+			PERF_COUNT_HW_CPU_CYCLES);
+
+	fd[PerfCounter::INSTRUCTIONS] = perf_event_open(PERF_TYPE_HARDWARE,
+			PERF_COUNT_HW_INSTRUCTIONS);
+
+	fd[PerfCounter::LLC_MISSES] = perf_event_open(PERF_TYPE_HW_CACHE,
+			PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+					| (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+
+	if (fd[PerfCounter::LLC_MISSES] < 0)
+	{
+		fd[PerfCounter::LLC_MISSES] = perf_event_open(PERF_TYPE_HARDWARE,
+				PERF_COUNT_HW_CACHE_MISSES);
+	}
+
+	if (fp_event != 0)
+	{
+		fd[PerfCounter::FP_OPS] = perf_event_open(PERF_TYPE_RAW, fp_event);
+	}
+
+	return fd;
+}
+
+/// count of event 'fd' corrected for multiplexing, 0 if not available
+double perf_event_read(int fd)
+{
+	// value, time enabled, time running
+	std::uint64_t buffer[3] = { 0, 0, 0 };
+
+	if (fd < 0 || ::read(fd, buffer, sizeof(buffer)) < 0)
+	{
+		return 0;
+	}
+
+	double res = static_cast<double>(buffer[0]);
+
+	// the event was multiplexed with others, scale to the enabled time
+	if (buffer[2] > 0 && buffer[2] < buffer[1])
+	{
+		res *= static_cast<double>(buffer[1]) / static_cast<double>(buffer[2]);
+	}
+
+	return res;
+}
+
+}  // namespace _impl
+
+#endif
+
+PerfCounter::PerfCounter() :
+		num_of_available_(0), fp_event_(0), epoch_(0)
+{
+	fd_.fill(-1);
+}
+
+PerfCounter::~PerfCounter()
+{
+	close();
+}
+
+void PerfCounter::init(int argc, char** argv)
+{
+	bool is_enabled = false;
+
+	unsigned long fp_event = 0;
+
+	ParseCmdLine(argc, argv,
+
+	[&](std::string const & opt,std::string const & value)->int
+	{
+		if( opt=="perf_counters")
+		{
+			is_enabled=true;
+
+			if(value!="")
+			{
+				fp_event=std::stoul(value,nullptr,0);
+			}
+		}
+		return CONTINUE;
+	}
+
+	);
+
+	if (is_enabled)
+	{
+		open(fp_event);
+	}
+}
+
+bool PerfCounter::open(unsigned long fp_event)
+{
+	close();
+
+#ifdef __linux__
+
+	if (fp_event == 0)
+	{
+		fp_event = _impl::default_fp_event();
+	}
+
+	std::string error = "";
+
+	std::lock_guard<std::mutex> guard(mutex_);
+
+	fp_event_ = fp_event;
+
+	++epoch_;
+
+	fd_ = _impl::perf_events_open(fp_event_);
+
+	if (fd_[CYCLES] < 0)
+	{
+		error = std::strerror(errno);
+	}
+
+	std::string unavailable = "";
+
+	for (int n = 0; n < NUM_OF_EVENTS; ++n)
+	{
+		if (fd_[n] >= 0)
+		{
+			++num_of_available_;
+		}
+		else
+		{
+			unavailable += " " + name(n);
+		}
+	}
+
+	owner_ = std::this_thread::get_id();
+
+	if (num_of_available_ == 0)
+	{
+		WARNING << "Hardware performance counters are not available ("
+				<< error
+				<< "), check /proc/sys/kernel/perf_event_paranoid. Counters are disabled.";
+	}
+	else if (unavailable != "")
+	{
+		WARNING << "Performance counters are not available:" << unavailable;
+	}
+
+#else
+
+	WARNING << "Hardware performance counters need Linux perf_event_open. Counters are disabled.";
+
+#endif
+
+	return num_of_available_ > 0;
+}
+
+void PerfCounter::close()
+{
+	std::lock_guard<std::mutex> guard(mutex_);
+
+	worker_fd_.push_back(fd_);
+
+	for (auto & fds : worker_fd_)
+	{
+		for (auto fd : fds)
+		{
+#ifdef __linux__
+			if (fd >= 0)
+			{
+				::close(fd);
+			}
+#endif
+		}
+	}
+
+	worker_fd_.clear();
+
+	fd_.fill(-1);
+
+	num_of_available_ = 0;
+}
+
+void PerfCounter::attach_thread()
+{
+	static thread_local size_t attached_epoch = 0;
+
+	std::lock_guard<std::mutex> guard(mutex_);
+
+	if (num_of_available_ == 0 || attached_epoch == epoch_
+			|| std::this_thread::get_id() == owner_)
+	{
+		return;
+	}
+
+	attached_epoch = epoch_;
+
+#ifdef __linux__
+
+	auto fd = _impl::perf_events_open(fp_event_);
+
+	// only events of the owner thread are counted
+	for (int n = 0; n < NUM_OF_EVENTS; ++n)
+	{
+		if (fd_[n] < 0 && fd[n] >= 0)
+		{
+			::close(fd[n]);
+			fd[n] = -1;
+		}
+	}
+
+	worker_fd_.push_back(fd);
+
+#endif
+}
+
+PerfCounter::value_type PerfCounter::read() const
+{
+	value_type res;
+
+	res.fill(0);
+
+#ifdef __linux__
+
+	std::lock_guard<std::mutex> guard(mutex_);
+
+	for (int n = 0; n < NUM_OF_EVENTS; ++n)
+	{
+		res[n] = _impl::perf_event_read(fd_[n]);
+
+		for (auto const & fd : worker_fd_)
+		{
+			res[n] += _impl::perf_event_read(fd[n]);
+		}
+	}
+#endif
+
+	return res;
+}
+
+std::string PerfCounter::name(int n)
+{
+	static const char * names[NUM_OF_EVENTS] = { "cycles", "instructions",
+			"llc_misses", "fp_ops" };
+
+	return names[n];
+}
+
+}  // namespace simpla
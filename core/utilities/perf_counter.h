@@ -0,0 +1,122 @@
+/**
+ * \file perf_counter.h
+ *
+ * \date    2014年11月18日  上午10:12:36
+ * \author salmon
+ */
+
+#ifndef PERF_COUNTER_H_
+#define PERF_COUNTER_H_
+
+#include <array>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "singleton_holder.h"
+
+namespace simpla
+{
+
+/**
+ *  \ingroup Logging
+ *  \brief hardware performance counters of the main thread (Linux perf_event_open)
+ *
+ *   Enabled by command line option --perf_counters [raw FP event], e.g.
+ *   "--perf_counters" or "--perf_counters 0x1fc7".  When enabled, every
+ *   ScopedTimer (PROFILE_SCOPE) of the thread that opened the
+ *   counters adds the counts of its scope to Profiler::Record::counters.
+ *
+ *   - CYCLES        : core cycles
+ *   - INSTRUCTIONS  : retired instructions
+ *   - LLC_MISSES    : last level cache read misses,  x 64 byte ~ memory traffic
+ *   - FP_OPS        : retired floating point instructions, a raw event, the
+ *                     default is FP_ARITH_INST_RETIRED.* (0xffc7, Intel
+ *                     Broadwell and later) or RETIRED_SSE_AVX_FLOPS (0xff03,
+ *                     AMD Zen); it is not available on other CPUs unless
+ *                     the raw event is given.
+ *
+ *   Workers of THREAD_POOL attach their own counters (attach_thread) before
+ *   they run tasks, read() adds their counts, so the tiles of parallel_for
+ *   are counted in the enclosing scope of the owner thread. Other threads are
+ *   not counted.
+ *
+ *   Counters are counted in user space only.  If an event can not be opened
+ *   (no PMU, perf_event_paranoid, seccomp, ...) it is unavailable and reads
+ *   as 0, if no event is available the counters are disabled,  one WARNING
+ *   is written in both cases and the simulation is not affected.
+ */
+class PerfCounter
+{
+public:
+
+	enum
+	{
+		CYCLES, INSTRUCTIONS, LLC_MISSES, FP_OPS, NUM_OF_EVENTS
+	};
+
+	typedef std::array<double, NUM_OF_EVENTS> value_type;
+
+	PerfCounter();
+
+	~PerfCounter();
+
+	void init(int argc, char** argv);
+
+	/**
+	 *  open counters on current thread
+	 * @param fp_event raw config of FP_OPS, 0 for the default of the CPU
+	 * @return is_enabled()
+	 */
+	bool open(unsigned long fp_event = 0);
+
+	void close();
+
+	/**
+	 *  open counters of the calling thread, whose counts are added to read().
+	 *  Nothing is done if counters are closed or the thread is attached.
+	 */
+	void attach_thread();
+
+	/// counters are open and current thread is the thread that opened them
+	bool is_enabled() const
+	{
+		return num_of_available_ > 0 && std::this_thread::get_id() == owner_;
+	}
+
+	bool is_available(int n) const
+	{
+		return fd_[n] >= 0;
+	}
+
+	/// counts since open() of all attached threads,  corrected for multiplexing
+	value_type read() const;
+
+	static std::string name(int n);
+
+private:
+
+	typedef std::array<int, NUM_OF_EVENTS> fd_type;
+
+	fd_type fd_;
+
+	int num_of_available_;
+
+	unsigned long fp_event_;
+
+	/// incremented by open(), threads attached to an older one attach again
+	size_t epoch_;
+
+	std::vector<fd_type> worker_fd_;
+
+	mutable std::mutex mutex_;
+
+	std::thread::id owner_;
+};
+
+#define PERF_COUNTER SingletonHolder<PerfCounter>::instance()
+
+}  // namespace simpla
+
+#endif /* PERF_COUNTER_H_ */
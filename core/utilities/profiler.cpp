@@ -0,0 +1,368 @@
+/**
+ * \file profiler.cpp
+ *
+ * \date    2014年11月6日  上午9:05:47
+ * \author salmon
+ */
+
+#include "profiler.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <vector>
+
+#include "log.h"
+#include "parse_command_line.h"
+#include "../parallel/message_comm.h"
+
+namespace simpla
+{
+
+/// path of the current timer of this thread
+static thread_local std::string profiler_path_;
+
+Profiler::Profiler() :
+		step_count_(0)
+{
+}
+
+Profiler::~Profiler()
+{
+	fs_.close();
+}
+
+void Profiler::init(int argc, char** argv)
+{
+	ParseCmdLine(argc, argv,
+
+	[&,this](std::string const & opt,std::string const & value)->int
+	{
+		if( opt=="profile")
+		{
+			this->open_file (value);
+		}
+		return CONTINUE;
+	}
+
+	);
+}
+
+void Profiler::open_file(std::string const & name)
+{
+	if (fs_.is_open())
+		fs_.close();
+
+	std::string fname = name;
+
+	if (GLOBAL_COMM.get_size() > 1)
+	{
+		fname += "." + ToString(GLOBAL_COMM.get_rank());
+	}
+
+	fs_.open(fname.c_str(), std::ios_base::trunc);
+
+	fs_ << "# step \t seconds \t path" << std::endl;
+}
+
+size_t Profiler::push(std::string const & name)
+{
+	size_t res = profiler_path_.size();
+
+	if (res > 0)
+	{
+		profiler_path_ += "/";
+	}
+
+	profiler_path_ += name;
+
+	return res;
+}
+
+void Profiler::pop(size_t prev_length, double seconds,
+		PerfCounter::value_type const * counters)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		auto & r = records_[profiler_path_];
+
+		r.min = (r.count == 0) ? seconds : std::min(r.min, seconds);
+		r.max = std::max(r.max, seconds);
+		r.total += seconds;
+		r.step += seconds;
+		++r.count;
+
+		if (counters != nullptr)
+		{
+			for (int n = 0; n < PerfCounter::NUM_OF_EVENTS; ++n)
+			{
+				r.counters[n] += (*counters)[n];
+			}
+		}
+	}
+
+	profiler_path_.resize(prev_length);
+}
+
+void Profiler::end_step()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	for (auto & item : records_)
+	{
+		if (fs_.is_open() && item.second.step > 0)
+		{
+			fs_ << step_count_ << "\t" << item.second.step << "\t" << item.first
+					<< '\n';
+		}
+		item.second.step = 0;
+	}
+
+	// one flush per step
+	if (fs_.is_open())
+	{
+		fs_.flush();
+	}
+
+	++step_count_;
+}
+
+void Profiler::clear()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	records_.clear();
+
+	step_count_ = 0;
+}
+
+std::vector<std::string> Profiler::paths() const
+{
+	std::vector<std::string> names;
+
+	for (auto const & item : records_)
+	{
+		names.push_back(item.first);
+	}
+
+	// paths of rank 0 are reported, so every rank reduces the same list
+	if (GLOBAL_COMM.is_ready() && GLOBAL_COMM.get_size() > 1)
+	{
+		std::string buffer;
+
+		for (auto const & n : names)
+		{
+			buffer += n + "\n";
+		}
+
+		int length = buffer.size();
+
+		MPI_Bcast(&length, 1, MPI_INT, 0, GLOBAL_COMM.comm());
+
+		buffer.resize(length);
+
+		MPI_Bcast(&buffer[0], length, MPI_CHAR, 0, GLOBAL_COMM.comm());
+
+		names.clear();
+
+		std::istringstream is(buffer);
+
+		std::string line;
+
+		while (std::getline(is, line))
+		{
+			names.push_back(line);
+		}
+	}
+
+	return std::move(names);
+}
+
+void Profiler::report(std::ostream & os)
+{
+	std::vector<std::string> names = paths();
+
+	int rank = GLOBAL_COMM.get_rank();
+
+	int size = GLOBAL_COMM.get_size();
+
+	bool is_parallel = GLOBAL_COMM.is_ready() && size > 1;
+
+	int num = names.size();
+
+	std::vector<double> local(num, 0), t_min(num, 0), t_max(num, 0), t_sum(
+			num, 0);
+
+	std::vector<long> count(num, 0);
+
+	for (int i = 0; i < num; ++i)
+	{
+		auto it = records_.find(names[i]);
+
+		if (it != records_.end())
+		{
+			local[i] = it->second.total;
+			count[i] = it->second.count;
+		}
+	}
+
+	if (is_parallel && num > 0)
+	{
+		MPI_Reduce(&local[0], &t_min[0], num, MPI_DOUBLE, MPI_MIN, 0,
+				GLOBAL_COMM.comm());
+		MPI_Reduce(&local[0], &t_max[0], num, MPI_DOUBLE, MPI_MAX, 0,
+				GLOBAL_COMM.comm());
+		MPI_Reduce(&local[0], &t_sum[0], num, MPI_DOUBLE, MPI_SUM, 0,
+				GLOBAL_COMM.comm());
+	}
+	else
+	{
+		t_min = local;
+		t_max = local;
+		t_sum = local;
+	}
+
+	if (rank != 0)
+	{
+		return;
+	}
+
+	os << std::setw(12) << "calls" << std::setw(14) << "min[s]"
+			<< std::setw(14) << "avg[s]" << std::setw(14) << "max[s]" << "  "
+			<< "timer" << std::endl;
+
+	for (int i = 0; i < num; ++i)
+	{
+		auto depth = std::count(names[i].begin(), names[i].end(), '/');
+
+		auto pos = names[i].rfind('/');
+
+		os << std::setw(12) << count[i] << std::setw(14) << t_min[i]
+				<< std::setw(14) << t_sum[i] / size << std::setw(14)
+				<< t_max[i] << "  " << std::string(depth * 2, ' ')
+				<< ((pos == std::string::npos) ?
+						names[i] : names[i].substr(pos + 1)) << std::endl;
+	}
+}
+
+void Profiler::report_counters(std::ostream & os)
+{
+	std::vector<std::string> names = paths();
+
+	int rank = GLOBAL_COMM.get_rank();
+
+	bool is_parallel = GLOBAL_COMM.is_ready() && GLOBAL_COMM.get_size() > 1;
+
+	const int num_of_events = PerfCounter::NUM_OF_EVENTS;
+
+	int num = names.size();
+
+	// counters are summed over ranks, time is the max over ranks
+	std::vector<double> local(num * num_of_events, 0), sum(
+			num * num_of_events, 0), t_local(num, 0), t_max(num, 0);
+
+	for (int i = 0; i < num; ++i)
+	{
+		auto it = records_.find(names[i]);
+
+		if (it != records_.end())
+		{
+			t_local[i] = it->second.total;
+
+			for (int n = 0; n < num_of_events; ++n)
+			{
+				local[i * num_of_events + n] = it->second.counters[n];
+			}
+		}
+	}
+
+	std::vector<int> available(num_of_events), all_available(num_of_events);
+
+	for (int n = 0; n < num_of_events; ++n)
+	{
+		available[n] = PERF_COUNTER.is_available(n) ? 1 : 0;
+	}
+
+	if (is_parallel && num > 0)
+	{
+		MPI_Reduce(&local[0], &sum[0], num * num_of_events, MPI_DOUBLE, MPI_SUM,
+				0, GLOBAL_COMM.comm());
+		MPI_Reduce(&t_local[0], &t_max[0], num, MPI_DOUBLE, MPI_MAX, 0,
+				GLOBAL_COMM.comm());
+		MPI_Reduce(&available[0], &all_available[0], num_of_events, MPI_INT,
+				MPI_MIN, 0, GLOBAL_COMM.comm());
+	}
+	else
+	{
+		sum = local;
+		t_max = t_local;
+		all_available = available;
+	}
+
+	if (rank != 0)
+	{
+		return;
+	}
+
+	auto value = [&](int i,int n)->double
+	{
+		return all_available[n]>0 ? sum[i * num_of_events + n]:-1;
+	};
+
+	// "-" if the counter is unavailable on any rank
+	auto column = [&](double v)->std::string
+	{
+		std::ostringstream s;
+
+		if(v<0)
+		{
+			s<<"-";
+		}
+		else
+		{
+			s<<std::setprecision(4)<<v;
+		}
+		return s.str();
+	};
+
+	os << std::setw(12) << "cycles" << std::setw(12) << "instr"
+			<< std::setw(8) << "IPC" << std::setw(12) << "LLC miss"
+			<< std::setw(12) << "GB/s" << std::setw(12) << "FP ops"
+			<< std::setw(12) << "FP/cycle" << "  " << "timer" << std::endl;
+
+	for (int i = 0; i < num; ++i)
+	{
+		double cycles = value(i, PerfCounter::CYCLES);
+		double instructions = value(i, PerfCounter::INSTRUCTIONS);
+		double llc_misses = value(i, PerfCounter::LLC_MISSES);
+		double fp_ops = value(i, PerfCounter::FP_OPS);
+
+		if (cycles <= 0 && instructions <= 0 && llc_misses <= 0)
+		{
+			continue;
+		}
+
+		// memory traffic is estimated as one 64 byte cache line per LLC miss
+		double bandwidth =
+				(llc_misses < 0 || t_max[i] <= 0) ?
+						-1 : llc_misses * 64 / t_max[i] * 1.0e-9;
+
+		auto depth = std::count(names[i].begin(), names[i].end(), '/');
+
+		auto pos = names[i].rfind('/');
+
+		os << std::setw(12) << column(cycles) << std::setw(12)
+				<< column(instructions) << std::setw(8)
+				<< column(
+						(cycles > 0 && instructions >= 0) ?
+								instructions / cycles : -1) << std::setw(12)
+				<< column(llc_misses) << std::setw(12) << column(bandwidth)
+				<< std::setw(12) << column(fp_ops) << std::setw(12)
+				<< column((cycles > 0 && fp_ops >= 0) ? fp_ops / cycles : -1)
+				<< "  " << std::string(depth * 2, ' ')
+				<< ((pos == std::string::npos) ?
+						names[i] : names[i].substr(pos + 1)) << std::endl;
+	}
+}
+
+}  // namespace simpla
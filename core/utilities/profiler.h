@@ -0,0 +1,163 @@
+/**
+ * \file profiler.h
+ *
+ * \date    2014年11月6日  上午9:05:47
+ * \author salmon
+ */
+
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "perf_counter.h"
+#include "singleton_holder.h"
+
+namespace simpla
+{
+
+/**
+ *  \ingroup Logging
+ *  \brief hierarchical wall clock profiler
+ *
+ *   Timers are identified by their path, i.e. "next_timestep/field", the
+ *   path of a ScopedTimer is the path of the enclosing timer of the same
+ *   thread plus its own name. Only PROFILE_SCOPE opens a timer, LOG_CMD
+ *   and its variants are not timed.
+ *
+ *   - end_step() appends the time spent in each path during the step to the
+ *     profile file (enabled by command line option --profile <file>)
+ *   - report() is collective, it writes  min/avg/max over all ranks
+ *   - report_counters() is collective, it writes the hardware counters of
+ *     each path (PerfCounter, enabled by --perf_counters) summed over ranks
+ */
+class Profiler
+{
+public:
+
+	struct Record
+	{
+		size_t count = 0;
+		double total = 0;
+		double min = 0;
+		double max = 0;
+		double step = 0; //!< time spent in current step
+
+		PerfCounter::value_type counters = PerfCounter::value_type(); //!< total counts
+	};
+
+	Profiler();
+
+	~Profiler();
+
+	void init(int argc, char** argv);
+
+	void open_file(std::string const & name);
+
+	/**
+	 *  enter timer 'name' on current thread
+	 *  \return length of path before entering
+	 */
+	size_t push(std::string const & name);
+
+	/**
+	 *  leave current timer, which lasted 'seconds'
+	 * @param counters  counts of the hardware counters in the timer, if
+	 *                  they are enabled
+	 */
+	void pop(size_t prev_length, double seconds,
+			PerfCounter::value_type const * counters = nullptr);
+
+	void end_step();
+
+	void report(std::ostream & os);
+
+	void report_counters(std::ostream & os);
+
+	/// collective, paths of rank 0
+	std::vector<std::string> paths() const;
+
+	void clear();
+
+	std::map<std::string, Record> const & records() const
+	{
+		return records_;
+	}
+
+private:
+	std::mutex mutex_;
+
+	std::map<std::string, Record> records_;
+
+	std::ofstream fs_;
+
+	size_t step_count_;
+};
+
+#define PROFILER SingletonHolder<Profiler>::instance()
+
+/**
+ *  \ingroup Logging
+ *  \brief  time the enclosing scope
+ */
+class ScopedTimer
+{
+	size_t prev_length_;
+
+	bool has_counters_;
+
+	PerfCounter::value_type counters_;
+
+	std::chrono::high_resolution_clock::time_point start_;
+
+public:
+	ScopedTimer(std::string const & name) :
+			prev_length_(PROFILER.push(name)), has_counters_(
+					PERF_COUNTER.is_enabled())
+	{
+		if (has_counters_)
+		{
+			counters_ = PERF_COUNTER.read();
+		}
+
+		start_ = std::chrono::high_resolution_clock::now();
+	}
+
+	~ScopedTimer()
+	{
+		double seconds = std::chrono::duration<double>(
+				std::chrono::high_resolution_clock::now() - start_).count();
+
+		if (has_counters_)
+		{
+			auto counters = PERF_COUNTER.read();
+
+			for (int n = 0; n < PerfCounter::NUM_OF_EVENTS; ++n)
+			{
+				counters[n] -= counters_[n];
+			}
+
+			PROFILER.pop(prev_length_, seconds, &counters);
+		}
+		else
+		{
+			PROFILER.pop(prev_length_, seconds);
+		}
+	}
+};
+
+#define PROFILE_SCOPE_CAT_(_A_,_B_) _A_##_B_
+
+#define PROFILE_SCOPE_NAME_(_L_) PROFILE_SCOPE_CAT_(__scoped_timer_,_L_)
+
+#define PROFILE_SCOPE(_NAME_) ScopedTimer PROFILE_SCOPE_NAME_(__LINE__)(_NAME_)
+
+}  // namespace simpla
+
+#endif /* PROFILER_H_ */
@@ -0,0 +1,156 @@
+/**
+ * \file profiler_test.cpp
+ *
+ * \date    2014年11月6日  上午11:20:03
+ * \author salmon
+ */
+
+#include <gtest/gtest.h>
+#include <sstream>
+#include <thread>
+#include "log.h"
+#include "profiler.h"
+
+using namespace simpla;
+
+TEST(Profiler, hierarchy)
+{
+	PROFILER.clear();
+
+	for (int i = 0; i < 3; ++i)
+	{
+		{
+			PROFILE_SCOPE("step");
+			{
+				PROFILE_SCOPE("push");
+
+				std::this_thread::sleep_for(std::chrono::milliseconds(2));
+			}
+
+			int a = 0;
+
+			LOG_CMD(a = 5);
+
+			EXPECT_EQ(5, a);
+		}
+		PROFILER.end_step();
+	}
+
+	auto const & r = PROFILER.records();
+
+	ASSERT_EQ(1, r.count("step"));
+	ASSERT_EQ(1, r.count("step/push"));
+
+	// LOG_CMD is not timed
+	EXPECT_EQ(0, r.count("step/a = 5"));
+
+	EXPECT_EQ(3, r.at("step/push").count);
+	EXPECT_GE(r.at("step/push").min, 0.002);
+	EXPECT_GE(r.at("step").total, r.at("step/push").total);
+	EXPECT_EQ(0, r.at("step").step);
+
+	std::ostringstream os;
+
+	PROFILER.report(os);
+
+	EXPECT_NE(std::string::npos, os.str().find("push"));
+}
+
+TEST(Profiler, perf_counters)
+{
+	PROFILER.clear();
+
+	// counters may be unavailable (no PMU, perf_event_paranoid), timers
+	// must work in both cases
+	bool is_enabled = PERF_COUNTER.open();
+
+	EXPECT_EQ(is_enabled, PERF_COUNTER.is_enabled());
+
+	double sum = 0;
+
+	{
+		PROFILE_SCOPE("step");
+
+		for (int i = 0; i < 1000000; ++i)
+		{
+			sum += 1.0 / (1.0 + i);
+		}
+	}
+
+	EXPECT_GT(sum, 0);
+
+	auto const & r = PROFILER.records();
+
+	ASSERT_EQ(1, r.count("step"));
+
+	EXPECT_EQ(1, r.at("step").count);
+
+	for (int n = 0; n < PerfCounter::NUM_OF_EVENTS; ++n)
+	{
+		if (!PERF_COUNTER.is_available(n))
+		{
+			EXPECT_EQ(0, r.at("step").counters[n]);
+		}
+	}
+
+	if (PERF_COUNTER.is_available(PerfCounter::INSTRUCTIONS))
+	{
+		EXPECT_GT(r.at("step").counters[PerfCounter::INSTRUCTIONS], 1000000);
+	}
+
+	// other threads do not read the counters of the main thread
+	std::thread([]()
+	{
+		EXPECT_FALSE(PERF_COUNTER.is_enabled());
+	}).join();
+
+	std::ostringstream os;
+
+	PROFILER.report_counters(os);
+
+	if (is_enabled)
+	{
+		EXPECT_NE(std::string::npos, os.str().find("step"));
+	}
+
+	PERF_COUNTER.close();
+
+	EXPECT_FALSE(PERF_COUNTER.is_enabled());
+}
+
+TEST(Profiler, perf_counters_attach_thread)
+{
+	PERF_COUNTER.open();
+
+	auto before = PERF_COUNTER.read();
+
+	volatile double sum = 0;
+
+	// e.g. a worker of THREAD_POOL,  its counts are added to read()
+	std::thread([&]()
+	{
+		PERF_COUNTER.attach_thread();
+
+		for (int i = 0; i < 10000000; ++i)
+		{
+			sum += 1.0 / (1.0 + i);
+		}
+	}).join();
+
+	auto after = PERF_COUNTER.read();
+
+	if (PERF_COUNTER.is_available(PerfCounter::INSTRUCTIONS))
+	{
+		EXPECT_GT(after[PerfCounter::INSTRUCTIONS] - before[PerfCounter::INSTRUCTIONS], 10000000);
+	}
+
+	PERF_COUNTER.close();
+
+	// closed counters are not attached
+	std::thread([]()
+	{
+		PERF_COUNTER.attach_thread();
+	}).join();
+
+	EXPECT_EQ(0, PERF_COUNTER.read()[PerfCounter::INSTRUCTIONS]);
+}
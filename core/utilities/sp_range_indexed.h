@@ -0,0 +1,261 @@
+/**
+ * \file sp_range_indexed.h
+ *
+ * \date    2014年11月5日  上午9:31:02
+ * \author salmon
+ */
+
+#ifndef CORE_UTILITIES_SP_RANGE_INDEXED_H_
+#define CORE_UTILITIES_SP_RANGE_INDEXED_H_
+
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace simpla
+{
+
+template<typename ...> struct IndexedRange;
+
+/**
+ *  \brief  materialized selection, sorted list of unique indices
+ *
+ *   The index list is shared by copies and sub-ranges, so copy is O(1) and
+ *   split is O(log n). Iteration is a linear sweep of a contiguous array,
+ *   the predicate of the original (filtered) range is evaluated only once
+ *   in make_indexed_range.
+ *
+ *   Indices with the same 'slab' (index >> shift) form one layer of cells,
+ *   i.e. shift is the bit offset of the slowest axis of a compact index.
+ *   split(r,num,n) cuts the range into slabs of the same number of layers,
+ *   as split of the mesh ranges, so the range can be swept by
+ *   parallel_for_colored (ContainerPool::modify_*, KineticParticle::constrain).
+ */
+template<typename TI>
+struct IndexedRange<TI>
+{
+	typedef TI value_type;
+
+	typedef IndexedRange<value_type> this_type;
+
+	typedef std::vector<value_type> container_type;
+
+	typedef typename container_type::const_iterator iterator;
+
+	typedef iterator const_iterator;
+
+private:
+	std::shared_ptr<container_type> data_;
+
+	size_t b_, e_;
+
+	unsigned int shift_;
+
+public:
+
+	IndexedRange() :
+			data_(new container_type), b_(0), e_(0), shift_(0)
+	{
+	}
+
+	/// 'idx' must be sorted and unique
+	IndexedRange(container_type && idx, unsigned int shift = 0) :
+			data_(new container_type(std::move(idx))), b_(0), e_(data_->size()), shift_(
+					shift)
+	{
+	}
+
+	IndexedRange(this_type const & other, size_t b, size_t e) :
+			data_(other.data_), b_(other.b_ + b), e_(other.b_ + e), shift_(
+					other.shift_)
+	{
+	}
+
+	IndexedRange(this_type const & other) :
+			data_(other.data_), b_(other.b_), e_(other.e_), shift_(other.shift_)
+	{
+	}
+
+	~IndexedRange()
+	{
+	}
+
+	this_type & operator=(this_type const & other)
+	{
+		data_ = other.data_;
+		b_ = other.b_;
+		e_ = other.e_;
+		shift_ = other.shift_;
+		return *this;
+	}
+
+	const_iterator begin() const
+	{
+		return data_->begin() + b_;
+	}
+
+	const_iterator end() const
+	{
+		return data_->begin() + e_;
+	}
+
+	size_t size() const
+	{
+		return e_ - b_;
+	}
+
+	bool empty() const
+	{
+		return e_ == b_;
+	}
+
+	value_type const & operator[](size_t n) const
+	{
+		return (*data_)[b_ + n];
+	}
+
+	bool contains(value_type const & s) const
+	{
+		return std::binary_search(begin(), end(), s);
+	}
+
+	unsigned int shift() const
+	{
+		return shift_;
+	}
+
+	/// layer of cells of 's'
+	value_type slab(value_type const & s) const
+	{
+		return s >> shift_;
+	}
+
+	/// position of the first index whose slab is not less than 'l'
+	size_t lower_bound_slab(value_type const & l) const
+	{
+		return std::lower_bound(begin(), end(), l,
+				[this](value_type const & s,value_type const & v)
+				{	return this->slab(s)<v;}) - begin();
+	}
+
+	/**
+	 *  contiguous runs, i.e. \f$ [s,s+stride,...,s+(count-1)*stride] \f$
+	 *  \return list of (first index, count)
+	 */
+	std::vector<std::pair<value_type, size_t>> runs(
+			value_type const & stride) const
+	{
+		std::vector<std::pair<value_type, size_t>> res;
+
+		for (auto it = begin(), ie = end(); it != ie; ++it)
+		{
+			if (!res.empty()
+					&& res.back().first
+							+ static_cast<value_type>(res.back().second)
+									* stride == *it)
+			{
+				++res.back().second;
+			}
+			else
+			{
+				res.emplace_back(*it, 1);
+			}
+		}
+		return std::move(res);
+	}
+};
+
+/**
+ *  evaluate 'range' once, return the selected indices
+ *  @param shift  bit offset of the slowest axis, see IndexedRange
+ */
+template<typename TR>
+auto make_indexed_range(TR const & range, unsigned int shift = 0)
+		->IndexedRange<typename std::remove_cv<typename std::remove_reference<decltype(*std::begin(range))>::type>::type>
+{
+	typedef typename std::remove_cv<
+			typename std::remove_reference<decltype(*std::begin(range))>::type>::type value_type;
+
+	std::vector<value_type> idx;
+
+	for (auto const & s : range)
+	{
+		idx.push_back(s);
+	}
+
+	std::sort(idx.begin(), idx.end());
+
+	idx.erase(std::unique(idx.begin(), idx.end()), idx.end());
+
+	return std::move(IndexedRange<value_type>(std::move(idx), shift));
+}
+
+/**
+ *  number of layers from the first to the last slab of 'r'
+ */
+template<typename TI>
+size_t split_extent(IndexedRange<TI> const & r)
+{
+	return r.empty() ?
+			0 : static_cast<size_t>(r.slab(r[r.size() - 1]) - r.slab(r[0]) + 1);
+}
+
+/**
+ *  part 'n' of 'num' parts, parts have the same number of layers, i.e.
+ *  part 'n' and 'n+2' are at least split_extent(r)/num layers apart
+ */
+template<typename TI>
+IndexedRange<TI> split(IndexedRange<TI> const & r, size_t num, size_t n)
+{
+	if (r.empty())
+	{
+		return r;
+	}
+
+	TI first = r.slab(r[0]);
+
+	size_t extent = split_extent(r);
+
+	size_t b = r.lower_bound_slab(first + static_cast<TI>((extent * n) / num));
+
+	size_t e = r.lower_bound_slab(
+			first + static_cast<TI>((extent * (n + 1)) / num));
+
+	return std::move(IndexedRange<TI>(r, b, e));
+}
+
+template<typename TI>
+std::tuple<IndexedRange<TI>, IndexedRange<TI>> split(
+		IndexedRange<TI> const & r)
+{
+	return std::make_tuple(split(r, 2, 0), split(r, 2, 1));
+}
+
+/// the recursive parallel_for of multi_thread.h stops splitting below 4096
+/// indices, parallel_for of parallel.h does not use it
+template<typename TI>
+bool is_divisible(IndexedRange<TI> const & r)
+{
+	return r.size() > 4096;
+}
+
+template<typename TI>
+IndexedRange<TI> intersection(IndexedRange<TI> const & l,
+		IndexedRange<TI> const & r)
+{
+	std::vector<TI> idx;
+
+	std::set_intersection(l.begin(), l.end(), r.begin(), r.end(),
+			std::back_inserter(idx));
+
+	return std::move(IndexedRange<TI>(std::move(idx), l.shift()));
+}
+
+}
+// namespace simpla
+
+#endif /* CORE_UTILITIES_SP_RANGE_INDEXED_H_ */
@@ -0,0 +1,142 @@
+/**
+ * \file sp_range_indexed_test.cpp
+ *
+ * \date    2014年11月5日  上午10:02:13
+ * \author salmon
+ */
+
+#include <gtest/gtest.h>
+#include <vector>
+#include "sp_range_indexed.h"
+
+using namespace simpla;
+
+TEST(IndexedRange, materialize)
+{
+	std::vector<long> v = { 7, 3, 3, 1, 10, 2, 9 };
+
+	auto r = make_indexed_range(v);
+
+	EXPECT_EQ(6, r.size());
+
+	std::vector<long> expect = { 1, 2, 3, 7, 9, 10 };
+
+	EXPECT_TRUE(std::equal(r.begin(), r.end(), expect.begin()));
+
+	EXPECT_TRUE(r.contains(7));
+	EXPECT_FALSE(r.contains(8));
+
+	auto runs = r.runs(1);
+
+	ASSERT_EQ(3, runs.size());
+	EXPECT_EQ(1, runs[0].first);
+	EXPECT_EQ(3, runs[0].second);
+	EXPECT_EQ(7, runs[1].first);
+	EXPECT_EQ(1, runs[1].second);
+	EXPECT_EQ(9, runs[2].first);
+	EXPECT_EQ(2, runs[2].second);
+}
+
+TEST(IndexedRange, split)
+{
+	std::vector<long> v;
+
+	for (long i = 0; i < 1000; ++i)
+	{
+		v.push_back(i * 3);
+	}
+
+	auto r = make_indexed_range(v);
+
+	size_t num = 7;
+
+	size_t count = 0;
+
+	long last = -1;
+
+	for (size_t n = 0; n < num; ++n)
+	{
+		auto sub = split(r, num, n);
+
+		EXPECT_LE(sub.size(), r.size() / num + 1);
+
+		for (auto s : sub)
+		{
+			EXPECT_GT(s, last);
+			last = s;
+			++count;
+		}
+	}
+
+	EXPECT_EQ(r.size(), count);
+}
+
+TEST(IndexedRange, intersection)
+{
+	std::vector<long> a = { 1, 2, 3, 4, 5, 6 };
+	std::vector<long> b = { 4, 5, 6, 7, 8 };
+
+	auto r = intersection(make_indexed_range(a), make_indexed_range(b));
+
+	std::vector<long> expect = { 4, 5, 6 };
+
+	ASSERT_EQ(3, r.size());
+	EXPECT_TRUE(std::equal(r.begin(), r.end(), expect.begin()));
+}
+
+/**
+ *  layers are index>>shift, slabs of split have the same number of layers
+ *  and slab n and n+2 are at least split_extent/num layers apart
+ */
+TEST(IndexedRange, split_extent)
+{
+	unsigned int shift = 8;
+
+	std::vector<long> v;
+
+	// layers 10..49, a sparse selection of each layer, layer 30 is empty
+	for (long l = 10; l < 50; ++l)
+	{
+		if (l == 30)
+		{
+			continue;
+		}
+		for (long i = 0; i < (l % 7) + 1; ++i)
+		{
+			v.push_back((l << shift) + i * 13);
+		}
+	}
+
+	auto r = make_indexed_range(v, shift);
+
+	EXPECT_EQ(shift, r.shift());
+	EXPECT_EQ(40, split_extent(r));
+	EXPECT_EQ(0, split_extent(IndexedRange<long>()));
+
+	size_t num = 6;
+
+	size_t count = 0;
+
+	std::vector<std::pair<long, long>> layers;
+
+	for (size_t n = 0; n < num; ++n)
+	{
+		auto sub = split(r, num, n);
+
+		ASSERT_FALSE(sub.empty());
+
+		EXPECT_LE(split_extent(sub), split_extent(r) / num + 1);
+
+		layers.emplace_back(sub.slab(sub[0]), sub.slab(sub[sub.size() - 1]));
+
+		count += sub.size();
+	}
+
+	EXPECT_EQ(r.size(), count);
+
+	for (size_t n = 0; n + 2 < num; ++n)
+	{
+		EXPECT_GT(layers[n + 2].first - layers[n].second,
+				static_cast<long>(split_extent(r) / num));
+	}
+}